@@ -0,0 +1,233 @@
+#include <string.h>
+#include <stdint.h>
+#include "bitonic-merge.h"
+
+#if defined(__GNUC__) && defined(__x86_64__)
+#define BITONIC_MERGE_AVX2 1
+#include <immintrin.h>
+#endif
+
+/*---------------------------------------------------------------------------------------------------------------*/
+
+// PURPOSE: The size of a pair, in bytes.
+#define PAIR_SIZE 8
+
+// PURPOSE: The number of pairs held by an AVX2 register.
+#define LANE_COUNT 4
+
+// PURPOSE: Maps the bits of a float to an integer with the same order (the sign bit is kept, the other bits of the
+//          negative floats are flipped). The mapping is its own inverse.
+#define FLOAT_BITS_TO_ORDERED(bits) ((bits) ^ ((uint32_t) ((int32_t) (bits) >> 31) & 0x7FFFFFFFU))
+
+/*---------------------------------------------------------------------------------------------------------------*/
+
+// PURPOSE: Returns the composite key of a pair: the (ordered) key in the high half, the payload in the low half.
+static int64_t get_composite_key(const unsigned char *pair, int is_float) {
+  uint32_t key, payload;
+
+  memcpy(&key, pair, sizeof(key));
+  memcpy(&payload, pair + sizeof(key), sizeof(payload));
+
+  if (is_float)
+    key = FLOAT_BITS_TO_ORDERED(key);
+
+  return (int64_t) (((uint64_t) key << 32) | payload);
+}
+
+/*---------------------------------------------------------------------------------------------------------------*/
+
+// PURPOSE: Merges three sorted runs of pairs into the destination array, one pair at a time.
+// NOTE: Equal composite keys are taken from the first run which holds them. The third run can be NULL if it is empty.
+static void merge_three_runs(const unsigned char *a, size_t a_count, const unsigned char *b, size_t b_count,
+                             const unsigned char *c, size_t c_count, unsigned char *dst, int is_float) {
+  const unsigned char *ends[3], **min_run;
+  const unsigned char *heads[3];
+  int64_t key, min_key;
+  size_t i;
+
+  heads[0] = a;
+  heads[1] = b;
+  heads[2] = c;
+  ends[0] = a + a_count * PAIR_SIZE;
+  ends[1] = b + b_count * PAIR_SIZE;
+  ends[2] = c_count ? c + c_count * PAIR_SIZE : c;
+
+  for (;;) {
+    min_run = NULL;
+    min_key = 0;
+
+    for (i = 0; i < 3; ++i) {
+      if (heads[i] == ends[i])
+        continue;
+
+      key = get_composite_key(heads[i], is_float);
+
+      if (!min_run || key < min_key) {
+        min_run = &heads[i];
+        min_key = key;
+      }
+    }
+
+    if (!min_run)
+      return;
+
+    memcpy(dst, *min_run, PAIR_SIZE);
+    dst += PAIR_SIZE;
+    *min_run += PAIR_SIZE;
+  }
+}
+
+/*---------------------------------------------------------------------------------------------------------------*/
+
+#if BITONIC_MERGE_AVX2
+
+// PURPOSE: Maps the bits of the float keys held in the high halves of the lanes to ordered integers (and back).
+__attribute__((target("avx2")))
+static __m256i map_float_keys(__m256i lanes) {
+  return _mm256_xor_si256(lanes, _mm256_and_si256(_mm256_srai_epi32(lanes, 31),
+                                                  _mm256_set1_epi64x((long long) 0x7FFFFFFF00000000ULL)));
+}
+
+// PURPOSE: Turns four pairs into their composite keys, swapping the halves of each 64-bit lane.
+__attribute__((target("avx2")))
+static __m256i load_composite_keys(const unsigned char *pairs, int is_float) {
+  __m256i lanes;
+
+  lanes = _mm256_shuffle_epi32(_mm256_loadu_si256((const __m256i *) pairs), 0xB1);
+  return is_float ? map_float_keys(lanes) : lanes;
+}
+
+// PURPOSE: Turns four composite keys back into pairs, and stores them.
+__attribute__((target("avx2")))
+static void store_composite_keys(unsigned char *pairs, __m256i lanes, int is_float) {
+  if (is_float)
+    lanes = map_float_keys(lanes);
+
+  _mm256_storeu_si256((__m256i *) pairs, _mm256_shuffle_epi32(lanes, 0xB1));
+}
+
+// PURPOSE: Stores the lanes of a and b holding the min and the max composite keys, respectively.
+__attribute__((target("avx2")))
+static void compare_exchange(__m256i *a, __m256i *b) {
+  __m256i greater, min;
+
+  greater = _mm256_cmpgt_epi64(*a, *b);
+  min = _mm256_blendv_epi8(*a, *b, greater);
+  *b = _mm256_blendv_epi8(*b, *a, greater);
+  *a = min;
+}
+
+// PURPOSE: Sorts the four lanes of a bitonic vector, comparing the lanes at distance 2, then at distance 1.
+__attribute__((target("avx2")))
+static __m256i sort_bitonic_lanes(__m256i v) {
+  __m256i low, high;
+
+  low = v;
+  high = _mm256_permute4x64_epi64(v, 0x4E);
+  compare_exchange(&low, &high);
+  v = _mm256_blend_epi32(low, high, 0xF0);
+
+  low = v;
+  high = _mm256_permute4x64_epi64(v, 0xB1);
+  compare_exchange(&low, &high);
+  return _mm256_blend_epi32(low, high, 0xCC);
+}
+
+// PURPOSE: Merges two sorted vectors: a receives the four lowest lanes, and b the four highest, both sorted.
+// NOTE: Reversing b makes the eight lanes a bitonic sequence, which the first compare-exchange splits into two
+//       bitonic halves.
+__attribute__((target("avx2")))
+static void merge_lanes(__m256i *a, __m256i *b) {
+  *b = _mm256_permute4x64_epi64(*b, 0x1B);
+  compare_exchange(a, b);
+  *a = sort_bitonic_lanes(*a);
+  *b = sort_bitonic_lanes(*b);
+}
+
+// PURPOSE: Merges two runs of pairs with the bitonic network, then merges the leftovers with scalar code.
+__attribute__((target("avx2")))
+static void merge_pairs_avx2(const unsigned char *left, size_t left_count, const unsigned char *right,
+                             size_t right_count, unsigned char *dst, int is_float) {
+  unsigned char highest[LANE_COUNT * PAIR_SIZE];
+  __m256i a, b;
+  size_t l, r;
+
+  if (left_count < LANE_COUNT || right_count < LANE_COUNT) {
+    merge_three_runs(left, left_count, right, right_count, NULL, 0, dst, is_float);
+    return;
+  }
+
+  a = load_composite_keys(left, is_float);
+  b = load_composite_keys(right, is_float);
+  l = r = LANE_COUNT;
+
+  for (;;) {
+    merge_lanes(&a, &b);
+    store_composite_keys(dst, a, is_float);
+    dst += LANE_COUNT * PAIR_SIZE;
+
+    // The next four pairs come from the run with the lowest head, so they cannot precede the stored ones.
+    if (l < left_count && (r == right_count || get_composite_key(left + l * PAIR_SIZE, is_float) <
+                                               get_composite_key(right + r * PAIR_SIZE, is_float))) {
+      if (left_count - l < LANE_COUNT)
+        break;
+
+      a = load_composite_keys(left + l * PAIR_SIZE, is_float);
+      l += LANE_COUNT;
+    } else if (r < right_count) {
+      if (right_count - r < LANE_COUNT)
+        break;
+
+      a = load_composite_keys(right + r * PAIR_SIZE, is_float);
+      r += LANE_COUNT;
+    } else {
+      break;
+    }
+  }
+
+  store_composite_keys(highest, b, is_float);
+  merge_three_runs(highest, LANE_COUNT, left + l * PAIR_SIZE, left_count - l, right + r * PAIR_SIZE,
+                   right_count - r, dst, is_float);
+}
+
+#endif
+
+/*---------------------------------------------------------------------------------------------------------------*/
+
+// PURPOSE: Merges two runs of pairs, with the bitonic network if the processor supports it.
+static void merge_pairs(const void *left, size_t left_count, const void *right, size_t right_count, void *dst,
+                        int is_float) {
+#if BITONIC_MERGE_AVX2
+  if (is_bitonic_merge_supported()) {
+    merge_pairs_avx2((const unsigned char *) left, left_count, (const unsigned char *) right, right_count,
+                     (unsigned char *) dst, is_float);
+    return;
+  }
+#endif
+
+  merge_three_runs((const unsigned char *) left, left_count, (const unsigned char *) right, right_count, NULL, 0,
+                   (unsigned char *) dst, is_float);
+}
+
+/*---------------------------------------------------------------------------------------------------------------*/
+
+int is_bitonic_merge_supported(void) {
+#if BITONIC_MERGE_AVX2
+  return __builtin_cpu_supports("avx2") ? 1 : 0;
+#else
+  return 0;
+#endif
+}
+
+/*---------------------------------------------------------------------------------------------------------------*/
+
+void bitonic_merge_int_pairs(const void *left, size_t left_count, const void *right, size_t right_count, void *dst) {
+  merge_pairs(left, left_count, right, right_count, dst, 0);
+}
+
+/*---------------------------------------------------------------------------------------------------------------*/
+
+void bitonic_merge_float_pairs(const void *left, size_t left_count, const void *right, size_t right_count,
+                               void *dst) {
+  merge_pairs(left, left_count, right, right_count, dst, 1);
+}
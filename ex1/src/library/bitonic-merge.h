@@ -0,0 +1,58 @@
+#pragma once
+
+#include <stddef.h>
+
+/**
+ * @brief Function pointer type for the merge of two sorted runs of 8-byte pairs into a destination array.
+ *
+ * @param left The first run.
+ * @param left_count The number of pairs of the first run.
+ * @param right The second run.
+ * @param right_count The number of pairs of the second run.
+ * @param dst The destination array, able to hold <code>left_count + right_count</code> pairs (it cannot overlap the
+ * runs).
+ */
+typedef void (*pair_merge_fn)(const void *left, size_t left_count, const void *right, size_t right_count, void *dst);
+
+/**
+ * @brief Returns whether the vectorized merges can run on this processor (which must support AVX2).
+ * @return 1 if the merges are vectorized, 0 if they fall back to a scalar merge.
+ */
+int is_bitonic_merge_supported(void);
+
+/**
+ * @brief Merges two runs of 8-byte pairs, made of a 32-bit integer key followed by a 32-bit payload, sorted by key
+ * then by payload.
+ *
+ * @remark The pairs are compared as 64-bit composite keys (the key in the high half, the payload in the low half), so
+ * that no two pairs compare equal when the payloads are distinct. Four pairs of each run are loaded into AVX2 registers
+ * and merged by a bitonic network of 8 lanes: the lowest four are stored, and the highest four are merged with the next
+ * four pairs of the run whose head is the lowest. The pairs left over by the network and the tails shorter than four
+ * pairs are merged by scalar code.
+ *
+ * @note When the payloads are the positions of the pairs (as the record indices of the key columns), ordering the
+ * equal keys by payload is the same as keeping their order, so the merges of a stable merge sort stay stable.
+ *
+ * @param left The first run.
+ * @param left_count The number of pairs of the first run.
+ * @param right The second run.
+ * @param right_count The number of pairs of the second run.
+ * @param dst The destination array, able to hold <code>left_count + right_count</code> pairs (it cannot overlap the
+ * runs).
+ */
+void bitonic_merge_int_pairs(const void *left, size_t left_count, const void *right, size_t right_count, void *dst);
+
+/**
+ * @brief Same as @c bitonic_merge_int_pairs, for pairs made of a float key followed by a 32-bit payload.
+ *
+ * @remark The bits of the float keys are mapped to integers with the same order, so negative zeros precede positive
+ * zeros, and NaNs are ordered by their bits.
+ *
+ * @param left The first run.
+ * @param left_count The number of pairs of the first run.
+ * @param right The second run.
+ * @param right_count The number of pairs of the second run.
+ * @param dst The destination array, able to hold <code>left_count + right_count</code> pairs (it cannot overlap the
+ * runs).
+ */
+void bitonic_merge_float_pairs(const void *left, size_t left_count, const void *right, size_t right_count, void *dst);
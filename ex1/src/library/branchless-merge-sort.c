@@ -0,0 +1,307 @@
+#define _DEFAULT_SOURCE
+
+#include <malloc.h>
+#include <string.h>
+#include <stdint.h>
+#include "branchless-merge-sort.h"
+#include "bitonic-merge.h"
+#include "assert_util.h"
+
+/*---------------------------------------------------------------------------------------------------------------*/
+
+// PURPOSE: Pairs a 32-bit integer key with a 32-bit payload (e.g. the index of a record).
+typedef struct IntPair {
+  int32_t key;
+  uint32_t payload;
+} IntPair;
+
+// PURPOSE: Pairs a float key with a 32-bit payload (e.g. the index of a record).
+typedef struct FloatPair {
+  float key;
+  uint32_t payload;
+} FloatPair;
+
+// PURPOSE: The orders of the sorted items: each one returns 1 if the item a must precede the item b, 0 otherwise.
+// NOTE: Equal items are not ordered, so that the merges (which take the item of the left run unless the item of the
+//       right run precedes it) are stable.
+#define PAIR_KEY_LESS(a, b) ((a)->key < (b)->key)
+#define RECORD_INT_LESS(a, b) ((a)->int_field < (b)->int_field)
+#define RECORD_FLOAT_LESS(a, b) ((a)->float_field < (b)->float_field)
+
+/*---------------------------------------------------------------------------------------------------------------*/
+
+// PURPOSE: Defines the insertion sort, the branchless merge and the bottom-up merge sort of an item type, ordered by
+//          the specified order. The runs are merged by vector_merge instead, if the sort is vectorized and it is not
+//          NULL.
+#define DEFINE_BRANCHLESS_MERGE_SORT(name, type, less, vector_merge)                                                \
+  static void name##_insertion_sort(type *base, size_t count) {                                                     \
+    type item;                                                                                                      \
+    size_t i, j;                                                                                                    \
+                                                                                                                    \
+    for (i = 1; i < count; ++i) {                                                                                   \
+      item = base[i];                                                                                               \
+                                                                                                                    \
+      for (j = i; j > 0 && less(&item, &base[j - 1]); --j)                                                          \
+        base[j] = base[j - 1];                                                                                      \
+                                                                                                                    \
+      base[j] = item;                                                                                               \
+    }                                                                                                               \
+  }                                                                                                                 \
+                                                                                                                    \
+  static void name##_merge(const type *left, const type *left_end, const type *right, const type *right_end,        \
+                           type *dst) {                                                                             \
+    size_t take_right;                                                                                              \
+                                                                                                                    \
+    while (left < left_end && right < right_end) {                                                                  \
+      take_right = (size_t) less(right, left);                                                                      \
+      *dst++ = *(take_right ? right : left);                                                                        \
+      right += take_right;                                                                                          \
+      left += 1 - take_right;                                                                                       \
+    }                                                                                                               \
+                                                                                                                    \
+    memcpy(dst, left, (size_t) (left_end - left) * sizeof(type));                                                   \
+    dst += left_end - left;                                                                                         \
+    memcpy(dst, right, (size_t) (right_end - right) * sizeof(type));                                                \
+  }                                                                                                                 \
+                                                                                                                    \
+  static void name(type *base, size_t count, size_t threshold, int vectorized) {                                    \
+    type *buffer, *src, *dst, *tmp;                                                                                 \
+    pair_merge_fn merge_fn;                                                                                         \
+    size_t width, begin, middle, end;                                                                               \
+                                                                                                                    \
+    threshold = threshold > 0 ? threshold : 1;                                                                      \
+                                                                                                                    \
+    for (begin = 0; begin < count; begin += threshold)                                                              \
+      name##_insertion_sort(base + begin, count - begin < threshold ? count - begin : threshold);                   \
+                                                                                                                    \
+    if (count <= threshold)                                                                                         \
+      return;                                                                                                       \
+                                                                                                                    \
+    buffer = (type *) malloc(sizeof(type) * count);                                                                 \
+    ASSERT(buffer, "Unable to allocate memory for the merging array", name);                                        \
+                                                                                                                    \
+    src = base;                                                                                                     \
+    dst = buffer;                                                                                                   \
+    merge_fn = NULL;                                                                                                \
+                                                                                                                    \
+    if (vectorized)                                                                                                 \
+      merge_fn = (vector_merge);                                                                                    \
+                                                                                                                    \
+    for (width = threshold; width < count; width *= 2) {                                                            \
+      for (begin = 0; begin < count; begin = end) {                                                                 \
+        middle = count - begin < width ? count : begin + width;                                                     \
+        end = count - middle < width ? count : middle + width;                                                      \
+        if (merge_fn)                                                                                               \
+          merge_fn(src + begin, middle - begin, src + middle, end - middle, dst + begin);                           \
+        else                                                                                                        \
+          name##_merge(src + begin, src + middle, src + middle, src + end, dst + begin);                            \
+      }                                                                                                             \
+                                                                                                                    \
+      tmp = src;                                                                                                    \
+      src = dst;                                                                                                    \
+      dst = tmp;                                                                                                    \
+    }                                                                                                               \
+                                                                                                                    \
+    if (src != base)                                                                                                \
+      memcpy(base, src, sizeof(type) * count);                                                                      \
+                                                                                                                    \
+    free(buffer);                                                                                                   \
+  }
+
+// PURPOSE: The vectorized merges of the pairs, if the processor supports them.
+#define INT_PAIR_MERGE (is_bitonic_merge_supported() ? bitonic_merge_int_pairs : NULL)
+#define FLOAT_PAIR_MERGE (is_bitonic_merge_supported() ? bitonic_merge_float_pairs : NULL)
+
+DEFINE_BRANCHLESS_MERGE_SORT(sort_int_pairs, IntPair, PAIR_KEY_LESS, INT_PAIR_MERGE)
+DEFINE_BRANCHLESS_MERGE_SORT(sort_float_pairs, FloatPair, PAIR_KEY_LESS, FLOAT_PAIR_MERGE)
+DEFINE_BRANCHLESS_MERGE_SORT(sort_records_by_int, Record, RECORD_INT_LESS, NULL)
+DEFINE_BRANCHLESS_MERGE_SORT(sort_records_by_float, Record, RECORD_FLOAT_LESS, NULL)
+
+/*---------------------------------------------------------------------------------------------------------------*/
+
+void branchless_merge_sort_int_pairs(void *base, size_t count, size_t threshold) {
+  ASSERT(base || !count, "'base' parameter is NULL", branchless_merge_sort_int_pairs);
+  sort_int_pairs((IntPair *) base, count, threshold, 1);
+}
+
+/*---------------------------------------------------------------------------------------------------------------*/
+
+void branchless_merge_sort_int_pairs_scalar(void *base, size_t count, size_t threshold) {
+  ASSERT(base || !count, "'base' parameter is NULL", branchless_merge_sort_int_pairs_scalar);
+  sort_int_pairs((IntPair *) base, count, threshold, 0);
+}
+
+/*---------------------------------------------------------------------------------------------------------------*/
+
+void branchless_merge_sort_float_pairs(void *base, size_t count, size_t threshold) {
+  ASSERT(base || !count, "'base' parameter is NULL", branchless_merge_sort_float_pairs);
+  sort_float_pairs((FloatPair *) base, count, threshold, 1);
+}
+
+/*---------------------------------------------------------------------------------------------------------------*/
+
+void branchless_merge_sort_float_pairs_scalar(void *base, size_t count, size_t threshold) {
+  ASSERT(base || !count, "'base' parameter is NULL", branchless_merge_sort_float_pairs_scalar);
+  sort_float_pairs((FloatPair *) base, count, threshold, 0);
+}
+
+/*---------------------------------------------------------------------------------------------------------------*/
+
+void branchless_merge_sort_records_by_int(Record *records, size_t count, size_t threshold) {
+  ASSERT(records || !count, "'records' parameter is NULL", branchless_merge_sort_records_by_int);
+  sort_records_by_int(records, count, threshold, 0);
+}
+
+/*---------------------------------------------------------------------------------------------------------------*/
+
+void branchless_merge_sort_records_by_float(Record *records, size_t count, size_t threshold) {
+  ASSERT(records || !count, "'records' parameter is NULL", branchless_merge_sort_records_by_float);
+  sort_records_by_float(records, count, threshold, 0);
+}
+
+/*---------------------------------------------------------------------------------------------------------------*/
+
+#if __PROFILER
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+#include "merge-binary-insertion-sort.h"
+#include "comparator.h"
+
+// PURPOSE: The number of pairs sorted by each benchmark.
+#define PROFILER_PAIR_COUNT 4000000
+
+// PURPOSE: The threshold of the sorts of the benchmark.
+#define PROFILER_THRESHOLD 16
+
+// PURPOSE: Opens a counter of the branch misses of the calling thread, or returns -1 if it is not available (e.g. in
+//          a virtual machine, or when perf_event_paranoid forbids it).
+static int open_branch_miss_counter(void) {
+  struct perf_event_attr attr;
+
+  memset(&attr, 0, sizeof(attr));
+  attr.type = PERF_TYPE_HARDWARE;
+  attr.size = sizeof(attr);
+  attr.config = PERF_COUNT_HW_BRANCH_MISSES;
+  attr.disabled = 1;
+  attr.exclude_kernel = 1;
+  attr.exclude_hv = 1;
+
+  return (int) syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+}
+
+// PURPOSE: Sorts a copy of the pairs with the specified sort (or with the merge binary insertion sort, if it is NULL),
+//          and prints its time and its branch misses.
+// NOTE: The integer and the float pairs have the same size, so both are copied as integer pairs.
+static void profile_pair_sort(const char *sort_name, const char *field, const void *pairs, int counter,
+                              void (*sort_fn)(void *, size_t), compare_fn compare) {
+  IntPair *copy;
+  struct timespec start, end;
+  long long misses;
+  size_t i;
+
+  copy = (IntPair *) malloc(sizeof(IntPair) * PROFILER_PAIR_COUNT);
+  ASSERT(copy, "Unable to allocate memory for the benchmark pairs", profile_pair_sort);
+  memcpy(copy, pairs, sizeof(IntPair) * PROFILER_PAIR_COUNT);
+
+  misses = -1;
+
+  if (counter >= 0) {
+    ioctl(counter, PERF_EVENT_IOC_RESET, 0);
+    ioctl(counter, PERF_EVENT_IOC_ENABLE, 0);
+  }
+
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  if (sort_fn)
+    sort_fn(copy, PROFILER_PAIR_COUNT);
+  else
+    merge_binary_insertion_sort(copy, PROFILER_PAIR_COUNT, sizeof(IntPair), PROFILER_THRESHOLD, compare);
+  clock_gettime(CLOCK_MONOTONIC, &end);
+
+  if (counter >= 0) {
+    ioctl(counter, PERF_EVENT_IOC_DISABLE, 0);
+    if (read(counter, &misses, sizeof(misses)) != sizeof(misses))
+      misses = -1;
+  }
+
+  for (i = 1; i < PROFILER_PAIR_COUNT; ++i)
+    ASSERT(compare(&copy[i - 1], &copy[i]) <= 0, "The benchmark pairs have not been sorted", profile_pair_sort);
+
+  printf("[PROFILER]<sort=%s, field=%s>: Sorted %d pairs in %f seconds, %lld branch misses.\n", sort_name, field,
+         PROFILER_PAIR_COUNT, (double) (end.tv_sec - start.tv_sec) + (double) (end.tv_nsec - start.tv_nsec) / 1e9,
+         misses);
+
+  free(copy);
+}
+
+// PURPOSE: Adapts the branchless merge sorts to the signature expected by profile_pair_sort.
+// NOTE: The scalar merges are forced, so that they are measured even if the processor supports the bitonic merge.
+static void sort_int_pairs_fn(void *base, size_t count) {
+  branchless_merge_sort_int_pairs_scalar(base, count, PROFILER_THRESHOLD);
+}
+
+static void sort_float_pairs_fn(void *base, size_t count) {
+  branchless_merge_sort_float_pairs_scalar(base, count, PROFILER_THRESHOLD);
+}
+
+static void bitonic_sort_int_pairs_fn(void *base, size_t count) {
+  branchless_merge_sort_int_pairs(base, count, PROFILER_THRESHOLD);
+}
+
+static void bitonic_sort_float_pairs_fn(void *base, size_t count) {
+  branchless_merge_sort_float_pairs(base, count, PROFILER_THRESHOLD);
+}
+
+void profile__branchless_merge_sort(void) {
+  IntPair *int_pairs;
+  FloatPair *float_pairs;
+  int counter;
+  size_t i;
+
+  int_pairs = (IntPair *) malloc(sizeof(IntPair) * PROFILER_PAIR_COUNT);
+  float_pairs = (FloatPair *) malloc(sizeof(FloatPair) * PROFILER_PAIR_COUNT);
+  ASSERT(int_pairs && float_pairs, "Unable to allocate memory for the benchmark pairs", profile__branchless_merge_sort);
+
+  // The keys are random, so that each comparison of the merges is unpredictable.
+  srand(42);
+
+  for (i = 0; i < PROFILER_PAIR_COUNT; ++i) {
+    int_pairs[i].key = rand() - RAND_MAX / 2;
+    int_pairs[i].payload = (uint32_t) i;
+    float_pairs[i].key = (float) rand() / (float) (rand() % 1000 + 1);
+    float_pairs[i].payload = (uint32_t) i;
+  }
+
+  counter = open_branch_miss_counter();
+
+  if (counter < 0)
+    printf("[PROFILER]: The branch-miss counter is not available, -1 branch misses are reported.\n");
+
+  if (!is_bitonic_merge_supported())
+    printf("[PROFILER]: The processor does not support the AVX2 bitonic merge, which is not profiled.\n");
+
+  profile_pair_sort("merge-binary-insertion", "INTEGER", int_pairs, counter, NULL, int_comparator);
+  profile_pair_sort("branchless-merge", "INTEGER", int_pairs, counter, sort_int_pairs_fn, int_comparator);
+
+  if (is_bitonic_merge_supported())
+    profile_pair_sort("bitonic-merge", "INTEGER", int_pairs, counter, bitonic_sort_int_pairs_fn, int_comparator);
+
+  profile_pair_sort("merge-binary-insertion", "FLOAT", float_pairs, counter, NULL, float_comparator);
+  profile_pair_sort("branchless-merge", "FLOAT", float_pairs, counter, sort_float_pairs_fn, float_comparator);
+
+  if (is_bitonic_merge_supported())
+    profile_pair_sort("bitonic-merge", "FLOAT", float_pairs, counter, bitonic_sort_float_pairs_fn, float_comparator);
+
+  if (counter >= 0)
+    close(counter);
+
+  free(int_pairs);
+  free(float_pairs);
+}
+
+#endif
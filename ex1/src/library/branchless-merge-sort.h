@@ -0,0 +1,86 @@
+#pragma once
+
+#include <stddef.h>
+#include "record.h"
+
+/**
+ * @brief Sorts an array of 8-byte pairs, made of a 32-bit integer key followed by a 32-bit payload, by their keys.
+ *
+ * @remark This is a stable bottom-up merge sort, whose runs of @c threshold pairs are sorted by insertion. Its merge
+ * loop has no data-dependent branch: the next pair is selected by a conditional move between the heads of the two
+ * runs, always stored, and the heads advance by the result of the comparison. The generic merge of
+ * @c merge_binary_insertion_sort mispredicts about half of its branches on random keys, and calls the comparator
+ * through a pointer.
+ *
+ * @remark If the processor supports AVX2, the runs are merged by the bitonic merge of @c bitonic-merge.h instead, which
+ * orders the equal keys by payload: the order is the same when the payloads increase with the positions of the pairs
+ * (as the record indices of the key columns).
+ *
+ * @param base      Pointer to the pairs to be sorted.
+ * @param count     Number of pairs.
+ * @param threshold The length of the runs sorted by insertion before the merges.
+ */
+void branchless_merge_sort_int_pairs(void *base, size_t count, size_t threshold);
+
+/**
+ * @brief Same as @c branchless_merge_sort_int_pairs, for pairs made of a float key followed by a 32-bit payload.
+ *
+ * @remark The bitonic merge orders negative zeros before positive zeros, so the keys should not hold negative zeros
+ * to get the same order on every processor.
+ *
+ * @param base      Pointer to the pairs to be sorted.
+ * @param count     Number of pairs.
+ * @param threshold The length of the runs sorted by insertion before the merges.
+ */
+void branchless_merge_sort_float_pairs(void *base, size_t count, size_t threshold);
+
+/**
+ * @brief Same as @c branchless_merge_sort_int_pairs, but always merges the runs with the scalar branchless merge, even
+ * if the processor supports the bitonic merge (e.g. to compare both merges).
+ *
+ * @param base      Pointer to the pairs to be sorted.
+ * @param count     Number of pairs.
+ * @param threshold The length of the runs sorted by insertion before the merges.
+ */
+void branchless_merge_sort_int_pairs_scalar(void *base, size_t count, size_t threshold);
+
+/**
+ * @brief Same as @c branchless_merge_sort_float_pairs, but always merges the runs with the scalar branchless merge,
+ * even if the processor supports the bitonic merge (e.g. to compare both merges).
+ *
+ * @param base      Pointer to the pairs to be sorted.
+ * @param count     Number of pairs.
+ * @param threshold The length of the runs sorted by insertion before the merges.
+ */
+void branchless_merge_sort_float_pairs_scalar(void *base, size_t count, size_t threshold);
+
+/**
+ * @brief Sorts an array of records by their integer field, with the branchless merge of
+ * @c branchless_merge_sort_int_pairs (the records are copied from the selected head).
+ *
+ * @param records   The records to be sorted.
+ * @param count     Number of records.
+ * @param threshold The length of the runs sorted by insertion before the merges.
+ */
+void branchless_merge_sort_records_by_int(Record *records, size_t count, size_t threshold);
+
+/**
+ * @brief Sorts an array of records by their float field, with the branchless merge of
+ * @c branchless_merge_sort_int_pairs (the records are copied from the selected head).
+ *
+ * @param records   The records to be sorted.
+ * @param count     Number of records.
+ * @param threshold The length of the runs sorted by insertion before the merges.
+ */
+void branchless_merge_sort_records_by_float(Record *records, size_t count, size_t threshold);
+
+#if __PROFILER
+
+/**
+ * @brief Profiles the time and the branch misses (read from the hardware counters through @c perf_event_open, when
+ * available) of the branchless merge sort against the merge binary insertion sort, on random integer and float pairs.
+ * The scalar branchless merge and the bitonic merge (if the processor supports it) are profiled separately.
+ */
+void profile__branchless_merge_sort(void);
+
+#endif
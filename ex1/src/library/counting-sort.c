@@ -0,0 +1,147 @@
+#include <malloc.h>
+#include <string.h>
+#include "counting-sort.h"
+#include "assert_util.h"
+
+/*---------------------------------------------------------------------------------------------------------------*/
+
+// PURPOSE: Reads the i-th key of an array whose keys are stride bytes apart.
+#define KEY_AT(keys, stride, i) (*(const int32_t *) ((const unsigned char *) (keys) + (i) * (stride)))
+
+/*---------------------------------------------------------------------------------------------------------------*/
+
+// PURPOSE: Computes the min key and the range of the keys whose indices are multiple of step.
+static void find_key_range(const void *keys, size_t stride, size_t count, size_t step, int32_t *min_key,
+                           uint64_t *range) {
+  int32_t min, max, key;
+  size_t i;
+
+  min = max = KEY_AT(keys, stride, 0);
+
+  for (i = step; i < count; i += step) {
+    key = KEY_AT(keys, stride, i);
+    min = key < min ? key : min;
+    max = key > max ? key : max;
+  }
+
+  *min_key = min;
+  *range = (uint64_t) ((int64_t) max - min) + 1;
+}
+
+/*---------------------------------------------------------------------------------------------------------------*/
+
+// PURPOSE: Checks whether the keys should be sorted by counting sort, and computes their min key and their range.
+// NOTE: The sampled range is a lower bound of the exact one, so the exact pass is made only if the sample passes.
+static int plan_counting_sort(const void *keys, size_t stride, size_t count, int32_t *min_key, uint64_t *range) {
+  size_t step;
+
+  if (count < COUNTING_SORT_MIN_COUNT)
+    return 0;
+
+  step = count / COUNTING_SORT_SAMPLE_SIZE;
+  find_key_range(keys, stride, count, step > 0 ? step : 1, min_key, range);
+
+  if (*range > count / COUNTING_SORT_RANGE_RATIO)
+    return 0;
+
+  find_key_range(keys, stride, count, 1, min_key, range);
+  return *range <= count / COUNTING_SORT_RANGE_RATIO;
+}
+
+/*---------------------------------------------------------------------------------------------------------------*/
+
+// PURPOSE: Computes the histogram of the keys, and turns it into the position of the first key of each value.
+// NOTE: The returned array must be freed.
+static size_t *make_key_positions(const void *keys, size_t stride, size_t count, int32_t min_key, uint64_t range) {
+  size_t *positions, sum, key_count, i;
+
+  positions = (size_t *) calloc((size_t) range, sizeof(size_t));
+  ASSERT(positions, "Unable to allocate memory for the histogram", make_key_positions);
+
+  for (i = 0; i < count; ++i)
+    positions[KEY_AT(keys, stride, i) - min_key]++;
+
+  sum = 0;
+
+  for (i = 0; i < range; ++i) {
+    key_count = positions[i];
+    positions[i] = sum;
+    sum += key_count;
+  }
+
+  return positions;
+}
+
+/*---------------------------------------------------------------------------------------------------------------*/
+
+const char *get_sort_strategy_name(SortStrategy strategy) {
+  switch (strategy) {
+    case SORT_STRATEGY_MERGE_BINARY_INSERTION:
+      return "merge-binary-insertion";
+    case SORT_STRATEGY_COUNTING:
+      return "counting";
+    case SORT_STRATEGY_PARALLEL_SAMPLE:
+      return "parallel-sample";
+    case SORT_STRATEGY_MULTIWAY_MERGE:
+      return "multiway-merge";
+    case SORT_STRATEGY_BRANCHLESS_MERGE:
+      return "branchless-merge";
+    case SORT_STRATEGY_PDQ:
+      return "pdqsort";
+  }
+
+  PRINT_ERROR("Invalid sort strategy", get_sort_strategy_name);
+  return NULL;
+}
+
+/*---------------------------------------------------------------------------------------------------------------*/
+
+int counting_sort_records(Record **records, size_t count) {
+  Record *sorted;
+  size_t *positions, i;
+  int32_t min_key;
+  uint64_t range;
+
+  ASSERT_NULL_PARAMETER(records, counting_sort_records);
+  ASSERT(*records || !count, "'*records' parameter is NULL", counting_sort_records);
+
+  if (!plan_counting_sort(&(*records)->int_field, sizeof(Record), count, &min_key, &range))
+    return 0;
+
+  sorted = (Record *) malloc(sizeof(Record) * count);
+  ASSERT(sorted, "Unable to allocate memory for the sorted records", counting_sort_records);
+
+  positions = make_key_positions(&(*records)->int_field, sizeof(Record), count, min_key, range);
+
+  // The records are scattered in input order, so the sort is stable.
+  for (i = 0; i < count; ++i)
+    sorted[positions[(*records)[i].int_field - min_key]++] = (*records)[i];
+
+  free(positions);
+  free(*records);
+  *records = sorted;
+  return 1;
+}
+
+/*---------------------------------------------------------------------------------------------------------------*/
+
+int counting_sort_permutation(const int32_t *keys, size_t count, uint32_t *permutation) {
+  size_t *positions, i;
+  int32_t min_key;
+  uint64_t range;
+
+  ASSERT(keys || !count, "'keys' parameter is NULL", counting_sort_permutation);
+  ASSERT(permutation || !count, "'permutation' parameter is NULL", counting_sort_permutation);
+  ASSERT(count <= UINT32_MAX, "Too many keys to be indexed by a permutation", counting_sort_permutation);
+
+  if (!plan_counting_sort(keys, sizeof(int32_t), count, &min_key, &range))
+    return 0;
+
+  positions = make_key_positions(keys, sizeof(int32_t), count, min_key, range);
+
+  for (i = 0; i < count; ++i)
+    permutation[positions[keys[i] - min_key]++] = (uint32_t) i;
+
+  free(positions);
+  return 1;
+}
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include "record.h"
+
+#ifndef COUNTING_SORT_SAMPLE_SIZE
+/**
+ * @brief Defines the number of keys sampled to estimate the range of the keys, before choosing the counting sort.
+ *
+ * @remark This number can be changed by setting this macro before including this header file.
+ */
+#define COUNTING_SORT_SAMPLE_SIZE 1024
+#endif
+
+#ifndef COUNTING_SORT_RANGE_RATIO
+/**
+ * @brief Defines how small the range of the keys must be, compared to their number, to choose the counting sort: it
+ * is chosen when the range is at most <code>count / COUNTING_SORT_RANGE_RATIO</code>.
+ *
+ * @remark This number can be changed by setting this macro before including this header file.
+ */
+#define COUNTING_SORT_RANGE_RATIO 2
+#endif
+
+#ifndef COUNTING_SORT_MIN_COUNT
+/**
+ * @brief Defines the min number of keys for which the counting sort is chosen.
+ *
+ * @remark This number can be changed by setting this macro before including this header file.
+ */
+#define COUNTING_SORT_MIN_COUNT 1024
+#endif
+
+/**
+ * @brief Defines the strategies by which the records can be sorted.
+ */
+typedef enum SortStrategy {
+  /** @brief The records are sorted by the merge binary insertion sort. */
+  SORT_STRATEGY_MERGE_BINARY_INSERTION,
+  /** @brief The records are sorted by a stable counting sort on their integer field. */
+  SORT_STRATEGY_COUNTING,
+  /** @brief The records are sorted by the parallel sample sort. */
+  SORT_STRATEGY_PARALLEL_SAMPLE,
+  /** @brief The records are sorted by the cache-aware multiway merge sort. */
+  SORT_STRATEGY_MULTIWAY_MERGE,
+  /** @brief The records are sorted by the branchless merge sort of their integer or float field. */
+  SORT_STRATEGY_BRANCHLESS_MERGE,
+  /** @brief The records are sorted by the (unstable) pattern-defeating quicksort. */
+  SORT_STRATEGY_PDQ
+} SortStrategy;
+
+/**
+ * @brief Returns the name of a sort strategy, as printed by the profiler.
+ * @param strategy The strategy.
+ * @return The name of the strategy.
+ */
+const char *get_sort_strategy_name(SortStrategy strategy);
+
+/**
+ * @brief Sorts the records by their integer field with a stable counting sort, if the range of the integer fields is
+ * small compared to the number of records.
+ *
+ * @remark The range is estimated from a sample of the keys, then confirmed by an exact pass (so a misleading sample
+ * only costs that pass). The counting sort makes one histogram pass, one prefix sum and one scatter pass into a new
+ * array, which replaces the array of the records.
+ *
+ * @param records Pointer to the array of the records, allocated by @c malloc. If the records are sorted, the array is
+ * deallocated and replaced by a new array, allocated by @c malloc, holding the sorted records.
+ * @param count The number of records.
+ * @return 1 if the records have been sorted, 0 if the range is too large (in which case the records are unchanged).
+ */
+int counting_sort_records(Record **records, size_t count);
+
+/**
+ * @brief Computes the permutation which sorts the integer keys with a stable counting sort, if the range of the keys
+ * is small compared to their number.
+ *
+ * @param keys The integer keys.
+ * @param count The number of keys.
+ * @param permutation The destination array, able to hold @c count indices. After the call, @c permutation[i] is the
+ * index of the i-th key in sorted order.
+ * @return 1 if the permutation has been computed, 0 if the range is too large (in which case the permutation is
+ * unchanged).
+ */
+int counting_sort_permutation(const int32_t *keys, size_t count, uint32_t *permutation);
@@ -0,0 +1,222 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <string.h>
+#include <pthread.h>
+#include "csv-scanner.h"
+#include "assert_util.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define CSV_SCANNER_X86 1
+#else
+#define CSV_SCANNER_X86 0
+#endif
+
+/*---------------------------------------------------------------------------------------------------------------*/
+
+// PURPOSE: Function pointer type of a block scanner implementation.
+typedef void (*scan_block_fn)(const char *, CsvBlockMasks *);
+
+// PURPOSE: The implementation selected for the running processor, and its name.
+static scan_block_fn g_scan_block = NULL;
+static const char *g_scanner_name = NULL;
+
+// PURPOSE: Guards the selection of the implementation.
+static pthread_once_t g_scanner_once = PTHREAD_ONCE_INIT;
+
+/*---------------------------------------------------------------------------------------------------------------*/
+
+// PURPOSE: Classifies the block one byte at a time.
+static void scan_block_scalar(const char *block, CsvBlockMasks *masks) {
+  uint64_t commas, newlines;
+  size_t i;
+
+  commas = newlines = 0;
+
+  for (i = 0; i < CSV_SCANNER_BLOCK_SIZE; ++i) {
+    commas |= (uint64_t) (block[i] == ',') << i;
+    newlines |= (uint64_t) (block[i] == '\n') << i;
+  }
+
+  masks->commas = commas;
+  masks->newlines = newlines;
+}
+
+/*---------------------------------------------------------------------------------------------------------------*/
+
+#if CSV_SCANNER_X86
+
+// PURPOSE: Classifies the block 16 bytes at a time.
+__attribute__((target("sse2")))
+static void scan_block_sse2(const char *block, CsvBlockMasks *masks) {
+  __m128i comma, newline, chunk;
+  uint64_t commas, newlines;
+  int i;
+
+  comma = _mm_set1_epi8(',');
+  newline = _mm_set1_epi8('\n');
+  commas = newlines = 0;
+
+  for (i = 0; i < 4; ++i) {
+    chunk = _mm_loadu_si128((const __m128i *) (block + 16 * i));
+    commas |= (uint64_t) (uint16_t) _mm_movemask_epi8(_mm_cmpeq_epi8(chunk, comma)) << (16 * i);
+    newlines |= (uint64_t) (uint16_t) _mm_movemask_epi8(_mm_cmpeq_epi8(chunk, newline)) << (16 * i);
+  }
+
+  masks->commas = commas;
+  masks->newlines = newlines;
+}
+
+/*---------------------------------------------------------------------------------------------------------------*/
+
+// PURPOSE: Classifies the block 32 bytes at a time.
+__attribute__((target("avx2")))
+static void scan_block_avx2(const char *block, CsvBlockMasks *masks) {
+  __m256i comma, newline, low, high;
+
+  comma = _mm256_set1_epi8(',');
+  newline = _mm256_set1_epi8('\n');
+  low = _mm256_loadu_si256((const __m256i *) block);
+  high = _mm256_loadu_si256((const __m256i *) (block + 32));
+
+  masks->commas = (uint64_t) (uint32_t) _mm256_movemask_epi8(_mm256_cmpeq_epi8(low, comma)) |
+                  (uint64_t) (uint32_t) _mm256_movemask_epi8(_mm256_cmpeq_epi8(high, comma)) << 32;
+  masks->newlines = (uint64_t) (uint32_t) _mm256_movemask_epi8(_mm256_cmpeq_epi8(low, newline)) |
+                    (uint64_t) (uint32_t) _mm256_movemask_epi8(_mm256_cmpeq_epi8(high, newline)) << 32;
+}
+
+#endif
+
+/*---------------------------------------------------------------------------------------------------------------*/
+
+// PURPOSE: Returns the block scanner of the specified implementation, or NULL if the running processor does not
+//          support it.
+static scan_block_fn get_block_scanner(CsvScannerImpl impl) {
+  switch (impl) {
+    case CSV_SCANNER_SCALAR:
+      return scan_block_scalar;
+#if CSV_SCANNER_X86
+    case CSV_SCANNER_SSE2:
+      __builtin_cpu_init();
+      return __builtin_cpu_supports("sse2") ? scan_block_sse2 : NULL;
+    case CSV_SCANNER_AVX2:
+      __builtin_cpu_init();
+      return __builtin_cpu_supports("avx2") ? scan_block_avx2 : NULL;
+#endif
+    default:
+      return NULL;
+  }
+}
+
+/*---------------------------------------------------------------------------------------------------------------*/
+
+// PURPOSE: Selects the widest implementation supported by the running processor.
+static void select_scanner(void) {
+#if CSV_SCANNER_X86
+  __builtin_cpu_init();
+
+  if (__builtin_cpu_supports("avx2")) {
+    g_scan_block = scan_block_avx2;
+    g_scanner_name = "AVX2";
+    return;
+  }
+
+  if (__builtin_cpu_supports("sse2")) {
+    g_scan_block = scan_block_sse2;
+    g_scanner_name = "SSE2";
+    return;
+  }
+#endif
+
+  g_scan_block = scan_block_scalar;
+  g_scanner_name = "scalar";
+}
+
+/*---------------------------------------------------------------------------------------------------------------*/
+
+void scan_csv_block(const char *block, CsvBlockMasks *masks) {
+  pthread_once(&g_scanner_once, select_scanner);
+  g_scan_block(block, masks);
+}
+
+/*---------------------------------------------------------------------------------------------------------------*/
+
+int is_csv_scanner_supported(CsvScannerImpl impl) {
+  return get_block_scanner(impl) != NULL;
+}
+
+/*---------------------------------------------------------------------------------------------------------------*/
+
+void scan_csv_block_impl(CsvScannerImpl impl, const char *block, CsvBlockMasks *masks) {
+  scan_block_fn scan_block;
+
+  scan_block = get_block_scanner(impl);
+  ASSERT(scan_block, "The scanner implementation is not supported by the processor", scan_csv_block_impl);
+  scan_block(block, masks);
+}
+
+/*---------------------------------------------------------------------------------------------------------------*/
+
+const char *get_csv_scanner_name(void) {
+  pthread_once(&g_scanner_once, select_scanner);
+  return g_scanner_name;
+}
+
+/*---------------------------------------------------------------------------------------------------------------*/
+
+// PURPOSE: Appends the offsets of the set bits of the mask (relative to the block at the specified base offset).
+static size_t flatten_mask(uint64_t mask, uint32_t base, uint32_t *offsets) {
+  size_t count;
+
+  count = 0;
+
+  while (mask) {
+    offsets[count++] = base + (uint32_t) __builtin_ctzll(mask);
+    mask &= mask - 1;
+  }
+
+  return count;
+}
+
+/*---------------------------------------------------------------------------------------------------------------*/
+
+// PURPOSE: Collects the offsets of the structural characters of a buffer with the specified block scanner.
+static size_t scan_structurals(scan_block_fn scan_block, const char *buffer, size_t length, uint32_t *offsets) {
+  char tail[CSV_SCANNER_BLOCK_SIZE];
+  CsvBlockMasks masks;
+  size_t position, count;
+
+  count = 0;
+
+  for (position = 0; position + CSV_SCANNER_BLOCK_SIZE <= length; position += CSV_SCANNER_BLOCK_SIZE) {
+    scan_block(buffer + position, &masks);
+    count += flatten_mask(masks.commas | masks.newlines, (uint32_t) position, offsets + count);
+  }
+
+  if (position < length) {
+    // The last partial block is copied into a zero-padded block, so that no byte past the buffer is read.
+    memset(tail, 0, CSV_SCANNER_BLOCK_SIZE);
+    memcpy(tail, buffer + position, length - position);
+    scan_block(tail, &masks);
+    count += flatten_mask(masks.commas | masks.newlines, (uint32_t) position, offsets + count);
+  }
+
+  return count;
+}
+
+/*---------------------------------------------------------------------------------------------------------------*/
+
+size_t scan_csv_structurals(const char *buffer, size_t length, uint32_t *offsets) {
+  pthread_once(&g_scanner_once, select_scanner);
+  return scan_structurals(g_scan_block, buffer, length, offsets);
+}
+
+/*---------------------------------------------------------------------------------------------------------------*/
+
+size_t scan_csv_structurals_impl(CsvScannerImpl impl, const char *buffer, size_t length, uint32_t *offsets) {
+  scan_block_fn scan_block;
+
+  scan_block = get_block_scanner(impl);
+  ASSERT(scan_block, "The scanner implementation is not supported by the processor", scan_csv_structurals_impl);
+  return scan_structurals(scan_block, buffer, length, offsets);
+}
@@ -0,0 +1,85 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @brief The number of bytes classified by a single call to @c scan_csv_block.
+ */
+#define CSV_SCANNER_BLOCK_SIZE 64
+
+/**
+ * @brief Holds the positions of the structural characters of a block: bit @c i of each mask is set if the byte at
+ * offset @c i of the block is a comma or a newline, respectively.
+ */
+typedef struct CsvBlockMasks {
+  uint64_t commas;  ///< Positions of the ',' characters.
+  uint64_t newlines;  ///< Positions of the '\\n' characters.
+} CsvBlockMasks;
+
+/**
+ * @brief Defines the implementations of the block scanner.
+ */
+typedef enum CsvScannerImpl {
+  /** @brief Plain scalar code, one byte at a time (always supported). */
+  CSV_SCANNER_SCALAR,
+  /** @brief SSE2 instructions, 16 bytes at a time. */
+  CSV_SCANNER_SSE2,
+  /** @brief AVX2 instructions, 32 bytes at a time. */
+  CSV_SCANNER_AVX2
+} CsvScannerImpl;
+
+/**
+ * @brief Classifies the structural characters of a 64-byte block.
+ *
+ * @remark The block is scanned with the widest instruction set supported by the running processor (AVX2, SSE2 or
+ * plain scalar code), selected once at the first call.
+ *
+ * @param block Pointer to the block, which must contain at least @c CSV_SCANNER_BLOCK_SIZE readable bytes.
+ * @param masks The destination masks.
+ */
+void scan_csv_block(const char *block, CsvBlockMasks *masks);
+
+/**
+ * @brief Collects the offsets of the structural characters (commas and newlines) of a buffer.
+ *
+ * @remark This is the first stage of the parsing of a record file: the following stage only needs to walk the offsets
+ * to slice the fields, without looking at the other bytes.
+ *
+ * @param buffer Pointer to the buffer to be scanned.
+ * @param length The number of bytes to be scanned.
+ * @param offsets The destination array, which must be able to hold @c length offsets.
+ * @return The number of offsets stored into the destination array, in increasing order.
+ */
+size_t scan_csv_structurals(const char *buffer, size_t length, uint32_t *offsets);
+
+/**
+ * @brief Returns whether the specified implementation can run on the running processor.
+ * @param impl The implementation.
+ * @return 1 if it is supported, 0 otherwise.
+ */
+int is_csv_scanner_supported(CsvScannerImpl impl);
+
+/**
+ * @brief Same as @c scan_csv_block, but with the specified implementation rather than the selected one.
+ * @param impl The implementation, which must be supported by the running processor.
+ * @param block Pointer to the block, which must contain at least @c CSV_SCANNER_BLOCK_SIZE readable bytes.
+ * @param masks The destination masks.
+ */
+void scan_csv_block_impl(CsvScannerImpl impl, const char *block, CsvBlockMasks *masks);
+
+/**
+ * @brief Same as @c scan_csv_structurals, but with the specified implementation rather than the selected one.
+ * @param impl The implementation, which must be supported by the running processor.
+ * @param buffer Pointer to the buffer to be scanned.
+ * @param length The number of bytes to be scanned.
+ * @param offsets The destination array, which must be able to hold @c length offsets.
+ * @return The number of offsets stored into the destination array, in increasing order.
+ */
+size_t scan_csv_structurals_impl(CsvScannerImpl impl, const char *buffer, size_t length, uint32_t *offsets);
+
+/**
+ * @brief Returns the name of the implementation selected for the running processor ("AVX2", "SSE2" or "scalar").
+ * @return The name of the implementation.
+ */
+const char *get_csv_scanner_name(void);
@@ -0,0 +1,546 @@
+#include <string.h>
+#include <stdlib.h>
+#include "field-parsers.h"
+
+/*---------------------------------------------------------------------------------------------------------------*/
+
+// PURPOSE: Returns 1 if the character is a decimal digit.
+#define IS_DIGIT(c) ((unsigned char) ((c) - '0') < 10)
+
+// PURPOSE: The max number of digits which always fit into a 64-bit unsigned integer.
+#define MAX_SAFE_DIGITS 19
+
+// PURPOSE: The range of decimal exponents covered by the table of the powers of five.
+// NOTE: Below the smallest exponent every number rounds to zero, above the largest one to infinity.
+#define SMALLEST_POWER_OF_TEN (-65)
+#define LARGEST_POWER_OF_TEN 38
+
+// PURPOSE: The number of explicit bits of the mantissa of a float.
+#define FLOAT_MANTISSA_BITS 23
+
+// PURPOSE: The biased exponent of the infinities.
+#define FLOAT_INFINITE_POWER 0xFF
+
+// PURPOSE: The smallest binary exponent of a float, minus the bias.
+#define FLOAT_MINIMUM_EXPONENT (-127)
+
+// PURPOSE: The range of decimal exponents in which a product may be exactly halfway between two floats.
+#define FLOAT_MIN_EXPONENT_ROUND_TO_EVEN (-17)
+#define FLOAT_MAX_EXPONENT_ROUND_TO_EVEN 10
+
+// PURPOSE: The max length of a number which falls back to strtof.
+#define FALLBACK_BUFFER_SIZE 128
+
+/*---------------------------------------------------------------------------------------------------------------*/
+
+// PURPOSE: The 128-bit truncated approximations of the powers of five in [5^SMALLEST_POWER_OF_TEN, 5^LARGEST_POWER_OF_TEN],
+//          normalized so that their most significant bit is set (high word first).
+static const uint64_t g_powers_of_five[LARGEST_POWER_OF_TEN - SMALLEST_POWER_OF_TEN + 1][2] = {
+    {0x86ccbb52ea94baeaULL, 0x98e947129fc2b4e9ULL},  // 5^-65
+    {0xa87fea27a539e9a5ULL, 0x3f2398d747b36224ULL},  // 5^-64
+    {0xd29fe4b18e88640eULL, 0x8eec7f0d19a03aadULL},  // 5^-63
+    {0x83a3eeeef9153e89ULL, 0x1953cf68300424acULL},  // 5^-62
+    {0xa48ceaaab75a8e2bULL, 0x5fa8c3423c052dd7ULL},  // 5^-61
+    {0xcdb02555653131b6ULL, 0x3792f412cb06794dULL},  // 5^-60
+    {0x808e17555f3ebf11ULL, 0xe2bbd88bbee40bd0ULL},  // 5^-59
+    {0xa0b19d2ab70e6ed6ULL, 0x5b6aceaeae9d0ec4ULL},  // 5^-58
+    {0xc8de047564d20a8bULL, 0xf245825a5a445275ULL},  // 5^-57
+    {0xfb158592be068d2eULL, 0xeed6e2f0f0d56712ULL},  // 5^-56
+    {0x9ced737bb6c4183dULL, 0x55464dd69685606bULL},  // 5^-55
+    {0xc428d05aa4751e4cULL, 0xaa97e14c3c26b886ULL},  // 5^-54
+    {0xf53304714d9265dfULL, 0xd53dd99f4b3066a8ULL},  // 5^-53
+    {0x993fe2c6d07b7fabULL, 0xe546a8038efe4029ULL},  // 5^-52
+    {0xbf8fdb78849a5f96ULL, 0xde98520472bdd033ULL},  // 5^-51
+    {0xef73d256a5c0f77cULL, 0x963e66858f6d4440ULL},  // 5^-50
+    {0x95a8637627989aadULL, 0xdde7001379a44aa8ULL},  // 5^-49
+    {0xbb127c53b17ec159ULL, 0x5560c018580d5d52ULL},  // 5^-48
+    {0xe9d71b689dde71afULL, 0xaab8f01e6e10b4a6ULL},  // 5^-47
+    {0x9226712162ab070dULL, 0xcab3961304ca70e8ULL},  // 5^-46
+    {0xb6b00d69bb55c8d1ULL, 0x3d607b97c5fd0d22ULL},  // 5^-45
+    {0xe45c10c42a2b3b05ULL, 0x8cb89a7db77c506aULL},  // 5^-44
+    {0x8eb98a7a9a5b04e3ULL, 0x77f3608e92adb242ULL},  // 5^-43
+    {0xb267ed1940f1c61cULL, 0x55f038b237591ed3ULL},  // 5^-42
+    {0xdf01e85f912e37a3ULL, 0x6b6c46dec52f6688ULL},  // 5^-41
+    {0x8b61313bbabce2c6ULL, 0x2323ac4b3b3da015ULL},  // 5^-40
+    {0xae397d8aa96c1b77ULL, 0xabec975e0a0d081aULL},  // 5^-39
+    {0xd9c7dced53c72255ULL, 0x96e7bd358c904a21ULL},  // 5^-38
+    {0x881cea14545c7575ULL, 0x7e50d64177da2e54ULL},  // 5^-37
+    {0xaa242499697392d2ULL, 0xdde50bd1d5d0b9e9ULL},  // 5^-36
+    {0xd4ad2dbfc3d07787ULL, 0x955e4ec64b44e864ULL},  // 5^-35
+    {0x84ec3c97da624ab4ULL, 0xbd5af13bef0b113eULL},  // 5^-34
+    {0xa6274bbdd0fadd61ULL, 0xecb1ad8aeacdd58eULL},  // 5^-33
+    {0xcfb11ead453994baULL, 0x67de18eda5814af2ULL},  // 5^-32
+    {0x81ceb32c4b43fcf4ULL, 0x80eacf948770ced7ULL},  // 5^-31
+    {0xa2425ff75e14fc31ULL, 0xa1258379a94d028dULL},  // 5^-30
+    {0xcad2f7f5359a3b3eULL, 0x096ee45813a04330ULL},  // 5^-29
+    {0xfd87b5f28300ca0dULL, 0x8bca9d6e188853fcULL},  // 5^-28
+    {0x9e74d1b791e07e48ULL, 0x775ea264cf55347eULL},  // 5^-27
+    {0xc612062576589ddaULL, 0x95364afe032a819eULL},  // 5^-26
+    {0xf79687aed3eec551ULL, 0x3a83ddbd83f52205ULL},  // 5^-25
+    {0x9abe14cd44753b52ULL, 0xc4926a9672793543ULL},  // 5^-24
+    {0xc16d9a0095928a27ULL, 0x75b7053c0f178294ULL},  // 5^-23
+    {0xf1c90080baf72cb1ULL, 0x5324c68b12dd6339ULL},  // 5^-22
+    {0x971da05074da7beeULL, 0xd3f6fc16ebca5e04ULL},  // 5^-21
+    {0xbce5086492111aeaULL, 0x88f4bb1ca6bcf585ULL},  // 5^-20
+    {0xec1e4a7db69561a5ULL, 0x2b31e9e3d06c32e6ULL},  // 5^-19
+    {0x9392ee8e921d5d07ULL, 0x3aff322e62439fd0ULL},  // 5^-18
+    {0xb877aa3236a4b449ULL, 0x09befeb9fad487c3ULL},  // 5^-17
+    {0xe69594bec44de15bULL, 0x4c2ebe687989a9b4ULL},  // 5^-16
+    {0x901d7cf73ab0acd9ULL, 0x0f9d37014bf60a11ULL},  // 5^-15
+    {0xb424dc35095cd80fULL, 0x538484c19ef38c95ULL},  // 5^-14
+    {0xe12e13424bb40e13ULL, 0x2865a5f206b06fbaULL},  // 5^-13
+    {0x8cbccc096f5088cbULL, 0xf93f87b7442e45d4ULL},  // 5^-12
+    {0xafebff0bcb24aafeULL, 0xf78f69a51539d749ULL},  // 5^-11
+    {0xdbe6fecebdedd5beULL, 0xb573440e5a884d1cULL},  // 5^-10
+    {0x89705f4136b4a597ULL, 0x31680a88f8953031ULL},  // 5^-9
+    {0xabcc77118461cefcULL, 0xfdc20d2b36ba7c3eULL},  // 5^-8
+    {0xd6bf94d5e57a42bcULL, 0x3d32907604691b4dULL},  // 5^-7
+    {0x8637bd05af6c69b5ULL, 0xa63f9a49c2c1b110ULL},  // 5^-6
+    {0xa7c5ac471b478423ULL, 0x0fcf80dc33721d54ULL},  // 5^-5
+    {0xd1b71758e219652bULL, 0xd3c36113404ea4a9ULL},  // 5^-4
+    {0x83126e978d4fdf3bULL, 0x645a1cac083126eaULL},  // 5^-3
+    {0xa3d70a3d70a3d70aULL, 0x3d70a3d70a3d70a4ULL},  // 5^-2
+    {0xccccccccccccccccULL, 0xcccccccccccccccdULL},  // 5^-1
+    {0x8000000000000000ULL, 0x0000000000000000ULL},  // 5^0
+    {0xa000000000000000ULL, 0x0000000000000000ULL},  // 5^1
+    {0xc800000000000000ULL, 0x0000000000000000ULL},  // 5^2
+    {0xfa00000000000000ULL, 0x0000000000000000ULL},  // 5^3
+    {0x9c40000000000000ULL, 0x0000000000000000ULL},  // 5^4
+    {0xc350000000000000ULL, 0x0000000000000000ULL},  // 5^5
+    {0xf424000000000000ULL, 0x0000000000000000ULL},  // 5^6
+    {0x9896800000000000ULL, 0x0000000000000000ULL},  // 5^7
+    {0xbebc200000000000ULL, 0x0000000000000000ULL},  // 5^8
+    {0xee6b280000000000ULL, 0x0000000000000000ULL},  // 5^9
+    {0x9502f90000000000ULL, 0x0000000000000000ULL},  // 5^10
+    {0xba43b74000000000ULL, 0x0000000000000000ULL},  // 5^11
+    {0xe8d4a51000000000ULL, 0x0000000000000000ULL},  // 5^12
+    {0x9184e72a00000000ULL, 0x0000000000000000ULL},  // 5^13
+    {0xb5e620f480000000ULL, 0x0000000000000000ULL},  // 5^14
+    {0xe35fa931a0000000ULL, 0x0000000000000000ULL},  // 5^15
+    {0x8e1bc9bf04000000ULL, 0x0000000000000000ULL},  // 5^16
+    {0xb1a2bc2ec5000000ULL, 0x0000000000000000ULL},  // 5^17
+    {0xde0b6b3a76400000ULL, 0x0000000000000000ULL},  // 5^18
+    {0x8ac7230489e80000ULL, 0x0000000000000000ULL},  // 5^19
+    {0xad78ebc5ac620000ULL, 0x0000000000000000ULL},  // 5^20
+    {0xd8d726b7177a8000ULL, 0x0000000000000000ULL},  // 5^21
+    {0x878678326eac9000ULL, 0x0000000000000000ULL},  // 5^22
+    {0xa968163f0a57b400ULL, 0x0000000000000000ULL},  // 5^23
+    {0xd3c21bcecceda100ULL, 0x0000000000000000ULL},  // 5^24
+    {0x84595161401484a0ULL, 0x0000000000000000ULL},  // 5^25
+    {0xa56fa5b99019a5c8ULL, 0x0000000000000000ULL},  // 5^26
+    {0xcecb8f27f4200f3aULL, 0x0000000000000000ULL},  // 5^27
+    {0x813f3978f8940984ULL, 0x4000000000000000ULL},  // 5^28
+    {0xa18f07d736b90be5ULL, 0x5000000000000000ULL},  // 5^29
+    {0xc9f2c9cd04674edeULL, 0xa400000000000000ULL},  // 5^30
+    {0xfc6f7c4045812296ULL, 0x4d00000000000000ULL},  // 5^31
+    {0x9dc5ada82b70b59dULL, 0xf020000000000000ULL},  // 5^32
+    {0xc5371912364ce305ULL, 0x6c28000000000000ULL},  // 5^33
+    {0xf684df56c3e01bc6ULL, 0xc732000000000000ULL},  // 5^34
+    {0x9a130b963a6c115cULL, 0x3c7f400000000000ULL},  // 5^35
+    {0xc097ce7bc90715b3ULL, 0x4b9f100000000000ULL},  // 5^36
+    {0xf0bdc21abb48db20ULL, 0x1e86d40000000000ULL},  // 5^37
+    {0x96769950b50d88f4ULL, 0x1314448000000000ULL},  // 5^38
+};
+
+// PURPOSE: The powers of ten which are exactly representable as floats.
+static const float g_exact_powers_of_ten[] = {1e0f, 1e1f, 1e2f, 1e3f, 1e4f, 1e5f, 1e6f, 1e7f, 1e8f, 1e9f, 1e10f};
+
+/*---------------------------------------------------------------------------------------------------------------*/
+
+// PURPOSE: Returns 1 if the eight bytes (loaded in little-endian order) are all decimal digits.
+static int is_eight_digits(uint64_t chunk) {
+  return !(((chunk & 0xF0F0F0F0F0F0F0F0ULL) |
+            (((chunk + 0x0606060606060606ULL) & 0xF0F0F0F0F0F0F0F0ULL) >> 4)) ^ 0x3333333333333333ULL);
+}
+
+/*---------------------------------------------------------------------------------------------------------------*/
+
+// PURPOSE: Converts eight decimal digits (loaded in little-endian order) into their value, with three multiplications.
+static uint32_t parse_eight_digits(uint64_t chunk) {
+  chunk -= 0x3030303030303030ULL;
+  chunk = (chunk * 10) + (chunk >> 8);
+  chunk = (((chunk & 0x000000FF000000FFULL) * (100 + (1000000ULL << 32))) +
+           (((chunk >> 16) & 0x000000FF000000FFULL) * (1 + (10000ULL << 32)))) >> 32;
+  return (uint32_t) chunk;
+}
+
+/*---------------------------------------------------------------------------------------------------------------*/
+
+// PURPOSE: Accumulates the digits starting at *cursor into *value, and returns the number of consumed digits.
+// NOTE: The value may wrap around: the caller detects overflows from the number of digits.
+static size_t accumulate_digits(const char **cursor, const char *end, uint64_t *value) {
+  const char *p;
+  uint64_t chunk;
+
+  p = *cursor;
+
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+  while (end - p >= 8) {
+    memcpy(&chunk, p, sizeof(uint64_t));
+
+    if (!is_eight_digits(chunk))
+      break;
+
+    *value = *value * 100000000ULL + parse_eight_digits(chunk);
+    p += 8;
+  }
+#endif
+
+  while (p < end && IS_DIGIT(*p)) {
+    *value = *value * 10 + (uint64_t) (*p - '0');
+    p++;
+  }
+
+  chunk = (uint64_t) (p - *cursor);
+  *cursor = p;
+  return (size_t) chunk;
+}
+
+/*---------------------------------------------------------------------------------------------------------------*/
+
+// PURPOSE: Parses the digits of an unsigned integer, detecting overflows.
+static int parse_magnitude(const char *begin, const char *end, uint64_t *value) {
+  const char *p, *digits;
+  uint64_t result;
+  size_t count;
+
+  // Leading zeros do not count towards the overflow limit.
+  for (p = begin; p < end && *p == '0'; ++p);
+
+  digits = p;
+  result = 0;
+  count = accumulate_digits(&p, end, &result);
+
+  if (p != end || p == begin)
+    return 0;
+
+  if (count > MAX_SAFE_DIGITS + 1)
+    return 0;
+
+  // A 20-digit number overflowed iff it wrapped around below 10^19.
+  if (count == MAX_SAFE_DIGITS + 1 && (digits[0] > '1' || result < 10000000000000000000ULL))
+    return 0;
+
+  *value = result;
+  return 1;
+}
+
+/*---------------------------------------------------------------------------------------------------------------*/
+
+int parse_uint64(const char *begin, const char *end, uint64_t *value) {
+  return parse_magnitude(begin, end, value);
+}
+
+/*---------------------------------------------------------------------------------------------------------------*/
+
+int parse_int32(const char *begin, const char *end, int32_t *value) {
+  uint64_t magnitude;
+  int negative;
+
+  negative = begin < end && *begin == '-';
+
+  if (begin < end && (*begin == '-' || *begin == '+'))
+    begin++;
+
+  if (!parse_magnitude(begin, end, &magnitude))
+    return 0;
+
+  if (magnitude > (uint64_t) INT32_MAX + (uint64_t) negative)
+    return 0;
+
+  *value = negative ? (int32_t) (0 - magnitude) : (int32_t) magnitude;
+  return 1;
+}
+
+/*---------------------------------------------------------------------------------------------------------------*/
+
+// PURPOSE: Computes the full 128-bit product of two 64-bit integers.
+static void full_multiplication(uint64_t a, uint64_t b, uint64_t *high, uint64_t *low) {
+  uint64_t a_lo, a_hi, b_lo, b_hi, p0, p1, p2, p3, middle;
+
+  a_lo = a & 0xFFFFFFFFULL;
+  a_hi = a >> 32;
+  b_lo = b & 0xFFFFFFFFULL;
+  b_hi = b >> 32;
+
+  p0 = a_lo * b_lo;
+  p1 = a_lo * b_hi;
+  p2 = a_hi * b_lo;
+  p3 = a_hi * b_hi;
+
+  middle = (p0 >> 32) + (p1 & 0xFFFFFFFFULL) + (p2 & 0xFFFFFFFFULL);
+
+  *low = (middle << 32) | (p0 & 0xFFFFFFFFULL);
+  *high = p3 + (p1 >> 32) + (p2 >> 32) + (middle >> 32);
+}
+
+/*---------------------------------------------------------------------------------------------------------------*/
+
+// PURPOSE: Returns the number of leading zero bits of a non-zero integer.
+static int leading_zeroes(uint64_t value) {
+  return __builtin_clzll(value);
+}
+
+/*---------------------------------------------------------------------------------------------------------------*/
+
+// PURPOSE: Converts w * 10^q (with w != 0 and q in the table range) into the bits of the nearest float, using the
+//          Eisel-Lemire algorithm.
+static uint32_t eisel_lemire(uint64_t w, int32_t q) {
+  const uint64_t *power;
+  uint64_t high, low, second_high, second_low, mantissa, precision_mask;
+  int32_t power2;
+  int lz, upper_bit, shift;
+
+  lz = leading_zeroes(w);
+  w <<= lz;
+
+  power = g_powers_of_five[q - SMALLEST_POWER_OF_TEN];
+  full_multiplication(w, power[0], &high, &low);
+
+  // The lower part of the power only matters when the truncated product may carry into the retained bits.
+  precision_mask = 0xFFFFFFFFFFFFFFFFULL >> (FLOAT_MANTISSA_BITS + 3);
+
+  if ((high & precision_mask) == precision_mask) {
+    full_multiplication(w, power[1], &second_high, &second_low);
+    low += second_high;
+    if (second_high > low)
+      high++;
+  }
+
+  upper_bit = (int) (high >> 63);
+  shift = upper_bit + 64 - FLOAT_MANTISSA_BITS - 3;
+  mantissa = high >> shift;
+  power2 = (int32_t) ((((152170 + 65536) * q) >> 16) + 63) + upper_bit - lz - FLOAT_MINIMUM_EXPONENT;
+
+  if (power2 <= 0) {
+    // Subnormal numbers (or zero).
+    if (-power2 + 1 >= 64)
+      return 0;
+
+    mantissa >>= -power2 + 1;
+    mantissa += mantissa & 1;
+    mantissa >>= 1;
+    power2 = mantissa < (1ULL << FLOAT_MANTISSA_BITS) ? 0 : 1;
+    return (uint32_t) (((uint64_t) power2 << FLOAT_MANTISSA_BITS) | (mantissa & ((1ULL << FLOAT_MANTISSA_BITS) - 1)));
+  }
+
+  // Exactly halfway between two floats: rounds to even.
+  if (low <= 1 && q >= FLOAT_MIN_EXPONENT_ROUND_TO_EVEN && q <= FLOAT_MAX_EXPONENT_ROUND_TO_EVEN &&
+      (mantissa & 3) == 1 && (mantissa << shift) == high)
+    mantissa &= ~1ULL;
+
+  mantissa += mantissa & 1;
+  mantissa >>= 1;
+
+  if (mantissa >= (2ULL << FLOAT_MANTISSA_BITS)) {
+    mantissa = 1ULL << FLOAT_MANTISSA_BITS;
+    power2++;
+  }
+
+  mantissa &= ~(1ULL << FLOAT_MANTISSA_BITS);
+
+  if (power2 >= FLOAT_INFINITE_POWER)
+    return (uint32_t) FLOAT_INFINITE_POWER << FLOAT_MANTISSA_BITS;
+
+  return (uint32_t) (((uint64_t) power2 << FLOAT_MANTISSA_BITS) | mantissa);
+}
+
+/*---------------------------------------------------------------------------------------------------------------*/
+
+// PURPOSE: Parses the number with strtof (used for the inputs which are not handled by the fast paths).
+static int parse_float32_fallback(const char *begin, const char *end, float *value) {
+  char buffer[FALLBACK_BUFFER_SIZE];
+  char *parse_end;
+  size_t length;
+
+  length = (size_t) (end - begin);
+
+  if (length == 0 || length >= FALLBACK_BUFFER_SIZE)
+    return 0;
+
+  memcpy(buffer, begin, length);
+  buffer[length] = '\0';
+
+  *value = strtof(buffer, &parse_end);
+  return parse_end == buffer + length;
+}
+
+/*---------------------------------------------------------------------------------------------------------------*/
+
+int parse_float32(const char *begin, const char *end, float *value) {
+  const char *p, *digits_start, *frac_start;
+  uint64_t w, exp_value;
+  int64_t q;
+  size_t digit_count, exp_digits;
+  uint32_t bits;
+  int negative, exp_negative, has_digits;
+  float result;
+
+  p = begin;
+  negative = p < end && *p == '-';
+
+  if (p < end && (*p == '-' || *p == '+'))
+    p++;
+
+  // Leading zeros are not significant.
+  digits_start = p;
+  while (p < end && *p == '0')
+    p++;
+
+  w = 0;
+  digit_count = accumulate_digits(&p, end, &w);
+  has_digits = p > digits_start;
+  q = 0;
+
+  if (p < end && *p == '.') {
+    p++;
+    frac_start = p;
+
+    // Without significant integer digits, the leading zeros of the fraction are not significant either.
+    if (digit_count == 0)
+      while (p < end && *p == '0')
+        p++;
+
+    digit_count += accumulate_digits(&p, end, &w);
+    has_digits |= p > frac_start;
+    q = -(int64_t) (p - frac_start);
+  }
+
+  // Infinities, NaNs and hexadecimal numbers.
+  if (!has_digits)
+    return parse_float32_fallback(begin, end, value);
+
+  if (p < end && (*p == 'e' || *p == 'E')) {
+    p++;
+    exp_negative = p < end && *p == '-';
+
+    if (p < end && (*p == '-' || *p == '+'))
+      p++;
+
+    exp_value = 0;
+    exp_digits = accumulate_digits(&p, end, &exp_value);
+
+    if (exp_digits == 0 || exp_digits > 9)
+      return parse_float32_fallback(begin, end, value);
+
+    q += exp_negative ? -(int64_t) exp_value : (int64_t) exp_value;
+  }
+
+  if (p != end || digit_count > MAX_SAFE_DIGITS)
+    return parse_float32_fallback(begin, end, value);
+
+  if (w == 0) {
+    *value = negative ? -0.0f : 0.0f;
+    return 1;
+  }
+
+  // Clinger fast path: both the mantissa and the power of ten are exact floats, so a single rounding occurs.
+  if (w <= (1ULL << (FLOAT_MANTISSA_BITS + 1)) && q >= -10 && q <= 10) {
+    result = (float) w;
+    result = q < 0 ? result / g_exact_powers_of_ten[-q] : result * g_exact_powers_of_ten[q];
+    *value = negative ? -result : result;
+    return 1;
+  }
+
+  if (q < SMALLEST_POWER_OF_TEN) bits = 0;
+  else if (q > LARGEST_POWER_OF_TEN) bits = (uint32_t) FLOAT_INFINITE_POWER << FLOAT_MANTISSA_BITS;
+  else bits = eisel_lemire(w, (int32_t) q);
+
+  if (negative)
+    bits |= 0x80000000U;
+
+  memcpy(value, &bits, sizeof(float));
+  return 1;
+}
+
+/*---------------------------------------------------------------------------------------------------------------*/
+
+#if __PROFILER
+
+#include <time.h>
+#include "assert_util.h"
+
+// PURPOSE: The number of fields converted by each benchmark.
+#define PROFILER_FIELD_COUNT 4000000
+
+// PURPOSE: The size of each field of the benchmark (fields are null-terminated and padded to this size).
+#define PROFILER_FIELD_SIZE 24
+
+// PURPOSE: Prints the throughput of a conversion.
+static void print_parser_result(const char *parser, const char *field, double checksum, clock_t start, clock_t end) {
+  double seconds;
+
+  seconds = (double) (end - start) / CLOCKS_PER_SEC;
+  printf("[PROFILER]<parser=%s, field=%s>: Converted %d fields in %f seconds (%.1f Mfields/s, checksum=%g).\n", parser,
+         field, PROFILER_FIELD_COUNT, seconds, seconds > 0 ? PROFILER_FIELD_COUNT / seconds / 1e6 : 0.0, checksum);
+}
+
+void profile__field_parsers(void) {
+  char *ints, *floats, *field;
+  size_t *lengths_int, *lengths_float;
+  int32_t int_value;
+  float float_value;
+  double checksum;
+  clock_t start, end;
+  size_t i;
+
+  ints = (char *) malloc((size_t) PROFILER_FIELD_COUNT * PROFILER_FIELD_SIZE);
+  floats = (char *) malloc((size_t) PROFILER_FIELD_COUNT * PROFILER_FIELD_SIZE);
+  lengths_int = (size_t *) malloc(sizeof(size_t) * PROFILER_FIELD_COUNT);
+  lengths_float = (size_t *) malloc(sizeof(size_t) * PROFILER_FIELD_COUNT);
+
+  ASSERT(ints && floats && lengths_int && lengths_float, "Unable to allocate memory for the benchmark fields",
+         profile__field_parsers);
+
+  // The fields have the same format as the ones of the record files.
+  srand(42);
+
+  for (i = 0; i < PROFILER_FIELD_COUNT; ++i) {
+    lengths_int[i] = (size_t) sprintf(ints + i * PROFILER_FIELD_SIZE, "%d", rand() - RAND_MAX / 2);
+    lengths_float[i] = (size_t) sprintf(floats + i * PROFILER_FIELD_SIZE, "%f",
+                                        (float) rand() / (float) (rand() % 1000 + 1));
+  }
+
+  checksum = 0;
+  start = clock();
+  for (i = 0; i < PROFILER_FIELD_COUNT; ++i)
+    checksum += (double) atoll(ints + i * PROFILER_FIELD_SIZE); // NOLINT(*-err34-c)
+  end = clock();
+  print_parser_result("atoll", "INTEGER", checksum, start, end);
+
+  int_value = 0;
+  checksum = 0;
+  start = clock();
+  for (i = 0; i < PROFILER_FIELD_COUNT; ++i) {
+    field = ints + i * PROFILER_FIELD_SIZE;
+    parse_int32(field, field + lengths_int[i], &int_value);
+    checksum += (double) int_value;
+  }
+  end = clock();
+  print_parser_result("parse_int32", "INTEGER", checksum, start, end);
+
+  checksum = 0;
+  start = clock();
+  for (i = 0; i < PROFILER_FIELD_COUNT; ++i)
+    checksum += (float) atof(floats + i * PROFILER_FIELD_SIZE); // NOLINT(*-err34-c)
+  end = clock();
+  print_parser_result("atof", "FLOAT", checksum, start, end);
+
+  float_value = 0;
+  checksum = 0;
+  start = clock();
+  for (i = 0; i < PROFILER_FIELD_COUNT; ++i) {
+    field = floats + i * PROFILER_FIELD_SIZE;
+    parse_float32(field, field + lengths_float[i], &float_value);
+    checksum += float_value;
+  }
+  end = clock();
+  print_parser_result("parse_float32", "FLOAT", checksum, start, end);
+
+  free(ints);
+  free(floats);
+  free(lengths_int);
+  free(lengths_float);
+}
+
+#endif
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <stdint.h>
+
+/**
+ * @brief Parses an unsigned decimal integer.
+ *
+ * @remark The parser is locale-independent, and consumes eight digits at a time when possible.
+ *
+ * @param begin Pointer to the first character of the field.
+ * @param end Pointer past the last character of the field.
+ * @param value The destination value.
+ * @return 1 if the whole field is a valid integer representable as a 64-bit unsigned integer, 0 otherwise.
+ */
+int parse_uint64(const char *begin, const char *end, uint64_t *value);
+
+/**
+ * @brief Parses a signed decimal integer (with an optional leading '+' or '-').
+ *
+ * @param begin Pointer to the first character of the field.
+ * @param end Pointer past the last character of the field.
+ * @param value The destination value.
+ * @return 1 if the whole field is a valid integer representable as a 32-bit signed integer, 0 otherwise.
+ */
+int parse_int32(const char *begin, const char *end, int32_t *value);
+
+/**
+ * @brief Parses a decimal floating-point number, rounding it correctly to the nearest float.
+ *
+ * @remark Numbers with at most 19 significant digits are converted with the Clinger fast path when exact, otherwise
+ * with the Eisel-Lemire algorithm. The other inputs (longer mantissas, infinities, NaNs) fall back to @c strtof.
+ *
+ * @param begin Pointer to the first character of the field.
+ * @param end Pointer past the last character of the field.
+ * @param value The destination value.
+ * @return 1 if the whole field is a valid number, 0 otherwise.
+ */
+int parse_float32(const char *begin, const char *end, float *value);
+
+#if __PROFILER
+
+/**
+ * @brief Profiles the throughput of the field parsers against the C library conversions (@c atoll and @c atof).
+ */
+void profile__field_parsers(void);
+
+#endif
@@ -14,10 +14,10 @@
 
 // PURPOSE: Perform binary search on a sorted array to find the correct position for an element.
 // NOTE: The sorted array is the sub-array with [0, upper - 1] bounds of the base array, which has [0, size - 1] bounds.
+// NOTE: The returned position follows every element equal to elem, so that the sorting is stable.
 static size_t binary_search(void *base, size_t size, void *elem, size_t upper, compare_fn compare) {
   size_t half, lower;
   void *half_elem;
-  int cmp_res;
 
   lower = 0;
 
@@ -25,18 +25,11 @@ static size_t binary_search(void *base, size_t size, void *elem, size_t upper, c
     half = (lower + upper) / 2;
     half_elem = GET_ELEMENT(base, half, size);
 
-    cmp_res = compare(elem, half_elem);
-
-    if (cmp_res == 0)
-      return half + 1;
-
-    if (cmp_res > 0) lower = half + 1;
-    else upper = half;
+    if (compare(elem, half_elem) < 0) upper = half;
+    else lower = half + 1;
   }
 
-  return compare(elem, GET_ELEMENT(base, lower, size)) > 0
-         ? lower + 1
-         : lower;
+  return lower;
 }
 
 /*---------------------------------------------------------------------------------------------------------------*/
@@ -50,16 +43,14 @@ static void *shift_right(void *base, size_t size, size_t insert_idx, size_t from
   pivot_dest = GET_ELEMENT(base, insert_idx + 1, size);
 
   shift_sz = (from_idx - insert_idx) * size;
-  ASSERT(memcpy(pivot_dest, pivot, shift_sz), "Unable to shift memory", shift_right);
+  ASSERT(memmove(pivot_dest, pivot, shift_sz), "Unable to shift memory", shift_right);
 
   return pivot;
 }
 
 /*---------------------------------------------------------------------------------------------------------------*/
 
-// PURPOSE: Sorts the given array using the binary insertion sort algorithm, using the specified compare function to
-//          compare elements.
-static void binary_insertion_sort(void *base, size_t count, size_t size, compare_fn compare) {
+void binary_insertion_sort(void *base, size_t count, size_t size, compare_fn compare) {
   size_t i, new_pos;
   void *current_elem, *src_elem, *dst_elem;
 
@@ -69,7 +60,7 @@ static void binary_insertion_sort(void *base, size_t count, size_t size, compare
 
   for (i = 1; i < count; ++i) {
     current_elem = GET_ELEMENT(base, i, size);
-    new_pos = binary_search(base, size, current_elem, i - 1, compare);
+    new_pos = binary_search(base, size, current_elem, i, compare);
 
     ASSERT(memcpy(src_elem, current_elem, size), "Unable to save a copy of the current element", binary_insertion_sort);
     dst_elem = shift_right(base, size, new_pos, i);
@@ -19,3 +19,18 @@
  * @note This operation has linearithmic time complexity O(N log N).
  */
 void merge_binary_insertion_sort(void *base, size_t count, size_t size, size_t threshold, compare_fn compare);
+
+/**
+ * @brief Sorts an array of generic items by binary insertion, as the merge binary insertion sort does for the
+ * partitions below its threshold.
+ *
+ * @remark Each item is inserted after the items equal to it, so the sort is stable.
+ *
+ * @param base      Pointer to the beginning of the array to be sorted.
+ * @param count     Number of elements in the array (which can be 0).
+ * @param size      Size of each element in the array, in bytes.
+ * @param compare   Pointer to the comparison function that defines the order of elements.
+ *
+ * @note This operation performs O(N log N) comparisons, but O(N^2) moves.
+ */
+void binary_insertion_sort(void *base, size_t count, size_t size, compare_fn compare);
@@ -0,0 +1,122 @@
+#include <malloc.h>
+#include <string.h>
+#include "multiway-merge-sort.h"
+#include "merge-binary-insertion-sort.h"
+#include "run-merger.h"
+#include "assert_util.h"
+
+/*---------------------------------------------------------------------------------------------------------------*/
+
+// PURPOSE: Returns the number of merge passes of a plan (every pass but the one which sorts the blocks).
+#define MERGE_PASS_COUNT(plan) ((plan)->pass_count - 1)
+
+/*---------------------------------------------------------------------------------------------------------------*/
+
+void plan_multiway_merge_sort(size_t count, size_t size, MultiwaySortPlan *plan) {
+  size_t run_count;
+
+  ASSERT_NULL_PARAMETER(plan, plan_multiway_merge_sort);
+  ASSERT(size > 0, "The element size cannot be zero", plan_multiway_merge_sort);
+
+  plan->block_items = MULTIWAY_SORT_BLOCK_BYTES / size > 0 ? MULTIWAY_SORT_BLOCK_BYTES / size : 1;
+  plan->block_count = (count + plan->block_items - 1) / plan->block_items;
+  plan->fan_in = MULTIWAY_SORT_BLOCK_BYTES / MULTIWAY_SORT_RUN_HEAD_BYTES;
+  plan->fan_in = plan->fan_in > 2 ? plan->fan_in : 2;
+  plan->pass_count = 1;
+  plan->bytes_per_pass = 2 * count * size;
+
+  for (run_count = plan->block_count; run_count > 1; run_count = (run_count + plan->fan_in - 1) / plan->fan_in)
+    plan->pass_count++;
+}
+
+/*---------------------------------------------------------------------------------------------------------------*/
+
+// PURPOSE: Sorts each block of the source array with the merge binary insertion sort, into the destination array
+//          (which can be the source array itself).
+static void sort_blocks(const unsigned char *src, unsigned char *dst, size_t count, size_t size, size_t threshold,
+                        compare_fn compare, const MultiwaySortPlan *plan) {
+  size_t begin, block_count;
+
+  for (begin = 0; begin < count; begin += block_count) {
+    block_count = count - begin < plan->block_items ? count - begin : plan->block_items;
+
+    if (src != dst)
+      memcpy(dst + begin * size, src + begin * size, block_count * size);
+
+    merge_binary_insertion_sort(dst + begin * size, block_count, size, threshold, compare);
+  }
+}
+
+/*---------------------------------------------------------------------------------------------------------------*/
+
+// PURPOSE: Merges each group of up to fan_in consecutive runs of the source array into the destination array.
+static void merge_runs(const unsigned char *src, unsigned char *dst, size_t count, size_t size, compare_fn compare,
+                       size_t run_items, size_t fan_in, void **runs, size_t *counts) {
+  RunMerger *merger;
+  const void *item;
+  size_t begin, run_begin, run_count;
+
+  for (begin = 0; begin < count; begin += run_items * fan_in) {
+    run_count = 0;
+
+    for (run_begin = begin; run_begin < count && run_count < fan_in; run_begin += run_items) {
+      runs[run_count] = (void *) (src + run_begin * size);
+      counts[run_count++] = count - run_begin < run_items ? count - run_begin : run_items;
+    }
+
+    new_run_merger(&merger, runs, counts, run_count, size, compare);
+
+    for (item = next_run_merger(merger); item; item = next_run_merger(merger)) {
+      memcpy(dst, item, size);
+      dst += size;
+    }
+
+    clear_run_merger(&merger);
+  }
+}
+
+/*---------------------------------------------------------------------------------------------------------------*/
+
+void multiway_merge_sort(void *base, size_t count, size_t size, size_t threshold, compare_fn compare) {
+  MultiwaySortPlan plan;
+  unsigned char *buffer, *src, *dst, *tmp;
+  void **runs;
+  size_t *counts, run_items, pass;
+
+  ASSERT_NULL_PARAMETER(base, multiway_merge_sort);
+  ASSERT_NULL_PARAMETER(compare, multiway_merge_sort);
+  ASSERT(count > 0, "The array must contain at least one element", multiway_merge_sort);
+  ASSERT(size > 0, "The element size cannot be zero", multiway_merge_sort);
+
+  plan_multiway_merge_sort(count, size, &plan);
+
+  if (MERGE_PASS_COUNT(&plan) == 0) {
+    merge_binary_insertion_sort(base, count, size, threshold, compare);
+    return;
+  }
+
+  buffer = (unsigned char *) malloc(count * size);
+  runs = (void **) malloc(sizeof(void *) * plan.fan_in);
+  counts = (size_t *) malloc(sizeof(size_t) * plan.fan_in);
+  ASSERT(buffer && runs && counts, "Unable to allocate memory for the multiway merge sort", multiway_merge_sort);
+
+  // The runs alternate between the two arrays at each merge pass, so that the last one ends into the array.
+  src = MERGE_PASS_COUNT(&plan) % 2 ? buffer : (unsigned char *) base;
+  dst = src == buffer ? (unsigned char *) base : buffer;
+  sort_blocks((unsigned char *) base, src, count, size, threshold, compare, &plan);
+
+  run_items = plan.block_items;
+
+  for (pass = 0; pass < MERGE_PASS_COUNT(&plan); ++pass) {
+    merge_runs(src, dst, count, size, compare, run_items, plan.fan_in, runs, counts);
+    run_items *= plan.fan_in;
+
+    tmp = src;
+    src = dst;
+    dst = tmp;
+  }
+
+  free(counts);
+  free(runs);
+  free(buffer);
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <stddef.h>
+#include "comparator.h"
+
+#ifndef MULTIWAY_SORT_BLOCK_BYTES
+/**
+ * @brief Defines the size, in bytes, of the blocks sorted by the first pass of the multiway merge sort. It should fit
+ * into the L2 cache, so that the merge binary insertion sort of a block does not touch the main memory.
+ *
+ * @remark This number can be changed by setting this macro before including this header file.
+ */
+#define MULTIWAY_SORT_BLOCK_BYTES (1 << 18)
+#endif
+
+#ifndef MULTIWAY_SORT_RUN_HEAD_BYTES
+/**
+ * @brief Defines the size, in bytes, of the head of each run which should stay in the cache while the runs are merged.
+ * The fan-in of the merge is <code>MULTIWAY_SORT_BLOCK_BYTES / MULTIWAY_SORT_RUN_HEAD_BYTES</code>, so that the heads
+ * of all the merged runs fit into the same cache as a block.
+ *
+ * @remark This number can be changed by setting this macro before including this header file.
+ */
+#define MULTIWAY_SORT_RUN_HEAD_BYTES (1 << 12)
+#endif
+
+/**
+ * @brief Describes how the multiway merge sort processes an array.
+ */
+typedef struct MultiwaySortPlan {
+  size_t block_items;  ///< Number of items of each block sorted by the first pass.
+  size_t block_count;  ///< Number of blocks (the initial sorted runs).
+  size_t fan_in;  ///< Max number of runs merged together.
+  size_t pass_count;  ///< Number of passes over the whole array, including the one which sorts the blocks.
+  size_t bytes_per_pass;  ///< Number of bytes read and written by each pass.
+} MultiwaySortPlan;
+
+/**
+ * @brief Computes how the multiway merge sort processes an array, without sorting it.
+ * @param count Number of elements in the array.
+ * @param size Size of each element in the array, in bytes.
+ * @param plan The plan to be filled.
+ */
+void plan_multiway_merge_sort(size_t count, size_t size, MultiwaySortPlan *plan);
+
+/**
+ * @brief Perform a stable, cache-aware multiway merge sort over an array of generic items.
+ *
+ * @remark The first pass sorts blocks of @c MULTIWAY_SORT_BLOCK_BYTES with the merge binary insertion sort, within
+ * the cache. Each following pass merges groups of up to @c fan_in sorted runs with a loser tree (see @c run-merger.h),
+ * alternating between the array and a temporary array, so that an array of @c n items takes
+ * <code>1 + ceil(log_fan_in(n / block_items))</code> passes over the main memory, instead of the
+ * <code>log2(n / threshold)</code> passes of the binary merges of the merge binary insertion sort (e.g. 3 passes
+ * instead of 21 for 1 GB of 32-byte records). When the number of merge passes is odd, the first pass copies the blocks
+ * into the temporary array before sorting them, so that the last pass always ends into the array.
+ *
+ * @param base      Pointer to the beginning of the array to be sorted.
+ * @param count     Number of elements in the array.
+ * @param size      Size of each element in the array, in bytes.
+ * @param threshold The threshold passed to the merge binary insertion sort of the blocks.
+ * @param compare   Pointer to the comparison function that defines the order of elements.
+ */
+void multiway_merge_sort(void *base, size_t count, size_t size, size_t threshold, compare_fn compare);
@@ -0,0 +1,380 @@
+#include <malloc.h>
+#include <string.h>
+#include "pdq-sort.h"
+#include "merge-binary-insertion-sort.h"
+#include "assert_util.h"
+
+/*---------------------------------------------------------------------------------------------------------------*/
+
+// PURPOSE: The max number of items moved by the insertion sort which finishes an already partitioned range, before
+//          it gives up (the range is then partitioned again).
+#define PARTIAL_INSERTION_LIMIT 8
+
+// PURPOSE: Gets a pointer to the item at the specified index of the sorted array.
+#define ITEM(ctx, index) ((ctx)->base + (index) * (ctx)->size)
+
+/*---------------------------------------------------------------------------------------------------------------*/
+
+// PURPOSE: Represents the array being sorted, and the buffers of the items moved out of it.
+typedef struct PdqContext {
+  unsigned char *base;
+  size_t size;
+  size_t threshold;
+  compare_fn compare;
+  unsigned char *pivot;  // The copy of the pivot of the current partitioning.
+  unsigned char *swap;  // The copy of an item being swapped or inserted.
+} PdqContext;
+
+/*---------------------------------------------------------------------------------------------------------------*/
+
+// PURPOSE: Returns 1 if the item a must precede the item b.
+static int less(const PdqContext *ctx, const void *a, const void *b) {
+  return ctx->compare(a, b) < 0;
+}
+
+/*---------------------------------------------------------------------------------------------------------------*/
+
+// PURPOSE: Swaps the items at the specified indices.
+static void swap_items(PdqContext *ctx, size_t a, size_t b) {
+  memcpy(ctx->swap, ITEM(ctx, a), ctx->size);
+  memcpy(ITEM(ctx, a), ITEM(ctx, b), ctx->size);
+  memcpy(ITEM(ctx, b), ctx->swap, ctx->size);
+}
+
+/*---------------------------------------------------------------------------------------------------------------*/
+
+// PURPOSE: Sorts the items at the three specified indices.
+static void sort_three_items(PdqContext *ctx, size_t a, size_t b, size_t c) {
+  if (less(ctx, ITEM(ctx, b), ITEM(ctx, a))) swap_items(ctx, a, b);
+  if (less(ctx, ITEM(ctx, c), ITEM(ctx, b))) swap_items(ctx, b, c);
+  if (less(ctx, ITEM(ctx, b), ITEM(ctx, a))) swap_items(ctx, a, b);
+}
+
+/*---------------------------------------------------------------------------------------------------------------*/
+
+// PURPOSE: Moves the max item of the heap [begin, begin + count) rooted at the specified node down to its place.
+static void sift_down(PdqContext *ctx, size_t begin, size_t root, size_t count) {
+  size_t child;
+
+  for (child = 2 * root + 1; child < count; root = child, child = 2 * root + 1) {
+    if (child + 1 < count && less(ctx, ITEM(ctx, begin + child), ITEM(ctx, begin + child + 1)))
+      child++;
+
+    if (!less(ctx, ITEM(ctx, begin + root), ITEM(ctx, begin + child)))
+      return;
+
+    swap_items(ctx, begin + root, begin + child);
+  }
+}
+
+/*---------------------------------------------------------------------------------------------------------------*/
+
+// PURPOSE: Sorts the range [begin, end) with a heapsort, which is never slower than O(N log N).
+static void heap_sort(PdqContext *ctx, size_t begin, size_t end) {
+  size_t count, i;
+
+  count = end - begin;
+
+  for (i = count / 2; i-- > 0;)
+    sift_down(ctx, begin, i, count);
+
+  for (i = count; i-- > 1;) {
+    swap_items(ctx, begin, begin + i);
+    sift_down(ctx, begin, 0, i);
+  }
+}
+
+/*---------------------------------------------------------------------------------------------------------------*/
+
+// PURPOSE: Sorts the range [begin, end) by insertion, unless more than PARTIAL_INSERTION_LIMIT items must be moved.
+//          Returns 1 if the range has been sorted, 0 if the sort has been given up.
+static int partial_insertion_sort(PdqContext *ctx, size_t begin, size_t end) {
+  size_t moved, current, position;
+
+  moved = 0;
+
+  for (current = begin + 1; current < end; ++current) {
+    if (moved > PARTIAL_INSERTION_LIMIT)
+      return 0;
+
+    if (!less(ctx, ITEM(ctx, current), ITEM(ctx, current - 1)))
+      continue;
+
+    memcpy(ctx->swap, ITEM(ctx, current), ctx->size);
+
+    for (position = current - 1; position > begin && less(ctx, ctx->swap, ITEM(ctx, position - 1)); --position);
+
+    memmove(ITEM(ctx, position + 1), ITEM(ctx, position), (current - position) * ctx->size);
+    memcpy(ITEM(ctx, position), ctx->swap, ctx->size);
+    moved += current - position;
+  }
+
+  return 1;
+}
+
+/*---------------------------------------------------------------------------------------------------------------*/
+
+// PURPOSE: Swaps the misplaced items found by the block partitioning: the left items are at the offsets following
+//          left_base, the right ones at the offsets preceding right_base.
+// NOTE: If both blocks hold the same number of items, they are swapped pairwise (otherwise the descending inputs would
+//       take quadratic time), else they are moved along a single cycle, which copies each item only once.
+static void swap_offsets(PdqContext *ctx, size_t left_base, size_t right_base, const unsigned char *offsets_l,
+                         const unsigned char *offsets_r, size_t count, int use_swaps) {
+  size_t left, right, i;
+
+  if (use_swaps) {
+    for (i = 0; i < count; ++i)
+      swap_items(ctx, left_base + offsets_l[i], right_base - offsets_r[i]);
+
+    return;
+  }
+
+  if (count == 0)
+    return;
+
+  left = left_base + offsets_l[0];
+  right = right_base - offsets_r[0];
+  memcpy(ctx->swap, ITEM(ctx, left), ctx->size);
+  memcpy(ITEM(ctx, left), ITEM(ctx, right), ctx->size);
+
+  for (i = 1; i < count; ++i) {
+    left = left_base + offsets_l[i];
+    memcpy(ITEM(ctx, right), ITEM(ctx, left), ctx->size);
+    right = right_base - offsets_r[i];
+    memcpy(ITEM(ctx, left), ITEM(ctx, right), ctx->size);
+  }
+
+  memcpy(ITEM(ctx, right), ctx->swap, ctx->size);
+}
+
+/*---------------------------------------------------------------------------------------------------------------*/
+
+// PURPOSE: Partitions the range [begin, end) around the pivot at begin: the smaller items are moved before it, the
+//          others after it. Returns the position of the pivot, and whether the range was already partitioned.
+// NOTE: The pivot is the median of three items, so an item not smaller than it guards the scan from the left.
+//       The items are compared with the pivot a block at a time on each side (BlockQuicksort), storing the offsets
+//       of the misplaced items without branching on the results of the comparisons.
+static size_t partition_right(PdqContext *ctx, size_t begin, size_t end, int *already_partitioned) {
+  unsigned char offsets_l[PDQ_SORT_BLOCK_SIZE], offsets_r[PDQ_SORT_BLOCK_SIZE];
+  size_t first, last, left_base, right_base, num_l, num_r, start_l, start_r, left_split, right_split, count, i;
+
+  memcpy(ctx->pivot, ITEM(ctx, begin), ctx->size);
+  first = begin;
+  last = end;
+
+  while (less(ctx, ITEM(ctx, ++first), ctx->pivot));
+
+  // The scan from the right is guarded only if no item before first is smaller than the pivot.
+  if (first - 1 == begin) while (first < last && !less(ctx, ITEM(ctx, --last), ctx->pivot));
+  else while (!less(ctx, ITEM(ctx, --last), ctx->pivot));
+
+  *already_partitioned = first >= last;
+
+  if (!*already_partitioned) {
+    swap_items(ctx, first, last);
+    ++first;
+
+    left_base = first;
+    right_base = last;
+    num_l = num_r = start_l = start_r = 0;
+
+    while (first < last) {
+      // Each empty block is filled with the next (at most PDQ_SORT_BLOCK_SIZE) items of its side.
+      left_split = num_l == 0 ? (num_r == 0 ? (last - first) / 2 : last - first) : 0;
+      right_split = num_r == 0 ? (last - first) - left_split : 0;
+
+      if (left_split > PDQ_SORT_BLOCK_SIZE) left_split = PDQ_SORT_BLOCK_SIZE;
+      if (right_split > PDQ_SORT_BLOCK_SIZE) right_split = PDQ_SORT_BLOCK_SIZE;
+
+      for (i = 0; i < left_split;) {
+        offsets_l[num_l] = (unsigned char) i++;
+        num_l += !less(ctx, ITEM(ctx, first), ctx->pivot);
+        ++first;
+      }
+
+      for (i = 0; i < right_split;) {
+        offsets_r[num_r] = (unsigned char) ++i;
+        num_r += less(ctx, ITEM(ctx, --last), ctx->pivot);
+      }
+
+      count = num_l < num_r ? num_l : num_r;
+      swap_offsets(ctx, left_base, right_base, offsets_l + start_l, offsets_r + start_r, count, num_l == num_r);
+
+      num_l -= count;
+      num_r -= count;
+      start_l += count;
+      start_r += count;
+
+      if (num_l == 0) {
+        start_l = 0;
+        left_base = first;
+      }
+
+      if (num_r == 0) {
+        start_r = 0;
+        right_base = last;
+      }
+    }
+
+    // The misplaced items left in a block are swapped with the items next to the boundary.
+    if (num_l > 0) {
+      while (num_l-- > 0)
+        swap_items(ctx, left_base + offsets_l[start_l + num_l], --last);
+
+      first = last;
+    }
+
+    if (num_r > 0) {
+      while (num_r-- > 0)
+        swap_items(ctx, right_base - offsets_r[start_r + num_r], first++);
+
+      last = first;
+    }
+  }
+
+  memcpy(ITEM(ctx, begin), ITEM(ctx, first - 1), ctx->size);
+  memcpy(ITEM(ctx, first - 1), ctx->pivot, ctx->size);
+  return first - 1;
+}
+
+/*---------------------------------------------------------------------------------------------------------------*/
+
+// PURPOSE: Partitions the range [begin, end) around the pivot at begin, moving the items equal to it before it, and
+//          returns the position of the pivot.
+// NOTE: It is used when the pivot is equal to the item preceding the range (the pivot of a previous partitioning):
+//       no item of the range is smaller, so the items before the pivot are all equal and need no sorting.
+static size_t partition_left(PdqContext *ctx, size_t begin, size_t end) {
+  size_t first, last;
+
+  memcpy(ctx->pivot, ITEM(ctx, begin), ctx->size);
+  first = begin;
+  last = end;
+
+  while (less(ctx, ctx->pivot, ITEM(ctx, --last)));
+
+  if (last + 1 == end) while (first < last && !less(ctx, ctx->pivot, ITEM(ctx, ++first)));
+  else while (!less(ctx, ctx->pivot, ITEM(ctx, ++first)));
+
+  while (first < last) {
+    swap_items(ctx, first, last);
+    while (less(ctx, ctx->pivot, ITEM(ctx, --last)));
+    while (!less(ctx, ctx->pivot, ITEM(ctx, ++first)));
+  }
+
+  memcpy(ITEM(ctx, begin), ITEM(ctx, last), ctx->size);
+  memcpy(ITEM(ctx, last), ctx->pivot, ctx->size);
+  return last;
+}
+
+/*---------------------------------------------------------------------------------------------------------------*/
+
+// PURPOSE: Sorts the range [begin, end), recursing on the left partitions and looping on the right ones.
+// NOTE: bad_allowed is the number of unbalanced partitionings left before switching to heapsort, and leftmost is 1 if
+//       no item precedes the range.
+static void pdq_sort_range(PdqContext *ctx, size_t begin, size_t end, int bad_allowed, int leftmost) { // NOLINT(*-no-recursion)
+  size_t count, half, pivot_pos, l_size, r_size;
+  int already_partitioned;
+
+  for (;;) {
+    count = end - begin;
+
+    if (count <= ctx->threshold || count < PDQ_SORT_MIN_COUNT) {
+      binary_insertion_sort(ITEM(ctx, begin), count, ctx->size, ctx->compare);
+      return;
+    }
+
+    // The pivot (the median of 3 or the pseudo-median of 9) is moved to begin.
+    half = count / 2;
+
+    if (count > PDQ_SORT_NINTHER_THRESHOLD) {
+      sort_three_items(ctx, begin, begin + half, end - 1);
+      sort_three_items(ctx, begin + 1, begin + half - 1, end - 2);
+      sort_three_items(ctx, begin + 2, begin + half + 1, end - 3);
+      sort_three_items(ctx, begin + half - 1, begin + half, begin + half + 1);
+      swap_items(ctx, begin, begin + half);
+    } else {
+      sort_three_items(ctx, begin + half, begin, end - 1);
+    }
+
+    if (!leftmost && !less(ctx, ITEM(ctx, begin - 1), ITEM(ctx, begin))) {
+      begin = partition_left(ctx, begin, end) + 1;
+      continue;
+    }
+
+    pivot_pos = partition_right(ctx, begin, end, &already_partitioned);
+    l_size = pivot_pos - begin;
+    r_size = end - (pivot_pos + 1);
+
+    if (l_size < count / 8 || r_size < count / 8) {
+      if (--bad_allowed == 0) {
+        heap_sort(ctx, begin, end);
+        return;
+      }
+
+      // Some items of the unbalanced partitions are swapped, to break the patterns which defeat the pivot selection.
+      if (l_size >= PDQ_SORT_MIN_COUNT) {
+        swap_items(ctx, begin, begin + l_size / 4);
+        swap_items(ctx, pivot_pos - 1, pivot_pos - l_size / 4);
+
+        if (l_size > PDQ_SORT_NINTHER_THRESHOLD) {
+          swap_items(ctx, begin + 1, begin + (l_size / 4 + 1));
+          swap_items(ctx, begin + 2, begin + (l_size / 4 + 2));
+          swap_items(ctx, pivot_pos - 2, pivot_pos - (l_size / 4 + 1));
+          swap_items(ctx, pivot_pos - 3, pivot_pos - (l_size / 4 + 2));
+        }
+      }
+
+      if (r_size >= PDQ_SORT_MIN_COUNT) {
+        swap_items(ctx, pivot_pos + 1, pivot_pos + (1 + r_size / 4));
+        swap_items(ctx, end - 1, end - r_size / 4);
+
+        if (r_size > PDQ_SORT_NINTHER_THRESHOLD) {
+          swap_items(ctx, pivot_pos + 2, pivot_pos + (2 + r_size / 4));
+          swap_items(ctx, pivot_pos + 3, pivot_pos + (3 + r_size / 4));
+          swap_items(ctx, end - 2, end - (1 + r_size / 4));
+          swap_items(ctx, end - 3, end - (2 + r_size / 4));
+        }
+      }
+    } else if (already_partitioned && partial_insertion_sort(ctx, begin, pivot_pos) &&
+               partial_insertion_sort(ctx, pivot_pos + 1, end)) {
+      // The range was probably sorted already.
+      return;
+    }
+
+    pdq_sort_range(ctx, begin, pivot_pos, bad_allowed, leftmost);
+    begin = pivot_pos + 1;
+    leftmost = 0;
+  }
+}
+
+/*---------------------------------------------------------------------------------------------------------------*/
+
+void pdq_sort(void *base, size_t count, size_t size, size_t threshold, compare_fn compare) {
+  PdqContext ctx;
+  int bad_allowed;
+  size_t n;
+
+  ASSERT(base || !count, "'base' parameter is NULL", pdq_sort);
+  ASSERT_NULL_PARAMETER(compare, pdq_sort);
+  ASSERT(size > 0, "The element size cannot be zero", pdq_sort);
+
+  if (count < 2)
+    return;
+
+  ctx.base = (unsigned char *) base;
+  ctx.size = size;
+  ctx.threshold = threshold;
+  ctx.compare = compare;
+  ctx.pivot = (unsigned char *) malloc(size);
+  ctx.swap = (unsigned char *) malloc(size);
+  ASSERT(ctx.pivot && ctx.swap, "Unable to allocate memory for the moved items", pdq_sort);
+
+  // Up to log2(count) unbalanced partitionings are allowed.
+  for (bad_allowed = 0, n = count; n > 1; n >>= 1)
+    bad_allowed++;
+
+  pdq_sort_range(&ctx, 0, count, bad_allowed, 1);
+
+  free(ctx.pivot);
+  free(ctx.swap);
+}
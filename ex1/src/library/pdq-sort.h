@@ -0,0 +1,56 @@
+#pragma once
+
+#include <stddef.h>
+#include "comparator.h"
+
+#ifndef PDQ_SORT_BLOCK_SIZE
+/**
+ * @brief The number of items whose comparisons with the pivot are buffered by each side of the block partitioning.
+ *
+ * @remark This number can be changed by setting this macro before including this header file.
+ * @note The offsets of the buffered items are stored in bytes, so it cannot be larger than 255.
+ */
+#define PDQ_SORT_BLOCK_SIZE 64
+#endif
+
+#ifndef PDQ_SORT_NINTHER_THRESHOLD
+/**
+ * @brief The number of items above which the pivot is the pseudo-median of 9 items, rather than the median of 3.
+ *
+ * @remark This number can be changed by setting this macro before including this header file.
+ */
+#define PDQ_SORT_NINTHER_THRESHOLD 128
+#endif
+
+#ifndef PDQ_SORT_MIN_COUNT
+/**
+ * @brief The number of items below which a partition is always sorted by binary insertion, whatever the threshold.
+ *
+ * @remark This number can be changed by setting this macro before including this header file.
+ * @note The selection of the pivot and the shuffling of the unbalanced partitions need at least a few items.
+ */
+#define PDQ_SORT_MIN_COUNT 16
+#endif
+
+/**
+ * @brief Sorts an array of generic items with a pattern-defeating quicksort (pdqsort), which is not stable but sorts
+ * in place.
+ *
+ * @remark The partitions are split around the median of 3 items (the pseudo-median of 9 for the large ones) by a
+ * BlockQuicksort partitioning: the comparisons with the pivot of a block of items on each side are stored as offsets
+ * without branching, then the misplaced items are swapped in bulk. The partitions not longer than the threshold are
+ * sorted by the binary insertion sort of @c merge-binary-insertion-sort.h. An already partitioned range is finished
+ * by a bounded insertion sort (so sorted inputs take linear time), the runs of items equal to the previous pivot are
+ * skipped at once, the unbalanced partitions are shuffled to break the patterns, and too many of them fall back to a
+ * heapsort, which bounds the worst case to O(N log N).
+ *
+ * @remark Unlike the merge sorts, no temporary array is allocated (the recursion depth is O(log N)), but the items
+ * which compare equal can be reordered.
+ *
+ * @param base      Pointer to the beginning of the array to be sorted.
+ * @param count     Number of elements in the array.
+ * @param size      Size of each element in the array, in bytes.
+ * @param threshold The length of the partitions below which the algorithm switches to binary insertion sort.
+ * @param compare   Pointer to the comparison function that defines the order of elements.
+ */
+void pdq_sort(void *base, size_t count, size_t size, size_t threshold, compare_fn compare);
@@ -0,0 +1,221 @@
+#include <malloc.h>
+#include <string.h>
+#include <stdlib.h>
+#include "record-columns.h"
+#include "branchless-merge-sort.h"
+#include "assert_util.h"
+
+/*---------------------------------------------------------------------------------------------------------------*/
+
+// PURPOSE: Pairs an integer key with the index of its record.
+// NOTE: The key is the first member, so the pair can be compared with int_comparator.
+typedef struct IntKey {
+  int32_t key;
+  uint32_t index;
+} IntKey;
+
+// PURPOSE: Pairs a float key with the index of its record.
+// NOTE: The key is the first member, so the pair can be compared with float_comparator.
+typedef struct FloatKey {
+  float key;
+  uint32_t index;
+} FloatKey;
+
+// PURPOSE: Pairs a string key with the index of its record.
+// NOTE: The key is the first member, so the pair can be compared with string_comparator.
+typedef struct StringKey {
+  char key[STRING_FIELD_LEN];
+  uint32_t index;
+} StringKey;
+
+/*---------------------------------------------------------------------------------------------------------------*/
+
+void new_record_columns(RecordColumns **columns, size_t capacity) {
+  ASSERT_NULL_PARAMETER(columns, new_record_columns);
+  ASSERT(capacity > 0, "The capacity of the columns must be > 0", new_record_columns);
+
+  *columns = (RecordColumns *) malloc(sizeof(RecordColumns));
+  ASSERT(*columns, "Unable to allocate memory for the record columns", new_record_columns);
+
+  (*columns)->count = 0;
+  (*columns)->capacity = capacity;
+  (*columns)->ids = (uint64_t *) malloc(sizeof(uint64_t) * capacity);
+  (*columns)->string_fields = (char (*)[STRING_FIELD_LEN]) malloc(STRING_FIELD_LEN * capacity);
+  (*columns)->int_fields = (int32_t *) malloc(sizeof(int32_t) * capacity);
+  (*columns)->float_fields = (float *) malloc(sizeof(float) * capacity);
+
+  ASSERT((*columns)->ids && (*columns)->string_fields && (*columns)->int_fields && (*columns)->float_fields,
+         "Unable to allocate memory for a record column", new_record_columns);
+}
+
+/*---------------------------------------------------------------------------------------------------------------*/
+
+void clear_record_columns(RecordColumns **columns) {
+  ASSERT_NULL_PARAMETER(columns, clear_record_columns);
+  ASSERT_NULL_PARAMETER(*columns, clear_record_columns);
+  ASSERT((*columns)->capacity > 0, "The columns are not owned", clear_record_columns);
+
+  free((*columns)->ids);
+  free((*columns)->string_fields);
+  free((*columns)->int_fields);
+  free((*columns)->float_fields);
+  free(*columns);
+  *columns = NULL;
+}
+
+/*---------------------------------------------------------------------------------------------------------------*/
+
+// PURPOSE: Doubles the capacity of the columns.
+static void grow_record_columns(RecordColumns *columns) {
+  columns->capacity *= 2;
+  columns->ids = (uint64_t *) realloc(columns->ids, sizeof(uint64_t) * columns->capacity);
+  columns->string_fields = (char (*)[STRING_FIELD_LEN]) realloc(columns->string_fields,
+                                                                STRING_FIELD_LEN * columns->capacity);
+  columns->int_fields = (int32_t *) realloc(columns->int_fields, sizeof(int32_t) * columns->capacity);
+  columns->float_fields = (float *) realloc(columns->float_fields, sizeof(float) * columns->capacity);
+
+  ASSERT(columns->ids && columns->string_fields && columns->int_fields && columns->float_fields,
+         "Unable to allocate memory for a record column", grow_record_columns);
+}
+
+/*---------------------------------------------------------------------------------------------------------------*/
+
+void push_record_columns(RecordColumns *columns, const Record *record) {
+  size_t i;
+
+  ASSERT_NULL_PARAMETER(columns, push_record_columns);
+  ASSERT_NULL_PARAMETER(record, push_record_columns);
+  ASSERT(columns->capacity > 0, "The columns are not owned", push_record_columns);
+
+  if (columns->count == columns->capacity)
+    grow_record_columns(columns);
+
+  i = columns->count++;
+  columns->ids[i] = (uint64_t) record->id;
+  memcpy(columns->string_fields[i], record->string_field, STRING_FIELD_LEN);
+  columns->int_fields[i] = (int32_t) record->int_field;
+  columns->float_fields[i] = record->float_field;
+}
+
+/*---------------------------------------------------------------------------------------------------------------*/
+
+void get_record_columns(const RecordColumns *columns, size_t index, Record *record) {
+  ASSERT_NULL_PARAMETER(columns, get_record_columns);
+  ASSERT_NULL_PARAMETER(record, get_record_columns);
+  ASSERT(index < columns->count, "The record index is out of range", get_record_columns);
+
+  record->id = (size_t) columns->ids[index];
+  memcpy(record->string_field, columns->string_fields[index], STRING_FIELD_LEN);
+  record->int_field = columns->int_fields[index];
+  record->float_field = columns->float_fields[index];
+}
+
+/*---------------------------------------------------------------------------------------------------------------*/
+
+// PURPOSE: Fills the key array with the key column of the specified field, paired with the index of each record.
+static void *make_keys(const RecordColumns *columns, FieldId field_id, size_t *key_size) {
+  IntKey *int_keys;
+  FloatKey *float_keys;
+  StringKey *string_keys;
+  size_t i;
+
+  switch (field_id) {
+    case FIELD_INTEGER:
+      *key_size = sizeof(IntKey);
+      int_keys = (IntKey *) malloc(sizeof(IntKey) * columns->count);
+      ASSERT(int_keys, "Unable to allocate memory for the key column", make_keys);
+
+      for (i = 0; i < columns->count; ++i) {
+        int_keys[i].key = columns->int_fields[i];
+        int_keys[i].index = (uint32_t) i;
+      }
+
+      return int_keys;
+    case FIELD_FLOAT:
+      *key_size = sizeof(FloatKey);
+      float_keys = (FloatKey *) malloc(sizeof(FloatKey) * columns->count);
+      ASSERT(float_keys, "Unable to allocate memory for the key column", make_keys);
+
+      for (i = 0; i < columns->count; ++i) {
+        // Negative zeros compare equal to positive ones, but are ordered before them by the vectorized merges.
+        float_keys[i].key = columns->float_fields[i] == 0.f ? 0.f : columns->float_fields[i];
+        float_keys[i].index = (uint32_t) i;
+      }
+
+      return float_keys;
+    case FIELD_STRING:
+      *key_size = sizeof(StringKey);
+      string_keys = (StringKey *) malloc(sizeof(StringKey) * columns->count);
+      ASSERT(string_keys, "Unable to allocate memory for the key column", make_keys);
+
+      for (i = 0; i < columns->count; ++i) {
+        memcpy(string_keys[i].key, columns->string_fields[i], STRING_FIELD_LEN);
+        string_keys[i].index = (uint32_t) i;
+      }
+
+      return string_keys;
+  }
+
+  PRINT_ERROR("Invalid field ID", make_keys);
+  return NULL;
+}
+
+/*---------------------------------------------------------------------------------------------------------------*/
+
+// PURPOSE: Returns the comparator of the key pairs of the specified field.
+static compare_fn get_key_comparator(FieldId field_id) {
+  switch (field_id) {
+    case FIELD_STRING:
+      return string_comparator;
+    case FIELD_INTEGER:
+      return int_comparator;
+    case FIELD_FLOAT:
+      return float_comparator;
+  }
+
+  PRINT_ERROR("Invalid field ID", get_key_comparator);
+  return NULL;
+}
+
+/*---------------------------------------------------------------------------------------------------------------*/
+
+SortStrategy sort_record_permutation(const RecordColumns *columns, FieldId field_id, size_t sorting_threshold,
+                                     const SortOptions *options, uint32_t *permutation) {
+  SortStrategy strategy;
+  void *keys;
+  size_t key_size, index_offset, i;
+
+  ASSERT_NULL_PARAMETER(columns, sort_record_permutation);
+  ASSERT_NULL_PARAMETER(options, sort_record_permutation);
+  ASSERT_NULL_PARAMETER(permutation, sort_record_permutation);
+  ASSERT(columns->count <= UINT32_MAX, "Too many records to be indexed by a permutation", sort_record_permutation);
+
+  if (columns->count == 0)
+    return SORT_STRATEGY_MERGE_BINARY_INSERTION;
+
+  if (field_id == FIELD_INTEGER && counting_sort_permutation(columns->int_fields, columns->count, permutation))
+    return SORT_STRATEGY_COUNTING;
+
+  keys = make_keys(columns, field_id, &key_size);
+
+  // The branchless merge sort of the numeric keys replaces the merge binary insertion sort, as for the records.
+  if (options->engine == SORT_ENGINE_MERGE_BINARY_INSERTION && field_id == FIELD_INTEGER) {
+    branchless_merge_sort_int_pairs(keys, columns->count, sorting_threshold);
+    strategy = SORT_STRATEGY_BRANCHLESS_MERGE;
+  } else if (options->engine == SORT_ENGINE_MERGE_BINARY_INSERTION && field_id == FIELD_FLOAT) {
+    branchless_merge_sort_float_pairs(keys, columns->count, sorting_threshold);
+    strategy = SORT_STRATEGY_BRANCHLESS_MERGE;
+  } else {
+    strategy = sort_items_with_engine(keys, columns->count, key_size, sorting_threshold, get_key_comparator(field_id),
+                                      options);
+  }
+
+  // The index is always the last member of a key pair.
+  index_offset = key_size - sizeof(uint32_t);
+
+  for (i = 0; i < columns->count; ++i)
+    memcpy(&permutation[i], (unsigned char *) keys + i * key_size + index_offset, sizeof(uint32_t));
+
+  free(keys);
+  return strategy;
+}
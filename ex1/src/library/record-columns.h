@@ -0,0 +1,70 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include "record.h"
+#include "records-sorter.h"
+#include "counting-sort.h"
+
+/**
+ * @brief Represents a set of records stored as a structure of arrays, one array (column) per field.
+ *
+ * @remark Sorting a column layout never moves the columns: only the key column is copied, together with the original
+ * index of each record, and sorted. The resulting permutation is then used to gather the other fields.
+ */
+typedef struct RecordColumns {
+  size_t count;  ///< Number of records stored in the columns.
+  size_t capacity;  ///< Number of records that the columns can hold before growing (0 if the columns are not owned).
+  uint64_t *ids;  ///< Column of the record ids.
+  char (*string_fields)[STRING_FIELD_LEN];  ///< Column of the string fields.
+  int32_t *int_fields;  ///< Column of the integer fields.
+  float *float_fields;  ///< Column of the float fields.
+} RecordColumns;
+
+/**
+ * @brief Allocates empty columns able to hold the specified number of records before growing.
+ * @param columns Pointer to the pointer that will hold the columns.
+ * @param capacity Initial number of records that the columns can hold (> 0).
+ */
+void new_record_columns(RecordColumns **columns, size_t capacity);
+
+/**
+ * @brief Deallocates the specified columns.
+ * @param columns Pointer to the columns to be cleared.
+ * @note Only columns allocated by @c new_record_columns can be cleared.
+ */
+void clear_record_columns(RecordColumns **columns);
+
+/**
+ * @brief Appends a record to the columns, growing them if they are full.
+ * @param columns The columns in which the record will be stored.
+ * @param record The record to be stored.
+ */
+void push_record_columns(RecordColumns *columns, const Record *record);
+
+/**
+ * @brief Copies the record at the specified index out of the columns.
+ * @param columns The columns from which the record will be read.
+ * @param index The index of the record.
+ * @param record The destination record.
+ */
+void get_record_columns(const RecordColumns *columns, size_t index, Record *record);
+
+/**
+ * @brief Computes the permutation which sorts the records by the specified field.
+ *
+ * @remark Only the key column and the original index of each record are moved by the sorting algorithm, so the cost
+ * of each sorting pass depends on the size of the key rather than on the size of the whole record. The order of
+ * records with equal keys is preserved. The integer fields are sorted by counting sort when their range is small (see
+ * @c counting_sort_permutation).
+ *
+ * @param columns The columns containing the records.
+ * @param field_id The type of the fields to be sorted.
+ * @param sorting_threshold The sorting threshold to be passed to the sorting algorithm.
+ * @param options The options of the sorter (the engine and its number of threads).
+ * @param permutation The destination array, which must be able to hold @c columns->count indices. After the call,
+ * @c permutation[i] is the index of the i-th record in sorted order.
+ * @return The strategy by which the records have been sorted.
+ */
+SortStrategy sort_record_permutation(const RecordColumns *columns, FieldId field_id, size_t sorting_threshold,
+                                     const SortOptions *options, uint32_t *permutation);
@@ -0,0 +1,40 @@
+#include "record-comparator.h"
+#include "record.h"
+#include "assert_util.h"
+
+/*---------------------------------------------------------------------------------------------------------------*/
+
+// PURPOSE: Compares two records by their string field.
+static int compare_records_by_string_fn(const void *record_a, const void *record_b) {
+  return string_comparator(((const Record *) record_a)->string_field, ((const Record *) record_b)->string_field);
+}
+
+/*---------------------------------------------------------------------------------------------------------------*/
+
+// PURPOSE: Compares two records by their integer field.
+static int compare_records_by_int_fn(const void *record_a, const void *record_b) {
+  return int_comparator(&((const Record *) record_a)->int_field, &((const Record *) record_b)->int_field);
+}
+
+/*---------------------------------------------------------------------------------------------------------------*/
+
+// PURPOSE: Compares two records by their float field.
+static int compare_records_by_float_fn(const void *record_a, const void *record_b) {
+  return float_comparator(&((const Record *) record_a)->float_field, &((const Record *) record_b)->float_field);
+}
+
+/*---------------------------------------------------------------------------------------------------------------*/
+
+compare_fn get_record_comparator(FieldId field_id) {
+  switch (field_id) {
+    case FIELD_STRING:
+      return compare_records_by_string_fn;
+    case FIELD_INTEGER:
+      return compare_records_by_int_fn;
+    case FIELD_FLOAT:
+      return compare_records_by_float_fn;
+  }
+
+  PRINT_ERROR("Invalid field ID", get_record_comparator);
+  return NULL;
+}
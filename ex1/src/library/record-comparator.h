@@ -0,0 +1,15 @@
+#pragma once
+
+#include "comparator.h"
+#include "records-sorter.h"
+
+/**
+ * @brief Returns the comparator of the records (@c Record) by the specified field.
+ *
+ * @remark The field is selected once, when the comparator is requested, so the returned comparator does not need to
+ * inspect any global state and can be shared by multiple threads.
+ *
+ * @param field_id The type of the fields to be compared.
+ * @return The comparator of the records by the specified field.
+ */
+compare_fn get_record_comparator(FieldId field_id);
@@ -0,0 +1,195 @@
+#include <malloc.h>
+#include <string.h>
+#include <stdlib.h>
+#include "record-filter.h"
+#include "field-parsers.h"
+#include "assert_util.h"
+
+/*---------------------------------------------------------------------------------------------------------------*/
+
+// PURPOSE: Returns 1 if the result of a three-way comparison satisfies the operator.
+#define TEST_OPERATOR(op, cmp_res)                            \
+    ((op) == FILTER_EQUAL ? (cmp_res) == 0 :                  \
+     (op) == FILTER_NOT_EQUAL ? (cmp_res) != 0 :              \
+     (op) == FILTER_LESS ? (cmp_res) < 0 :                    \
+     (op) == FILTER_LESS_EQUAL ? (cmp_res) <= 0 :             \
+     (op) == FILTER_GREATER ? (cmp_res) > 0 :                 \
+     (cmp_res) >= 0)
+
+// PURPOSE: Compares two numbers, returning a negative, zero or positive value.
+#define COMPARE_NUMBERS(a, b) (((a) > (b)) - ((a) < (b)))
+
+/*---------------------------------------------------------------------------------------------------------------*/
+
+// PURPOSE: Associates the name of a field with its identifier.
+typedef struct FieldName {
+  const char *name;
+  FilterField field;
+} FieldName;
+
+// PURPOSE: Associates the symbol of an operator with its identifier.
+// NOTE: The two-character symbols precede their one-character prefixes, so that the longest symbol is matched.
+typedef struct OperatorSymbol {
+  const char *symbol;
+  FilterOperator op;
+} OperatorSymbol;
+
+static const FieldName g_field_names[] = {
+    {"id", FILTER_FIELD_ID},
+    {"string_field", FILTER_FIELD_STRING},
+    {"int_field", FILTER_FIELD_INTEGER},
+    {"float_field", FILTER_FIELD_FLOAT}
+};
+
+static const OperatorSymbol g_operator_symbols[] = {
+    {"!=", FILTER_NOT_EQUAL},
+    {"<=", FILTER_LESS_EQUAL},
+    {">=", FILTER_GREATER_EQUAL},
+    {"^=", FILTER_PREFIX},
+    {"=", FILTER_EQUAL},
+    {"<", FILTER_LESS},
+    {">", FILTER_GREATER}
+};
+
+/*---------------------------------------------------------------------------------------------------------------*/
+
+void new_record_filter(RecordFilter **filter) {
+  ASSERT_NULL_PARAMETER(filter, new_record_filter);
+
+  *filter = (RecordFilter *) malloc(sizeof(RecordFilter));
+  ASSERT(*filter, "Unable to allocate memory for the record filter", new_record_filter);
+
+  (*filter)->predicates = NULL;
+  (*filter)->count = (*filter)->capacity = 0;
+}
+
+/*---------------------------------------------------------------------------------------------------------------*/
+
+void clear_record_filter(RecordFilter **filter) {
+  ASSERT_NULL_PARAMETER(filter, clear_record_filter);
+  ASSERT_NULL_PARAMETER(*filter, clear_record_filter);
+
+  free((*filter)->predicates);
+  free(*filter);
+  *filter = NULL;
+}
+
+/*---------------------------------------------------------------------------------------------------------------*/
+
+// PURPOSE: Parses the operand of a predicate, according to the type of the tested field.
+static int parse_operand(FilterPredicate *predicate, const char *begin, const char *end) {
+  switch (predicate->field) {
+    case FILTER_FIELD_ID:
+      return parse_uint64(begin, end, &predicate->operand.id);
+    case FILTER_FIELD_INTEGER:
+      return parse_int32(begin, end, &predicate->operand.integer);
+    case FILTER_FIELD_FLOAT:
+      return parse_float32(begin, end, &predicate->operand.real);
+    case FILTER_FIELD_STRING:
+      // The string fields are truncated when loaded, so the operand is truncated in the same way.
+      predicate->operand_length = (size_t) (end - begin);
+      if (predicate->operand_length >= STRING_FIELD_LEN)
+        predicate->operand_length = STRING_FIELD_LEN - 1;
+
+      memcpy(predicate->operand.string, begin, predicate->operand_length);
+      predicate->operand.string[predicate->operand_length] = '\0';
+      return 1;
+  }
+
+  return 0;
+}
+
+/*---------------------------------------------------------------------------------------------------------------*/
+
+int add_record_filter(RecordFilter *filter, const char *expression) {
+  FilterPredicate predicate;
+  const char *op_start;
+  size_t name_length, i;
+
+  ASSERT_NULL_PARAMETER(filter, add_record_filter);
+  ASSERT_NULL_PARAMETER(expression, add_record_filter);
+
+  memset(&predicate, 0, sizeof(FilterPredicate));
+
+  name_length = strcspn(expression, "!<>=^");
+  op_start = expression + name_length;
+
+  for (i = 0; i < sizeof(g_field_names) / sizeof(g_field_names[0]); ++i) {
+    if (strlen(g_field_names[i].name) == name_length && !strncmp(g_field_names[i].name, expression, name_length))
+      break;
+  }
+
+  if (i == sizeof(g_field_names) / sizeof(g_field_names[0]))
+    return 0;
+
+  predicate.field = g_field_names[i].field;
+
+  for (i = 0; i < sizeof(g_operator_symbols) / sizeof(g_operator_symbols[0]); ++i) {
+    if (!strncmp(g_operator_symbols[i].symbol, op_start, strlen(g_operator_symbols[i].symbol)))
+      break;
+  }
+
+  if (i == sizeof(g_operator_symbols) / sizeof(g_operator_symbols[0]))
+    return 0;
+
+  predicate.op = g_operator_symbols[i].op;
+
+  if (predicate.op == FILTER_PREFIX && predicate.field != FILTER_FIELD_STRING)
+    return 0;
+
+  op_start += strlen(g_operator_symbols[i].symbol);
+
+  if (!parse_operand(&predicate, op_start, op_start + strlen(op_start)))
+    return 0;
+
+  if (filter->count == filter->capacity) {
+    filter->capacity = filter->capacity ? filter->capacity * 2 : 4;
+    filter->predicates = (FilterPredicate *) realloc(filter->predicates, sizeof(FilterPredicate) * filter->capacity);
+    ASSERT(filter->predicates, "Unable to allocate memory for the filter predicates", add_record_filter);
+  }
+
+  filter->predicates[filter->count++] = predicate;
+  return 1;
+}
+
+/*---------------------------------------------------------------------------------------------------------------*/
+
+// PURPOSE: Tests a record against a single predicate.
+static int match_predicate(const FilterPredicate *predicate, const Record *record) {
+  switch (predicate->field) {
+    case FILTER_FIELD_ID:
+      return TEST_OPERATOR(predicate->op, COMPARE_NUMBERS((uint64_t) record->id, predicate->operand.id));
+    case FILTER_FIELD_INTEGER:
+      return TEST_OPERATOR(predicate->op, COMPARE_NUMBERS((int32_t) record->int_field, predicate->operand.integer));
+    case FILTER_FIELD_FLOAT:
+      // NaNs only satisfy the != operator, as in C.
+      if (predicate->op == FILTER_NOT_EQUAL)
+        return record->float_field != predicate->operand.real;
+      if (record->float_field != record->float_field || predicate->operand.real != predicate->operand.real)
+        return 0;
+      return TEST_OPERATOR(predicate->op, COMPARE_NUMBERS(record->float_field, predicate->operand.real));
+    case FILTER_FIELD_STRING:
+      if (predicate->op == FILTER_PREFIX)
+        return !strncmp(record->string_field, predicate->operand.string, predicate->operand_length);
+      return TEST_OPERATOR(predicate->op, strcmp(record->string_field, predicate->operand.string));
+  }
+
+  PRINT_ERROR("Invalid filter field", match_predicate);
+  return 0;
+}
+
+/*---------------------------------------------------------------------------------------------------------------*/
+
+int match_record_filter(const RecordFilter *filter, const Record *record) {
+  size_t i;
+
+  ASSERT_NULL_PARAMETER(filter, match_record_filter);
+  ASSERT_NULL_PARAMETER(record, match_record_filter);
+
+  for (i = 0; i < filter->count; ++i) {
+    if (!match_predicate(&filter->predicates[i], record))
+      return 0;
+  }
+
+  return 1;
+}
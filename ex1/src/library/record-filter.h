@@ -0,0 +1,93 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include "record.h"
+
+/**
+ * @brief Defines the fields of a record which can be tested by a filter.
+ */
+typedef enum FilterField {
+  /** @brief Tests the record id. */
+  FILTER_FIELD_ID,
+  /** @brief Tests the string field. */
+  FILTER_FIELD_STRING,
+  /** @brief Tests the integer field. */
+  FILTER_FIELD_INTEGER,
+  /** @brief Tests the float field. */
+  FILTER_FIELD_FLOAT
+} FilterField;
+
+/**
+ * @brief Defines the operators of a filter predicate.
+ */
+typedef enum FilterOperator {
+  FILTER_EQUAL,  ///< <code>=</code>
+  FILTER_NOT_EQUAL,  ///< <code>!=</code>
+  FILTER_LESS,  ///< <code>\<</code>
+  FILTER_LESS_EQUAL,  ///< <code>\<=</code>
+  FILTER_GREATER,  ///< <code>\></code>
+  FILTER_GREATER_EQUAL,  ///< <code>\>=</code>
+  FILTER_PREFIX  ///< <code>^=</code> (string field only)
+} FilterOperator;
+
+/**
+ * @brief Represents a comparison between a field of a record and a constant operand.
+ */
+typedef struct FilterPredicate {
+  FilterField field;  ///< The tested field.
+  FilterOperator op;  ///< The comparison operator.
+  union {
+    uint64_t id;
+    char string[STRING_FIELD_LEN];
+    int32_t integer;
+    float real;
+  } operand;  ///< The operand, of the same type as the tested field.
+  size_t operand_length;  ///< Length of the string operand.
+} FilterPredicate;
+
+/**
+ * @brief Represents a conjunction of predicates over the fields of a record.
+ *
+ * @remark A filter is evaluated by the record reader right after a record has been parsed, so the records which do
+ * not match it are never stored.
+ */
+typedef struct RecordFilter {
+  FilterPredicate *predicates;  ///< The predicates, which must all be satisfied by a record.
+  size_t count;  ///< Number of predicates.
+  size_t capacity;  ///< Number of predicates which can be stored without growing the array.
+} RecordFilter;
+
+/**
+ * @brief Allocates a new filter, which matches every record.
+ * @param filter Pointer to the pointer that will hold the filter.
+ */
+void new_record_filter(RecordFilter **filter);
+
+/**
+ * @brief Deallocates the specified filter.
+ * @param filter Pointer to the filter to be cleared.
+ */
+void clear_record_filter(RecordFilter **filter);
+
+/**
+ * @brief Parses a predicate and adds it to the filter.
+ *
+ * @remark A predicate has the form <code>FIELD OP VALUE</code> (without spaces), where @c FIELD is one of @c id,
+ * @c string_field, @c int_field and @c float_field, and @c OP is one of <code>=, !=, \<, \<=, \>, \>=</code> and
+ * <code>^=</code> (prefix match, string field only). For example: <code>int_field>=100</code>,
+ * <code>string_field^=abc</code>. Strings are compared as @c strcmp does.
+ *
+ * @param filter The filter.
+ * @param expression The predicate.
+ * @return 1 if the predicate has been added, 0 if it is not valid.
+ */
+int add_record_filter(RecordFilter *filter, const char *expression);
+
+/**
+ * @brief Tests a record against the filter.
+ * @param filter The filter.
+ * @param record The record.
+ * @return 1 if the record satisfies all the predicates of the filter, 0 otherwise.
+ */
+int match_record_filter(const RecordFilter *filter, const Record *record);
@@ -0,0 +1,155 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <malloc.h>
+#include <string.h>
+#include <stdlib.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "record-index.h"
+#include "record-reader.h"
+#include "assert_util.h"
+
+/*---------------------------------------------------------------------------------------------------------------*/
+
+// PURPOSE: Identifies a record index file.
+#define INDEX_MAGIC "RECINDEX"
+
+// PURPOSE: The version of the index file format. Must be increased whenever the layout changes.
+#define INDEX_VERSION 1
+
+// PURPOSE: The number of entries gathered into a buffer before being written.
+#define INDEX_WRITE_BATCH 4096
+
+// PURPOSE: Represents the header of an index file.
+typedef struct IndexHeader {
+  char magic[8];
+  uint32_t version;
+  uint32_t kind;
+  uint32_t field_id;
+  uint32_t reserved;
+  uint64_t count;
+} IndexHeader;
+
+/*---------------------------------------------------------------------------------------------------------------*/
+
+void write_record_index(FILE *out_file, RecordIndexKind kind, FieldId field_id, const uint64_t *values,
+                        const uint32_t *permutation, size_t count) {
+  uint64_t batch[INDEX_WRITE_BATCH];
+  IndexHeader header;
+  size_t i, j, batch_count;
+
+  ASSERT_NULL_PARAMETER(out_file, write_record_index);
+  ASSERT(kind == RECORD_INDEX_IDS || kind == RECORD_INDEX_OFFSETS, "Invalid index kind", write_record_index);
+  ASSERT(values || !count, "'values' parameter is NULL", write_record_index);
+  ASSERT(permutation || !count, "'permutation' parameter is NULL", write_record_index);
+
+  memset(&header, 0, sizeof(IndexHeader));
+  memcpy(header.magic, INDEX_MAGIC, sizeof(header.magic));
+  header.version = INDEX_VERSION;
+  header.kind = (uint32_t) kind;
+  header.field_id = (uint32_t) field_id;
+  header.count = (uint64_t) count;
+
+  ASSERT(fwrite(&header, sizeof(IndexHeader), 1, out_file) == 1, "Unable to write the index header",
+         write_record_index);
+
+  for (i = 0; i < count; i += batch_count) {
+    batch_count = count - i < INDEX_WRITE_BATCH ? count - i : INDEX_WRITE_BATCH;
+
+    for (j = 0; j < batch_count; ++j)
+      batch[j] = values[permutation[i + j]];
+
+    ASSERT(fwrite(batch, sizeof(uint64_t), batch_count, out_file) == batch_count, "Unable to write the index entries",
+           write_record_index);
+  }
+}
+
+/*---------------------------------------------------------------------------------------------------------------*/
+
+int open_record_index(RecordIndex **index, const char *index_path) {
+  const IndexHeader *header;
+  struct stat st;
+  void *mapping;
+  int fd;
+
+  ASSERT_NULL_PARAMETER(index, open_record_index);
+  ASSERT_NULL_PARAMETER(index_path, open_record_index);
+
+  *index = NULL;
+
+  fd = open(index_path, O_RDONLY);
+  if (fd < 0)
+    return 0;
+
+  if (fstat(fd, &st) || (size_t) st.st_size < sizeof(IndexHeader)) {
+    close(fd);
+    return 0;
+  }
+
+  mapping = mmap(NULL, (size_t) st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+
+  if (mapping == MAP_FAILED)
+    return 0;
+
+  header = (const IndexHeader *) mapping;
+
+  if (memcmp(header->magic, INDEX_MAGIC, sizeof(header->magic)) != 0 || header->version != INDEX_VERSION ||
+      (header->kind != RECORD_INDEX_IDS && header->kind != RECORD_INDEX_OFFSETS) || header->field_id > FIELD_FLOAT ||
+      sizeof(IndexHeader) + header->count * sizeof(uint64_t) != (size_t) st.st_size) {
+    munmap(mapping, (size_t) st.st_size);
+    return 0;
+  }
+
+  *index = (RecordIndex *) malloc(sizeof(RecordIndex));
+  ASSERT(*index, "Unable to allocate memory for the record index", open_record_index);
+
+  (*index)->mapping = mapping;
+  (*index)->mapping_size = (size_t) st.st_size;
+  (*index)->kind = (RecordIndexKind) header->kind;
+  (*index)->field_id = (FieldId) header->field_id;
+  (*index)->count = (size_t) header->count;
+  (*index)->entries = (const uint64_t *) ((const char *) mapping + sizeof(IndexHeader));
+
+  return 1;
+}
+
+/*---------------------------------------------------------------------------------------------------------------*/
+
+void close_record_index(RecordIndex **index) {
+  ASSERT_NULL_PARAMETER(index, close_record_index);
+  ASSERT_NULL_PARAMETER(*index, close_record_index);
+
+  ASSERT(!munmap((*index)->mapping, (*index)->mapping_size), "Unable to unmap the index file", close_record_index);
+  free(*index);
+  *index = NULL;
+}
+
+/*---------------------------------------------------------------------------------------------------------------*/
+
+int read_indexed_record(const RecordIndex *index, size_t position, FILE *record_file, Record *record) {
+  char *line;
+  size_t line_capacity;
+  ssize_t length;
+  int parsed;
+
+  ASSERT_NULL_PARAMETER(index, read_indexed_record);
+  ASSERT_NULL_PARAMETER(record_file, read_indexed_record);
+  ASSERT_NULL_PARAMETER(record, read_indexed_record);
+  ASSERT(index->kind == RECORD_INDEX_OFFSETS, "The index does not hold byte offsets", read_indexed_record);
+  ASSERT(position < index->count, "The position is out of range", read_indexed_record);
+
+  if (fseeko(record_file, (off_t) index->entries[position], SEEK_SET))
+    return 0;
+
+  // The lines of the record file can be of any length, so the whole line is read.
+  line = NULL;
+  line_capacity = 0;
+  length = getline(&line, &line_capacity, record_file);
+  parsed = length > 0 && parse_record(line, (size_t) length, record);
+
+  free(line);
+  return parsed;
+}
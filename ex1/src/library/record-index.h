@@ -0,0 +1,60 @@
+#pragma once
+
+#include <stdio.h>
+#include <stdint.h>
+#include "record.h"
+#include "records-sorter.h"
+
+/**
+ * @brief Represents a memory-mapped binary index of a record file, holding the ids or the byte offsets of the records
+ * in sorted order.
+ *
+ * @remark An index file is made of a header (which describes the kind of the entries, the sorted field and the number
+ * of entries) followed by an array of 64-bit entries, in the byte order of the machine which wrote it.
+ */
+typedef struct RecordIndex {
+  void *mapping;  ///< Pointer to the beginning of the mapped index file.
+  size_t mapping_size;  ///< Size of the mapped index file, in bytes.
+  RecordIndexKind kind;  ///< The kind of the entries.
+  FieldId field_id;  ///< The field by which the records have been sorted.
+  size_t count;  ///< Number of entries.
+  const uint64_t *entries;  ///< The entries, in sorted order.
+} RecordIndex;
+
+/**
+ * @brief Writes an index, whose i-th entry is <code>values[permutation[i]]</code>.
+ * @param out_file The destination file.
+ * @param kind The kind of the entries (either @c RECORD_INDEX_IDS or @c RECORD_INDEX_OFFSETS).
+ * @param field_id The field by which the records have been sorted.
+ * @param values The ids or the offsets of the records, in file order.
+ * @param permutation The permutation which sorts the records.
+ * @param count The number of records.
+ */
+void write_record_index(FILE *out_file, RecordIndexKind kind, FieldId field_id, const uint64_t *values,
+                        const uint32_t *permutation, size_t count);
+
+/**
+ * @brief Opens the index stored at the specified path.
+ * @param index Pointer to the pointer that will hold the index.
+ * @param index_path The path of the index file.
+ * @return 1 if the index has been opened, 0 if it does not exist or it is not a valid index file. In the latter case,
+ * @c *index is set to NULL.
+ */
+int open_record_index(RecordIndex **index, const char *index_path);
+
+/**
+ * @brief Unmaps and deallocates the specified index.
+ * @param index Pointer to the index to be closed.
+ */
+void close_record_index(RecordIndex **index);
+
+/**
+ * @brief Reads the record at the specified position of the sorted order, seeking into the record file through an index
+ * of byte offsets.
+ * @param index The index, whose kind must be @c RECORD_INDEX_OFFSETS.
+ * @param position The position of the record in sorted order (less than @c index->count).
+ * @param record_file The record file from which the index has been built.
+ * @param record The destination record.
+ * @return 1 if the record has been read, 0 if the line at the indexed offset is not a valid record.
+ */
+int read_indexed_record(const RecordIndex *index, size_t position, FILE *record_file, Record *record);
@@ -0,0 +1,103 @@
+#include <malloc.h>
+#include <inttypes.h>
+#include "record-output.h"
+#include "record-comparator.h"
+#include "assert_util.h"
+
+/*---------------------------------------------------------------------------------------------------------------*/
+
+// PURPOSE: The max length of an aggregated row (the key, the count, the sum and the mean, formatted).
+#define MAX_AGGREGATED_ROW_LEN (2 * LINE_BUFFER_SIZE)
+
+/*---------------------------------------------------------------------------------------------------------------*/
+
+// PURPOSE: Formats the key of a record into the buffer, and returns its length.
+static int format_key(char *buffer, size_t size, const Record *record, FieldId field_id) {
+  switch (field_id) {
+    case FIELD_STRING:
+      return snprintf(buffer, size, "%s", record->string_field);
+    case FIELD_INTEGER:
+      return snprintf(buffer, size, "%d", record->int_field);
+    case FIELD_FLOAT:
+      return snprintf(buffer, size, "%f", record->float_field);
+  }
+
+  PRINT_ERROR("Invalid field ID", format_key);
+  return 0;
+}
+
+/*---------------------------------------------------------------------------------------------------------------*/
+
+// PURPOSE: Writes the aggregated row of the current group, if any.
+static void write_group(RecordOutput *output) {
+  char row[MAX_AGGREGATED_ROW_LEN];
+  int key_length, length;
+
+  if (output->group_count == 0)
+    return;
+
+  key_length = format_key(row, sizeof(row), &output->group, output->field_id);
+  ASSERT(key_length >= 0 && (size_t) key_length < sizeof(row), "The key does not fit into the row", write_group);
+
+  length = snprintf(row + key_length, sizeof(row) - key_length, ",%zu,%" PRId64 ",%f\n", output->group_count,
+                    output->int_sum, output->float_sum / (double) output->group_count);
+  ASSERT(length >= 0 && (size_t) length < sizeof(row) - key_length, "The aggregated row does not fit into the buffer",
+         write_group);
+
+  write_record_bytes(output->writer, row, (size_t) (key_length + length));
+}
+
+/*---------------------------------------------------------------------------------------------------------------*/
+
+void new_record_output(RecordOutput **output, FILE *file, FieldId field_id, const SortOptions *options) {
+  ASSERT_NULL_PARAMETER(output, new_record_output);
+  ASSERT_NULL_PARAMETER(file, new_record_output);
+  ASSERT_NULL_PARAMETER(options, new_record_output);
+
+  *output = (RecordOutput *) malloc(sizeof(RecordOutput));
+  ASSERT(*output, "Unable to allocate memory for the record output", new_record_output);
+
+  new_record_writer_backend(&(*output)->writer, file, options->writer_backend, options->report_bandwidth);
+  (*output)->field_id = field_id;
+  (*output)->compare = options->aggregate ? get_record_comparator(field_id) : NULL;
+  (*output)->group_count = 0;
+  (*output)->int_sum = 0;
+  (*output)->float_sum = 0;
+}
+
+/*---------------------------------------------------------------------------------------------------------------*/
+
+void clear_record_output(RecordOutput **output) {
+  ASSERT_NULL_PARAMETER(output, clear_record_output);
+  ASSERT_NULL_PARAMETER(*output, clear_record_output);
+
+  write_group(*output);
+  clear_record_writer(&(*output)->writer);
+  free(*output);
+  *output = NULL;
+}
+
+/*---------------------------------------------------------------------------------------------------------------*/
+
+void write_record_output(RecordOutput *output, const Record *record) {
+  ASSERT_NULL_PARAMETER(output, write_record_output);
+  ASSERT_NULL_PARAMETER(record, write_record_output);
+
+  if (!output->compare) {
+    write_record(output->writer, record);
+    return;
+  }
+
+  if (output->group_count > 0 && output->compare(&output->group, record) == 0) {
+    output->group_count++;
+    output->int_sum += record->int_field;
+    output->float_sum += record->float_field;
+    return;
+  }
+
+  write_group(output);
+  output->group = *record;
+  output->group_count = 1;
+  output->int_sum = record->int_field;
+  output->float_sum = record->float_field;
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <stdio.h>
+#include <stdint.h>
+#include "comparator.h"
+#include "records-sorter.h"
+#include "record-writer.h"
+
+/**
+ * @brief Represents the destination of the sorted records: either every record is written, or the records with equal
+ * keys (which are adjacent, since the records are sorted) are collapsed into one aggregated row per distinct key.
+ *
+ * @remark An aggregated row holds the key, the number of records with the key, the sum of their integer fields and the
+ * mean of their float fields (e.g. <code>abc,3,42,1.500000</code> when sorting by the string field).
+ */
+typedef struct RecordOutput {
+  RecordWriter *writer;  ///< The writer of the destination file.
+  FieldId field_id;  ///< The field by which the records are sorted (the key of the aggregated rows).
+  compare_fn compare;  ///< The comparator of the keys, or NULL if the records are written without aggregation.
+  Record group;  ///< The first record of the current group of equal keys.
+  size_t group_count;  ///< Number of records of the current group (0 before the first record).
+  int64_t int_sum;  ///< Sum of the integer fields of the current group.
+  double float_sum;  ///< Sum of the float fields of the current group.
+} RecordOutput;
+
+/**
+ * @brief Allocates a new output into the specified file, configured by the options of the sorter (the writer backend,
+ * and whether the records are aggregated).
+ * @param output Pointer to the pointer that will hold the output.
+ * @param file The destination file.
+ * @param field_id The field by which the written records are sorted.
+ * @param options The options of the sorter.
+ */
+void new_record_output(RecordOutput **output, FILE *file, FieldId field_id, const SortOptions *options);
+
+/**
+ * @brief Writes the last aggregated row (if any), clears the writer and deallocates the output.
+ * @param output Pointer to the output to be cleared.
+ * @note The destination file is flushed, but not closed.
+ */
+void clear_record_output(RecordOutput **output);
+
+/**
+ * @brief Writes a record, or adds it to the aggregated row of its key (writing the previous row if the key changes).
+ * @param output The output.
+ * @param record The record, which must not precede the previously written one.
+ */
+void write_record_output(RecordOutput *output, const Record *record);
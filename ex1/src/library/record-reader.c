@@ -0,0 +1,384 @@
+#include <malloc.h>
+#include <string.h>
+#include <stdlib.h>
+#include "record-reader.h"
+#include "csv-scanner.h"
+#include "field-parsers.h"
+#include "assert_util.h"
+
+/*---------------------------------------------------------------------------------------------------------------*/
+
+// PURPOSE: Parses a record id from its slice of the line and stores it into the record.
+#define LOAD_ID(record, begin, end) \
+    ASSERT(parse_record_id(&(record)->id, (begin), (end)), "Malformed record: invalid id", LOAD_ID)
+
+// PURPOSE: Parses a string field and stores it into the record.
+#define LOAD_STRING(record, begin, end) copy_string_field((record)->string_field, (begin), (end))
+
+// PURPOSE: Parses an int field and stores it into the record.
+#define LOAD_INT(record, begin, end) \
+    ASSERT(parse_record_int(&(record)->int_field, (begin), (end)), "Malformed record: invalid int field", LOAD_INT)
+
+// PURPOSE: Parses a float field and stores it into the record.
+#define LOAD_FLOAT(record, begin, end) \
+    ASSERT(parse_float32((begin), (end), &(record)->float_field), "Malformed record: invalid float field", LOAD_FLOAT)
+
+/*---------------------------------------------------------------------------------------------------------------*/
+
+// PURPOSE: Parses a record id, checking that it fits into the id of a record.
+static int parse_record_id(size_t *id, const char *begin, const char *end) {
+  uint64_t value;
+
+  if (!parse_uint64(begin, end, &value) || value > SIZE_MAX)
+    return 0;
+
+  *id = (size_t) value;
+  return 1;
+}
+
+/*---------------------------------------------------------------------------------------------------------------*/
+
+// PURPOSE: Parses an int field into the int field of a record.
+static int parse_record_int(int *field, const char *begin, const char *end) {
+  int32_t value;
+
+  if (!parse_int32(begin, end, &value))
+    return 0;
+
+  *field = (int) value;
+  return 1;
+}
+
+/*---------------------------------------------------------------------------------------------------------------*/
+
+// PURPOSE: Copies a string field, truncating it to the max length of the string field.
+static void copy_string_field(char *dst, const char *begin, const char *end) {
+  size_t length;
+
+  length = (size_t) (end - begin);
+
+  if (length >= STRING_FIELD_LEN)
+    length = STRING_FIELD_LEN - 1;
+
+  memcpy(dst, begin, length);
+  dst[length] = '\0';
+}
+
+/*---------------------------------------------------------------------------------------------------------------*/
+
+// PURPOSE: Moves the incomplete line at the end of the buffer to its beginning, fills the rest of the buffer with the
+//          following bytes of the file, and collects the structurals of the complete lines.
+// NOTE: Returns 0 if the file has no more bytes to be parsed.
+static int refill_buffer(RecordReader *reader) {
+  size_t remainder, read_count;
+
+  remainder = reader->length - reader->line_start;
+  reader->buffer_offset += reader->line_start;
+  memmove(reader->buffer, reader->buffer + reader->line_start, remainder);
+
+  reader->length = remainder;
+  reader->line_start = 0;
+
+  if (!reader->eof) {
+    read_count = fread(reader->buffer + remainder, 1, RECORD_READER_BUFFER_SIZE - remainder, reader->file);
+    reader->length += read_count;
+    reader->eof = read_count < RECORD_READER_BUFFER_SIZE - remainder;
+  }
+
+  if (reader->length == 0)
+    return 0;
+
+  // The last line of the file may lack the newline: a newline is appended (the buffer has a spare byte for it).
+  if (reader->eof && reader->buffer[reader->length - 1] != '\n')
+    reader->buffer[reader->length++] = '\n';
+
+  // Only the complete lines are indexed: the incomplete one will be completed by the next refill.
+  reader->indexed_length = reader->length;
+  while (reader->indexed_length > 0 && reader->buffer[reader->indexed_length - 1] != '\n')
+    reader->indexed_length--;
+
+  ASSERT(reader->indexed_length > 0, "A line of the record file is longer than the reader buffer", refill_buffer);
+
+  reader->structural_count = scan_csv_structurals(reader->buffer, reader->indexed_length, reader->structurals);
+  reader->next_structural = 0;
+  return 1;
+}
+
+/*---------------------------------------------------------------------------------------------------------------*/
+
+// PURPOSE: Returns the offset of the next structural of the indexed part of the buffer.
+static size_t next_structural(RecordReader *reader) {
+  ASSERT(reader->next_structural < reader->structural_count, "Malformed record: the line has too few fields",
+         next_structural);
+
+  return reader->structurals[reader->next_structural++];
+}
+
+/*---------------------------------------------------------------------------------------------------------------*/
+
+// PURPOSE: Slices the fields of the next line of the indexed part of the buffer, and parses them into a record.
+// NOTE: Returns 0 if the line is empty.
+static int parse_next_line(RecordReader *reader, Record *record) {
+  size_t commas[3], newline, i;
+  const char *line_end;
+  char *buffer;
+
+  buffer = reader->buffer;
+
+  for (i = 0; i < 3; ++i) {
+    commas[i] = next_structural(reader);
+
+    if (buffer[commas[i]] == '\n') {
+      ASSERT(i == 0 && commas[i] == reader->line_start, "Malformed record: the line has too few fields",
+             parse_next_line);
+      reader->line_start = commas[i] + 1;
+      return 0;
+    }
+  }
+
+  newline = next_structural(reader);
+  ASSERT(buffer[newline] == '\n', "Malformed record: the line has too many fields", parse_next_line);
+
+  // The fields are parsed in place, as slices of the buffer between the structurals.
+  line_end = buffer + newline;
+
+  if (line_end > buffer + commas[2] + 1 && line_end[-1] == '\r')
+    line_end--;
+
+  LOAD_ID(record, buffer + reader->line_start, buffer + commas[0]);
+  LOAD_STRING(record, buffer + commas[0] + 1, buffer + commas[1]);
+  reader->string_field = buffer + commas[0] + 1;
+  reader->string_length = commas[1] - commas[0] - 1;
+  LOAD_INT(record, buffer + commas[1] + 1, buffer + commas[2]);
+  LOAD_FLOAT(record, buffer + commas[2] + 1, line_end);
+
+  reader->line_start = newline + 1;
+  return 1;
+}
+
+/*---------------------------------------------------------------------------------------------------------------*/
+
+void new_record_reader(RecordReader **reader, FILE *file) {
+  ASSERT_NULL_PARAMETER(reader, new_record_reader);
+  ASSERT_NULL_PARAMETER(file, new_record_reader);
+
+  *reader = (RecordReader *) malloc(sizeof(RecordReader));
+  ASSERT(*reader, "Unable to allocate memory for the record reader", new_record_reader);
+
+  // One spare byte holds the newline appended to an unterminated last line.
+  (*reader)->buffer = (char *) malloc(RECORD_READER_BUFFER_SIZE + 1);
+  (*reader)->structurals = (uint32_t *) malloc(sizeof(uint32_t) * (RECORD_READER_BUFFER_SIZE + 1));
+  ASSERT((*reader)->buffer && (*reader)->structurals, "Unable to allocate memory for the reader buffers",
+         new_record_reader);
+
+  (*reader)->file = file;
+  (*reader)->length = (*reader)->indexed_length = 0;
+  (*reader)->structural_count = (*reader)->next_structural = 0;
+  (*reader)->line_start = 0;
+  (*reader)->buffer_offset = 0;
+  (*reader)->eof = 0;
+  (*reader)->filter = NULL;
+  (*reader)->string_field = NULL;
+  (*reader)->string_length = 0;
+}
+
+/*---------------------------------------------------------------------------------------------------------------*/
+
+void clear_record_reader(RecordReader **reader) {
+  ASSERT_NULL_PARAMETER(reader, clear_record_reader);
+  ASSERT_NULL_PARAMETER(*reader, clear_record_reader);
+
+  free((*reader)->buffer);
+  free((*reader)->structurals);
+  free(*reader);
+  *reader = NULL;
+}
+
+/*---------------------------------------------------------------------------------------------------------------*/
+
+void set_record_reader_filter(RecordReader *reader, const RecordFilter *filter) {
+  ASSERT_NULL_PARAMETER(reader, set_record_reader_filter);
+
+  reader->filter = filter;
+}
+
+/*---------------------------------------------------------------------------------------------------------------*/
+
+int read_record(RecordReader *reader, Record *record) {
+  uint64_t offset;
+
+  return read_record_at(reader, record, &offset);
+}
+
+/*---------------------------------------------------------------------------------------------------------------*/
+
+int read_record_at(RecordReader *reader, Record *record, uint64_t *offset) {
+  size_t length;
+
+  return read_record_span(reader, record, offset, &length);
+}
+
+/*---------------------------------------------------------------------------------------------------------------*/
+
+int read_record_span(RecordReader *reader, Record *record, uint64_t *offset, size_t *length) {
+  ASSERT_NULL_PARAMETER(reader, read_record_span);
+  ASSERT_NULL_PARAMETER(record, read_record_span);
+  ASSERT_NULL_PARAMETER(offset, read_record_span);
+  ASSERT_NULL_PARAMETER(length, read_record_span);
+
+  for (;;) {
+    if (reader->line_start == reader->indexed_length && !refill_buffer(reader))
+      return 0;
+
+    *offset = reader->buffer_offset + reader->line_start;
+
+    if (parse_next_line(reader, record) && (!reader->filter || match_record_filter(reader->filter, record))) {
+      // The line ends where the next one begins.
+      *length = (size_t) (reader->buffer_offset + reader->line_start - *offset);
+      return 1;
+    }
+  }
+}
+
+/*---------------------------------------------------------------------------------------------------------------*/
+
+int read_record_string(RecordReader *reader, Record *record, const char **string, size_t *length) {
+  uint64_t offset;
+  size_t line_length;
+
+  ASSERT_NULL_PARAMETER(string, read_record_string);
+  ASSERT_NULL_PARAMETER(length, read_record_string);
+
+  if (!read_record_span(reader, record, &offset, &line_length))
+    return 0;
+
+  // The line of the record stays in the buffer until the next one is read.
+  *string = reader->string_field;
+  *length = reader->string_length;
+  return 1;
+}
+
+/*---------------------------------------------------------------------------------------------------------------*/
+
+int parse_record(const char *line, size_t length, Record *record) {
+  const char *commas[3], *field, *end;
+  size_t i;
+
+  ASSERT_NULL_PARAMETER(line, parse_record);
+  ASSERT_NULL_PARAMETER(record, parse_record);
+
+  end = line + length;
+
+  if (end > line && end[-1] == '\n') end--;
+  if (end > line && end[-1] == '\r') end--;
+
+  field = line;
+
+  for (i = 0; i < 3; ++i) {
+    commas[i] = (const char *) memchr(field, ',', (size_t) (end - field));
+    if (!commas[i])
+      return 0;
+    field = commas[i] + 1;
+  }
+
+  if (memchr(field, ',', (size_t) (end - field)))
+    return 0;
+
+  copy_string_field(record->string_field, commas[0] + 1, commas[1]);
+
+  return parse_record_id(&record->id, line, commas[0]) &&
+         parse_record_int(&record->int_field, commas[1] + 1, commas[2]) &&
+         parse_float32(field, end, &record->float_field);
+}
+
+/*---------------------------------------------------------------------------------------------------------------*/
+
+size_t read_records(RecordReader *reader, Record *records, size_t max_count) {
+  size_t count;
+
+  ASSERT_NULL_PARAMETER(reader, read_records);
+  ASSERT(records || !max_count, "'records' parameter is NULL", read_records);
+
+  count = 0;
+
+  while (count < max_count && read_record(reader, &records[count]))
+    count++;
+
+  return count;
+}
+
+/*---------------------------------------------------------------------------------------------------------------*/
+
+#if __PROFILER
+
+#include <time.h>
+
+// PURPOSE: Parses a line of the record file into a record, splitting the fields with strtok and converting them with
+//          the C library.
+static void load_record_tokens(char *line, Record *record) {
+  char *field;
+
+  field = strtok(line, ",");
+  record->id = atoi(field); // NOLINT(*-err34-c)
+
+  field = strtok(NULL, ",");
+  copy_string_field(record->string_field, field, field + strlen(field));
+
+  field = strtok(NULL, ",");
+  record->int_field = atoll(field); // NOLINT(*-err34-c)
+
+  field = strtok(NULL, ",");
+  record->float_field = atof(field); // NOLINT(*-err34-c)
+}
+
+// PURPOSE: Prints the throughput of a parser.
+static void print_reader_result(const char *parser, size_t count, long bytes, clock_t start, clock_t end) {
+  double seconds;
+
+  seconds = (double) (end - start) / CLOCKS_PER_SEC;
+  printf("[PROFILER]<parser=%s>: Parsed %zu records in %f seconds (%.1f MB/s).\n", parser, count, seconds,
+         seconds > 0 ? (double) bytes / seconds / 1e6 : 0.0);
+}
+
+void profile__record_reader(FILE *in_file) {
+  char line_buffer[LINE_BUFFER_SIZE];
+  char scanner_name[32];
+  RecordReader *reader;
+  Record record;
+  clock_t start, end;
+  size_t count;
+  long bytes;
+
+  ASSERT_NULL_PARAMETER(in_file, profile__record_reader);
+
+  rewind(in_file);
+  count = 0;
+  start = clock();
+
+  while (fgets(line_buffer, LINE_BUFFER_SIZE, in_file)) {
+    load_record_tokens(line_buffer, &record);
+    count++;
+  }
+
+  end = clock();
+  bytes = ftell(in_file);
+  print_reader_result("fgets/strtok", count, bytes, start, end);
+
+  rewind(in_file);
+  count = 0;
+  new_record_reader(&reader, in_file);
+  start = clock();
+
+  while (read_record(reader, &record))
+    count++;
+
+  end = clock();
+  clear_record_reader(&reader);
+
+  snprintf(scanner_name, sizeof(scanner_name), "simd-%s", get_csv_scanner_name());
+  print_reader_result(scanner_name, count, bytes, start, end);
+
+  rewind(in_file);
+}
+
+#endif
@@ -0,0 +1,129 @@
+#pragma once
+
+#include <stdio.h>
+#include <stdint.h>
+#include "record.h"
+#include "record-filter.h"
+
+#ifndef RECORD_READER_BUFFER_SIZE
+/**
+ * @brief The size of the buffer in which a record reader loads the record file, in bytes.
+ *
+ * @remark This number can be changed by setting this macro before including this header file.
+ * @note A single line of the record file cannot be longer than this size.
+ */
+#define RECORD_READER_BUFFER_SIZE (1 << 20)
+#endif
+
+/**
+ * @brief Represents a reader of the records stored in a record file (one record per line, with comma-separated
+ * fields).
+ *
+ * @remark The file is read in large blocks. Each block is first scanned with SIMD instructions to collect the
+ * positions of every comma and newline, then the fields of each record are sliced by walking those positions.
+ */
+typedef struct RecordReader {
+  FILE *file;  ///< The record file.
+  char *buffer;  ///< Buffer holding the last block read from the file.
+  size_t length;  ///< Number of bytes stored in the buffer.
+  size_t indexed_length;  ///< Number of bytes of the buffer (complete lines only) whose structurals have been collected.
+  uint32_t *structurals;  ///< Offsets of the commas and newlines of the indexed part of the buffer.
+  size_t structural_count;  ///< Number of offsets stored in @c structurals.
+  size_t next_structural;  ///< Index of the first offset which has not been consumed yet.
+  size_t line_start;  ///< Offset of the beginning of the next line.
+  uint64_t buffer_offset;  ///< Offset in the file of the first byte of the buffer.
+  int eof;  ///< 1 if the end of the file has been reached.
+  const RecordFilter *filter;  ///< The filter of the records, or NULL to read every record.
+  const char *string_field;  ///< The whole string field of the last parsed record (not null-terminated), in the buffer.
+  size_t string_length;  ///< The length of @c string_field.
+} RecordReader;
+
+/**
+ * @brief Allocates a new reader of the specified record file.
+ * @param reader Pointer to the pointer that will hold the reader.
+ * @param file The record file, positioned at the beginning of a line.
+ */
+void new_record_reader(RecordReader **reader, FILE *file);
+
+/**
+ * @brief Deallocates the specified reader.
+ * @param reader Pointer to the reader to be cleared.
+ * @note The record file is not closed.
+ */
+void clear_record_reader(RecordReader **reader);
+
+/**
+ * @brief Sets the filter of the records returned by the reader: the records which do not match it are skipped.
+ * @param reader The reader.
+ * @param filter The filter (which must outlive the reader), or NULL to read every record.
+ */
+void set_record_reader_filter(RecordReader *reader, const RecordFilter *filter);
+
+/**
+ * @brief Reads and parses the next record (matching the filter, if any) from the file.
+ * @param reader The reader.
+ * @param record The destination record.
+ * @return 1 if a record has been read, 0 if the end of the file has been reached.
+ */
+int read_record(RecordReader *reader, Record *record);
+
+/**
+ * @brief Same as @c read_record, but also returns the offset of the line of the record in the file.
+ * @param reader The reader.
+ * @param record The destination record.
+ * @param offset The destination offset (relative to the position of the file when the reader was created).
+ * @return 1 if a record has been read, 0 if the end of the file has been reached.
+ */
+int read_record_at(RecordReader *reader, Record *record, uint64_t *offset);
+
+/**
+ * @brief Same as @c read_record_at, but also returns the length of the line of the record.
+ * @param reader The reader.
+ * @param record The destination record.
+ * @param offset The destination offset (relative to the position of the file when the reader was created).
+ * @param length The destination length, including the line terminator. The last line of the file is one byte longer
+ * than the file if it lacks the line terminator.
+ * @return 1 if a record has been read, 0 if the end of the file has been reached.
+ */
+int read_record_span(RecordReader *reader, Record *record, uint64_t *offset, size_t *length);
+
+/**
+ * @brief Same as @c read_record, but also returns the whole string field of the record, which is truncated to
+ * <code>STRING_FIELD_LEN - 1</code> bytes in the record.
+ * @param reader The reader.
+ * @param record The destination record (the filter, if any, sees its truncated string field).
+ * @param string The destination pointer to the string field, which is not null-terminated and is only valid until the
+ * next record is read.
+ * @param length The destination length of the string field.
+ * @return 1 if a record has been read, 0 if the end of the file has been reached.
+ */
+int read_record_string(RecordReader *reader, Record *record, const char **string, size_t *length);
+
+/**
+ * @brief Parses a single line of a record file (with or without its line terminator).
+ * @param line The line.
+ * @param length The length of the line.
+ * @param record The destination record.
+ * @return 1 if the line has been parsed, 0 if it is malformed.
+ */
+int parse_record(const char *line, size_t length, Record *record);
+
+/**
+ * @brief Reads and parses up to @c max_count records (matching the filter, if any) from the file.
+ * @param reader The reader.
+ * @param records The destination array, which must be able to hold @c max_count records.
+ * @param max_count The maximum number of records to be read.
+ * @return The number of records which have been read.
+ */
+size_t read_records(RecordReader *reader, Record *records, size_t max_count);
+
+#if __PROFILER
+
+/**
+ * @brief Profiles the parsing of the whole record file, comparing the line-based (@c fgets / @c strtok) parser with
+ * the SIMD structural scanner used by the reader.
+ * @param in_file The record file, which is rewound before and after each run.
+ */
+void profile__record_reader(FILE *in_file);
+
+#endif
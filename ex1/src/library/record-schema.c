@@ -0,0 +1,325 @@
+#include <malloc.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include "record-schema.h"
+#include "field-parsers.h"
+#include "assert_util.h"
+
+/*---------------------------------------------------------------------------------------------------------------*/
+
+// PURPOSE: The max length of a formatted integer column ("-2147483648").
+#define MAX_INTEGER_TEXT_LEN 11
+
+// PURPOSE: The max length of a formatted float column (the largest float printed with "%f" and its sign).
+#define MAX_FLOAT_TEXT_LEN 48
+
+// PURPOSE: The max width of a string column.
+#define MAX_STRING_WIDTH ((size_t) 1 << 16)
+
+/*---------------------------------------------------------------------------------------------------------------*/
+
+// PURPOSE: Parses a single column ("name:type" or "name:string:width") from the range [begin, end).
+static int parse_column(const char *begin, const char *end, SchemaColumn *column) {
+  const char *name_end, *type_begin, *type_end;
+  size_t type_length;
+  char *width_end;
+  unsigned long width;
+
+  name_end = (const char *) memchr(begin, ':', (size_t) (end - begin));
+
+  if (!name_end || name_end == begin || (size_t) (name_end - begin) >= SCHEMA_COLUMN_NAME_LEN)
+    return 0;
+
+  memset(column, 0, sizeof(SchemaColumn));
+  memcpy(column->name, begin, (size_t) (name_end - begin));
+
+  type_begin = name_end + 1;
+  type_end = (const char *) memchr(type_begin, ':', (size_t) (end - type_begin));
+  type_length = (size_t) ((type_end ? type_end : end) - type_begin);
+
+  if (type_length == strlen("int") && !strncmp(type_begin, "int", type_length)) {
+    column->type = COLUMN_INTEGER;
+    return !type_end;
+  }
+
+  if (type_length == strlen("float") && !strncmp(type_begin, "float", type_length)) {
+    column->type = COLUMN_FLOAT;
+    return !type_end;
+  }
+
+  if (type_length != strlen("string") || strncmp(type_begin, "string", type_length) || !type_end)
+    return 0;
+
+  // The width is followed by the end of the column.
+  width = strtoul(type_end + 1, &width_end, 10);
+
+  if (width_end != end || width == 0 || width > MAX_STRING_WIDTH)
+    return 0;
+
+  column->type = COLUMN_STRING;
+  column->width = (size_t) width;
+  return 1;
+}
+
+/*---------------------------------------------------------------------------------------------------------------*/
+
+// PURPOSE: Returns the index of the column with the specified name or index, or column_count if there is none.
+static size_t find_column(const RecordSchema *schema, const char *key_column) {
+  char *index_end;
+  unsigned long index;
+  size_t i;
+
+  for (i = 0; i < schema->column_count; ++i) {
+    if (!strcmp(schema->columns[i].name, key_column))
+      return i;
+  }
+
+  index = strtoul(key_column, &index_end, 10);
+
+  if (*key_column && !*index_end && index < schema->column_count)
+    return (size_t) index;
+
+  return schema->column_count;
+}
+
+/*---------------------------------------------------------------------------------------------------------------*/
+
+// PURPOSE: Places a column at the first free offset suitable for its type, and returns the following offset.
+static size_t place_column(SchemaColumn *column, size_t offset) {
+  if (column->type == COLUMN_STRING) {
+    column->offset = offset;
+    return offset + column->width + 1;
+  }
+
+  // The numeric columns are aligned to their size.
+  offset = (offset + sizeof(int32_t) - 1) / sizeof(int32_t) * sizeof(int32_t);
+  column->offset = offset;
+  return offset + sizeof(int32_t);
+}
+
+/*---------------------------------------------------------------------------------------------------------------*/
+
+void new_record_schema(RecordSchema **schema) {
+  ASSERT_NULL_PARAMETER(schema, new_record_schema);
+
+  *schema = (RecordSchema *) calloc(1, sizeof(RecordSchema));
+  ASSERT(*schema, "Unable to allocate memory for the schema", new_record_schema);
+}
+
+/*---------------------------------------------------------------------------------------------------------------*/
+
+void clear_record_schema(RecordSchema **schema) {
+  ASSERT_NULL_PARAMETER(schema, clear_record_schema);
+  ASSERT_NULL_PARAMETER(*schema, clear_record_schema);
+
+  free((*schema)->columns);
+  free(*schema);
+  *schema = NULL;
+}
+
+/*---------------------------------------------------------------------------------------------------------------*/
+
+int add_schema_columns(RecordSchema *schema, const char *spec) {
+  SchemaColumn column;
+  const char *begin, *end, *spec_end;
+
+  ASSERT_NULL_PARAMETER(schema, add_schema_columns);
+  ASSERT_NULL_PARAMETER(spec, add_schema_columns);
+
+  spec_end = spec + strcspn(spec, "\r\n");
+
+  for (begin = spec; begin < spec_end; begin = end + 1) {
+    end = (const char *) memchr(begin, ',', (size_t) (spec_end - begin));
+
+    if (!end)
+      end = spec_end;
+
+    if (!parse_column(begin, end, &column))
+      return 0;
+
+    if (schema->column_count == schema->capacity) {
+      schema->capacity = schema->capacity ? schema->capacity * 2 : 8;
+      schema->columns = (SchemaColumn *) realloc(schema->columns, sizeof(SchemaColumn) * schema->capacity);
+      ASSERT(schema->columns, "Unable to allocate memory for the columns of the schema", add_schema_columns);
+    }
+
+    schema->columns[schema->column_count++] = column;
+  }
+
+  return schema->column_count > 0;
+}
+
+/*---------------------------------------------------------------------------------------------------------------*/
+
+int set_schema_key(RecordSchema *schema, const char *key_column) {
+  SchemaColumn *key;
+  size_t offset, i;
+
+  ASSERT_NULL_PARAMETER(schema, set_schema_key);
+  ASSERT_NULL_PARAMETER(key_column, set_schema_key);
+
+  schema->key_column = find_column(schema, key_column);
+
+  if (schema->key_column == schema->column_count)
+    return 0;
+
+  key = &schema->columns[schema->key_column];
+  offset = place_column(key, 0);
+
+  // The numeric columns are packed before the strings, so that only the key may be followed by padding.
+  for (i = 0; i < schema->column_count; ++i) {
+    if (i != schema->key_column && schema->columns[i].type != COLUMN_STRING)
+      offset = place_column(&schema->columns[i], offset);
+  }
+
+  for (i = 0; i < schema->column_count; ++i) {
+    if (i != schema->key_column && schema->columns[i].type == COLUMN_STRING)
+      offset = place_column(&schema->columns[i], offset);
+  }
+
+  // The rows are aligned for their numeric columns.
+  schema->row_size = (offset + sizeof(int32_t) - 1) / sizeof(int32_t) * sizeof(int32_t);
+  schema->max_line_length = 0;
+
+  for (i = 0; i < schema->column_count; ++i) {
+    switch (schema->columns[i].type) {
+      case COLUMN_STRING:
+        schema->max_line_length += schema->columns[i].width + 1;
+        break;
+      case COLUMN_INTEGER:
+        schema->max_line_length += MAX_INTEGER_TEXT_LEN + 1;
+        break;
+      case COLUMN_FLOAT:
+        schema->max_line_length += MAX_FLOAT_TEXT_LEN + 1;
+        break;
+    }
+  }
+
+  // The key is at the beginning of the rows, so the comparators of the plain values compare the rows.
+  switch (key->type) {
+    case COLUMN_STRING:
+      schema->compare = string_comparator;
+      break;
+    case COLUMN_INTEGER:
+      schema->compare = int_comparator;
+      break;
+    case COLUMN_FLOAT:
+      schema->compare = float_comparator;
+      break;
+  }
+
+  return 1;
+}
+
+/*---------------------------------------------------------------------------------------------------------------*/
+
+int parse_schema_row(const RecordSchema *schema, const char *line, size_t length, void *row) {
+  const SchemaColumn *column;
+  const char *begin, *end, *line_end;
+  unsigned char *destination;
+  int32_t integer;
+  float real;
+  size_t i;
+
+  ASSERT_NULL_PARAMETER(schema, parse_schema_row);
+  ASSERT_NULL_PARAMETER(line, parse_schema_row);
+  ASSERT_NULL_PARAMETER(row, parse_schema_row);
+  ASSERT(schema->row_size > 0, "The key of the schema has not been set", parse_schema_row);
+
+  line_end = line + length;
+
+  while (line_end > line && (line_end[-1] == '\n' || line_end[-1] == '\r'))
+    line_end--;
+
+  memset(row, 0, schema->row_size);
+  begin = line;
+
+  for (i = 0; i < schema->column_count; ++i, begin = end + 1) {
+    if (begin > line_end)
+      return 0;
+
+    end = (const char *) memchr(begin, ',', (size_t) (line_end - begin));
+
+    // The last field ends with the line, and every other field with a comma.
+    if (!end == (i + 1 < schema->column_count))
+      return 0;
+
+    if (!end)
+      end = line_end;
+
+    column = &schema->columns[i];
+    destination = (unsigned char *) row + column->offset;
+
+    switch (column->type) {
+      case COLUMN_STRING:
+        if ((size_t) (end - begin) > column->width)
+          return 0;
+
+        memcpy(destination, begin, (size_t) (end - begin));
+        break;
+      case COLUMN_INTEGER:
+        if (!parse_int32(begin, end, &integer))
+          return 0;
+
+        memcpy(destination, &integer, sizeof(integer));
+        break;
+      case COLUMN_FLOAT:
+        if (!parse_float32(begin, end, &real))
+          return 0;
+
+        memcpy(destination, &real, sizeof(real));
+        break;
+    }
+  }
+
+  return 1;
+}
+
+/*---------------------------------------------------------------------------------------------------------------*/
+
+size_t format_schema_row(const RecordSchema *schema, const void *row, char *buffer, size_t size) {
+  const SchemaColumn *column;
+  const unsigned char *source;
+  int32_t integer;
+  float real;
+  size_t length, i;
+  int written;
+
+  ASSERT_NULL_PARAMETER(schema, format_schema_row);
+  ASSERT_NULL_PARAMETER(row, format_schema_row);
+  ASSERT_NULL_PARAMETER(buffer, format_schema_row);
+
+  length = 0;
+
+  for (i = 0; i < schema->column_count; ++i) {
+    column = &schema->columns[i];
+    source = (const unsigned char *) row + column->offset;
+
+    switch (column->type) {
+      case COLUMN_STRING:
+        written = snprintf(buffer + length, size - length, "%s", (const char *) source);
+        break;
+      case COLUMN_INTEGER:
+        memcpy(&integer, source, sizeof(integer));
+        written = snprintf(buffer + length, size - length, "%d", integer);
+        break;
+      case COLUMN_FLOAT:
+        memcpy(&real, source, sizeof(real));
+        written = snprintf(buffer + length, size - length, "%f", real);
+        break;
+      default:
+        written = 0;
+    }
+
+    ASSERT(written >= 0 && (size_t) written + 1 < size - length, "The formatted row does not fit into the buffer",
+           format_schema_row);
+
+    length += (size_t) written;
+    buffer[length++] = i + 1 < schema->column_count ? ',' : '\n';
+  }
+
+  buffer[length] = '\0';
+  return length;
+}
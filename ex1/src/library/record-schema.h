@@ -0,0 +1,106 @@
+#pragma once
+
+#include <stddef.h>
+#include "comparator.h"
+
+#ifndef SCHEMA_COLUMN_NAME_LEN
+/**
+ * @brief The max length of the name of a column of a schema (including the null terminator).
+ *
+ * @remark This number can be changed by setting this macro before including this header file.
+ */
+#define SCHEMA_COLUMN_NAME_LEN 32
+#endif
+
+/**
+ * @brief Defines the types of the columns of a schema.
+ */
+typedef enum ColumnType {
+  /** @brief A string of at most the width of the column (<code>name:string:width</code>). */
+  COLUMN_STRING,
+  /** @brief A 32-bit signed integer (<code>name:int</code>). */
+  COLUMN_INTEGER,
+  /** @brief A 32-bit floating-point number (<code>name:float</code>). */
+  COLUMN_FLOAT
+} ColumnType;
+
+/**
+ * @brief Represents a column of a schema, and its place in the packed rows.
+ */
+typedef struct SchemaColumn {
+  char name[SCHEMA_COLUMN_NAME_LEN];  ///< The name of the column.
+  ColumnType type;  ///< The type of the column.
+  size_t width;  ///< The max length of a string column (0 for the numeric columns).
+  size_t offset;  ///< The offset of the column in a packed row, in bytes.
+} SchemaColumn;
+
+/**
+ * @brief Describes the columns of a record file whose shape is only known at runtime, and the compact fixed-width
+ * layout in which its rows are packed in memory.
+ *
+ * @remark The schema is a comma-separated list of columns, in the order of the fields of a line
+ * (e.g. <code>id:int,name:string:24,score:float</code>). The key column is packed at the beginning of the rows, so its
+ * comparator is the plain comparator of its type (@c int_comparator, @c float_comparator or @c string_comparator),
+ * chosen once when the key is set. The numeric columns follow, then the other string columns, each one taking its
+ * width plus the null terminator.
+ */
+typedef struct RecordSchema {
+  SchemaColumn *columns;  ///< The columns, in the order of the fields of a line.
+  size_t column_count;  ///< Number of columns.
+  size_t capacity;  ///< Number of columns which can be stored without growing the array.
+  size_t key_column;  ///< Index of the key column.
+  size_t row_size;  ///< Size of a packed row, in bytes (0 until the key is set).
+  size_t max_line_length;  ///< Max length of a formatted row, including the line terminator.
+  compare_fn compare;  ///< The comparator of the packed rows by their key (NULL until the key is set).
+} RecordSchema;
+
+/**
+ * @brief Allocates a new schema, without columns.
+ * @param schema Pointer to the pointer that will hold the schema.
+ */
+void new_record_schema(RecordSchema **schema);
+
+/**
+ * @brief Deallocates the specified schema.
+ * @param schema Pointer to the schema to be cleared.
+ */
+void clear_record_schema(RecordSchema **schema);
+
+/**
+ * @brief Appends the columns described by a comma-separated list (<code>name:int</code>, <code>name:float</code> or
+ * <code>name:string:width</code>) to the schema.
+ * @param schema The schema.
+ * @param spec The list of columns (a line terminator is ignored, so it can be the header row of a record file).
+ * @return 1 if the columns have been added, 0 if the list is malformed.
+ */
+int add_schema_columns(RecordSchema *schema, const char *spec);
+
+/**
+ * @brief Sets the key column of the schema, and computes the layout of the packed rows and their comparator.
+ * @param schema The schema.
+ * @param key_column The name or the (0-based) index of the key column.
+ * @return 1 if the key has been set, 0 if there is no such column.
+ */
+int set_schema_key(RecordSchema *schema, const char *key_column);
+
+/**
+ * @brief Parses a line of a record file into a packed row.
+ * @param schema The schema, whose key has been set.
+ * @param line The line.
+ * @param length The length of the line (with or without its line terminator).
+ * @param row The destination row, of @c row_size bytes.
+ * @return 1 if the line has been parsed, 0 if it is malformed (wrong number of fields, invalid number, or a string
+ * longer than the width of its column).
+ */
+int parse_schema_row(const RecordSchema *schema, const char *line, size_t length, void *row);
+
+/**
+ * @brief Formats a packed row as a line of comma-separated fields (the floats are printed with 6 decimals, as the
+ * record writer does).
+ * @param schema The schema, whose key has been set.
+ * @param row The row.
+ * @param buffer The destination buffer, of at least @c max_line_length bytes plus the null terminator.
+ * @param size The size of the destination buffer, in bytes.
+ * @return The number of characters written into the buffer (excluding the null terminator).
+ */
+size_t format_schema_row(const RecordSchema *schema, const void *row, char *buffer, size_t size);
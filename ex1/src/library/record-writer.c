@@ -0,0 +1,514 @@
+// NOTE: syscall() is only declared by glibc with the GNU extensions (io_uring has no libc wrapper).
+#define _GNU_SOURCE
+
+#include <malloc.h>
+#include <string.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include "record-writer.h"
+#include "assert_util.h"
+
+#if defined(__linux__) && defined(__has_include)
+#if __has_include(<linux/io_uring.h>)
+#define HAS_IO_URING 1
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <linux/io_uring.h>
+#endif
+#endif
+
+/*---------------------------------------------------------------------------------------------------------------*/
+
+// PURPOSE: The max length of a formatted record.
+// NOTE: A buffer is submitted as soon as its free space is lower than this value.
+#define MAX_FORMATTED_RECORD_LEN (2 * LINE_BUFFER_SIZE)
+
+/*---------------------------------------------------------------------------------------------------------------*/
+
+// PURPOSE: Writes the whole buffer at the specified offset of the file, retrying after partial writes.
+static void pwrite_all(int fd, const char *buffer, size_t length, uint64_t offset) {
+  ssize_t written;
+
+  while (length > 0) {
+    written = pwrite(fd, buffer, length, (off_t) offset);
+
+    if (written < 0 && errno == EINTR)
+      continue;
+
+    ASSERT(written > 0, "Unable to write a buffer to the output file", pwrite_all);
+    buffer += written;
+    length -= (size_t) written;
+    offset += (uint64_t) written;
+  }
+}
+
+/*---------------------------------------------------------------------------------------------------------------*/
+
+#ifdef HAS_IO_URING
+
+// PURPOSE: Represents an io_uring instance, with its submission and completion rings mapped into memory.
+typedef struct IoUring {
+  int fd;
+  unsigned *sq_head, *sq_tail, *sq_mask, *sq_array;
+  unsigned *cq_head, *cq_tail, *cq_mask;
+  struct io_uring_sqe *sqes;
+  struct io_uring_cqe *cqes;
+  void *sq_ring, *cq_ring;
+  size_t sq_ring_size, cq_ring_size, sqes_size;
+  struct iovec iovecs[RECORD_WRITER_BUFFER_COUNT];
+} IoUring;
+
+/*---------------------------------------------------------------------------------------------------------------*/
+
+// PURPOSE: Releases the rings and the descriptor of an io_uring instance.
+static void close_io_uring(IoUring *ring) {
+  if (ring->sqes && ring->sqes != MAP_FAILED) munmap(ring->sqes, ring->sqes_size);
+  if (ring->cq_ring && ring->cq_ring != MAP_FAILED && ring->cq_ring != ring->sq_ring)
+    munmap(ring->cq_ring, ring->cq_ring_size);
+  if (ring->sq_ring && ring->sq_ring != MAP_FAILED) munmap(ring->sq_ring, ring->sq_ring_size);
+  close(ring->fd);
+  free(ring);
+}
+
+/*---------------------------------------------------------------------------------------------------------------*/
+
+// PURPOSE: Creates an io_uring instance able to hold a write for each buffer. Returns NULL if io_uring is not
+//          available (old kernels, or kernels which disable it).
+static IoUring *open_io_uring(void) {
+  struct io_uring_params params;
+  IoUring *ring;
+  char *sq, *cq;
+
+  ring = (IoUring *) calloc(1, sizeof(IoUring));
+  ASSERT(ring, "Unable to allocate memory for the io_uring instance", open_io_uring);
+
+  memset(&params, 0, sizeof(params));
+  ring->fd = (int) syscall(__NR_io_uring_setup, RECORD_WRITER_BUFFER_COUNT, &params);
+
+  if (ring->fd < 0) {
+    free(ring);
+    return NULL;
+  }
+
+  ring->sq_ring_size = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+  ring->cq_ring_size = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+
+  if (params.features & IORING_FEAT_SINGLE_MMAP) {
+    if (ring->cq_ring_size > ring->sq_ring_size) ring->sq_ring_size = ring->cq_ring_size;
+    ring->cq_ring_size = ring->sq_ring_size;
+  }
+
+  ring->sq_ring = mmap(NULL, ring->sq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED, ring->fd, IORING_OFF_SQ_RING);
+  ring->cq_ring = (params.features & IORING_FEAT_SINGLE_MMAP) ? ring->sq_ring :
+                  mmap(NULL, ring->cq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED, ring->fd, IORING_OFF_CQ_RING);
+  ring->sqes_size = params.sq_entries * sizeof(struct io_uring_sqe);
+  ring->sqes = (struct io_uring_sqe *) mmap(NULL, ring->sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED, ring->fd,
+                                            IORING_OFF_SQES);
+
+  if (ring->sq_ring == MAP_FAILED || ring->cq_ring == MAP_FAILED || ring->sqes == MAP_FAILED) {
+    close_io_uring(ring);
+    return NULL;
+  }
+
+  sq = (char *) ring->sq_ring;
+  cq = (char *) ring->cq_ring;
+  ring->sq_head = (unsigned *) (sq + params.sq_off.head);
+  ring->sq_tail = (unsigned *) (sq + params.sq_off.tail);
+  ring->sq_mask = (unsigned *) (sq + params.sq_off.ring_mask);
+  ring->sq_array = (unsigned *) (sq + params.sq_off.array);
+  ring->cq_head = (unsigned *) (cq + params.cq_off.head);
+  ring->cq_tail = (unsigned *) (cq + params.cq_off.tail);
+  ring->cq_mask = (unsigned *) (cq + params.cq_off.ring_mask);
+  ring->cqes = (struct io_uring_cqe *) (cq + params.cq_off.cqes);
+
+  return ring;
+}
+
+/*---------------------------------------------------------------------------------------------------------------*/
+
+// PURPOSE: Queues the write of a buffer, and submits it to the kernel.
+static void submit_io_uring_write(RecordWriter *writer, size_t index) {
+  IoUring *ring;
+  struct io_uring_sqe *sqe;
+  unsigned tail, slot;
+  long submitted;
+
+  ring = writer->ring;
+  ring->iovecs[index].iov_base = writer->buffers[index];
+  ring->iovecs[index].iov_len = writer->lengths[index];
+
+  tail = *ring->sq_tail;
+  slot = tail & *ring->sq_mask;
+  sqe = &ring->sqes[slot];
+
+  // Vectored writes are supported by every kernel which supports io_uring.
+  memset(sqe, 0, sizeof(struct io_uring_sqe));
+  sqe->opcode = IORING_OP_WRITEV;
+  sqe->fd = writer->fd;
+  sqe->off = writer->buffer_offsets[index];
+  sqe->addr = (uint64_t) (uintptr_t) &ring->iovecs[index];
+  sqe->len = 1;
+  sqe->user_data = index;
+
+  ring->sq_array[slot] = slot;
+  __atomic_store_n(ring->sq_tail, tail + 1, __ATOMIC_RELEASE);
+
+  do {
+    submitted = syscall(__NR_io_uring_enter, ring->fd, 1, 0, 0, NULL, 0);
+  } while (submitted < 0 && errno == EINTR);
+
+  ASSERT(submitted == 1, "Unable to submit a write to io_uring", submit_io_uring_write);
+}
+
+/*---------------------------------------------------------------------------------------------------------------*/
+
+// PURPOSE: Waits for at least one write to complete, and marks the completed buffers as free.
+// NOTE: A partial write is completed synchronously.
+static void wait_io_uring_writes(RecordWriter *writer) {
+  IoUring *ring;
+  struct io_uring_cqe *cqe;
+  unsigned head, tail;
+  size_t index;
+  long res;
+
+  ring = writer->ring;
+
+  do {
+    res = syscall(__NR_io_uring_enter, ring->fd, 0, 1, IORING_ENTER_GETEVENTS, NULL, 0);
+  } while (res < 0 && errno == EINTR);
+
+  ASSERT(res >= 0, "Unable to wait for the io_uring writes", wait_io_uring_writes);
+
+  head = *ring->cq_head;
+  tail = __atomic_load_n(ring->cq_tail, __ATOMIC_ACQUIRE);
+
+  for (; head != tail; ++head) {
+    cqe = &ring->cqes[head & *ring->cq_mask];
+    index = (size_t) cqe->user_data;
+
+    ASSERT(cqe->res >= 0, "Unable to write a buffer to the output file", wait_io_uring_writes);
+
+    if ((size_t) cqe->res < writer->lengths[index])
+      pwrite_all(writer->fd, writer->buffers[index] + cqe->res, writer->lengths[index] - (size_t) cqe->res,
+                 writer->buffer_offsets[index] + (uint64_t) cqe->res);
+
+    writer->lengths[index] = 0;
+    writer->in_flight[index] = 0;
+  }
+
+  __atomic_store_n(ring->cq_head, head, __ATOMIC_RELEASE);
+}
+
+#endif
+
+/*---------------------------------------------------------------------------------------------------------------*/
+
+// PURPOSE: Writes the submitted buffers, in order, until the writer is closed (fwrite and pwrite backends).
+static void *writer_thread_fn(void *arg) {
+  RecordWriter *writer;
+  size_t index;
+
+  writer = (RecordWriter *) arg;
+
+  for (;;) {
+    pthread_mutex_lock(&writer->mutex);
+
+    while (!writer->pending && !writer->closing)
+      pthread_cond_wait(&writer->cond_pending, &writer->mutex);
+
+    if (!writer->pending) {
+      pthread_mutex_unlock(&writer->mutex);
+      return NULL;
+    }
+
+    index = writer->flush_index;
+    pthread_mutex_unlock(&writer->mutex);
+
+    if (writer->backend == RECORD_WRITER_PWRITE)
+      pwrite_all(writer->fd, writer->buffers[index], writer->lengths[index], writer->buffer_offsets[index]);
+    else
+      ASSERT(fwrite(writer->buffers[index], 1, writer->lengths[index], writer->file) == writer->lengths[index],
+             "Unable to write a buffer to the output file", writer_thread_fn);
+
+    pthread_mutex_lock(&writer->mutex);
+    writer->lengths[index] = 0;
+    writer->flush_index = (index + 1) % RECORD_WRITER_BUFFER_COUNT;
+    writer->pending--;
+    pthread_cond_signal(&writer->cond_free);
+    pthread_mutex_unlock(&writer->mutex);
+  }
+}
+
+/*---------------------------------------------------------------------------------------------------------------*/
+
+// PURPOSE: Hands the buffer being filled to the backend, and waits for the next buffer to be free.
+static void submit_buffer(RecordWriter *writer) {
+  size_t index;
+
+  index = writer->fill_index;
+  writer->buffer_offsets[index] = writer->offset;
+  writer->offset += writer->lengths[index];
+  writer->bytes_written += writer->lengths[index];
+
+#ifdef HAS_IO_URING
+  if (writer->backend == RECORD_WRITER_IO_URING) {
+    writer->in_flight[index] = 1;
+    submit_io_uring_write(writer, index);
+    writer->fill_index = (index + 1) % RECORD_WRITER_BUFFER_COUNT;
+
+    while (writer->in_flight[writer->fill_index])
+      wait_io_uring_writes(writer);
+
+    return;
+  }
+#endif
+
+  pthread_mutex_lock(&writer->mutex);
+
+  writer->pending++;
+  writer->fill_index = (index + 1) % RECORD_WRITER_BUFFER_COUNT;
+  pthread_cond_signal(&writer->cond_pending);
+
+  while (writer->pending == RECORD_WRITER_BUFFER_COUNT)
+    pthread_cond_wait(&writer->cond_free, &writer->mutex);
+
+  pthread_mutex_unlock(&writer->mutex);
+}
+
+/*---------------------------------------------------------------------------------------------------------------*/
+
+// PURPOSE: Prepares the positioned writes of the file, returning 0 if the file is not a regular file.
+// NOTE: The file stream is flushed, and the writes start at its current position.
+static int open_positioned_writes(RecordWriter *writer) {
+  struct stat st;
+  off_t position;
+
+  ASSERT(!fflush(writer->file), "Unable to flush the output file", open_positioned_writes);
+
+  writer->fd = fileno(writer->file);
+
+  if (writer->fd < 0 || fstat(writer->fd, &st) || !S_ISREG(st.st_mode))
+    return 0;
+
+  position = lseek(writer->fd, 0, SEEK_CUR);
+
+  if (position < 0)
+    return 0;
+
+  writer->offset = (uint64_t) position;
+  return 1;
+}
+
+/*---------------------------------------------------------------------------------------------------------------*/
+
+void new_record_writer(RecordWriter **writer, FILE *file) {
+  new_record_writer_backend(writer, file, RECORD_WRITER_STDIO, 0);
+}
+
+/*---------------------------------------------------------------------------------------------------------------*/
+
+void new_record_writer_backend(RecordWriter **writer, FILE *file, RecordWriterBackend backend, int report) {
+  size_t i;
+
+  ASSERT_NULL_PARAMETER(writer, new_record_writer_backend);
+  ASSERT_NULL_PARAMETER(file, new_record_writer_backend);
+
+  *writer = (RecordWriter *) malloc(sizeof(RecordWriter));
+  ASSERT(*writer, "Unable to allocate memory for the record writer", new_record_writer_backend);
+
+  (*writer)->file = file;
+
+  for (i = 0; i < RECORD_WRITER_BUFFER_COUNT; ++i) {
+    (*writer)->buffers[i] = (char *) malloc(RECORD_WRITER_BUFFER_SIZE);
+    ASSERT((*writer)->buffers[i], "Unable to allocate memory for a writer buffer", new_record_writer_backend);
+    (*writer)->lengths[i] = 0;
+    (*writer)->in_flight[i] = 0;
+  }
+
+  (*writer)->fill_index = (*writer)->flush_index = (*writer)->pending = 0;
+  (*writer)->closing = 0;
+  (*writer)->fd = -1;
+  (*writer)->offset = 0;
+  (*writer)->ring = NULL;
+  (*writer)->bytes_written = 0;
+  (*writer)->report = report;
+
+  // Each backend falls back to the next simpler one when it is not available.
+  if (backend != RECORD_WRITER_STDIO && !open_positioned_writes(*writer))
+    backend = RECORD_WRITER_STDIO;
+
+#ifdef HAS_IO_URING
+  if (backend == RECORD_WRITER_IO_URING && !((*writer)->ring = open_io_uring()))
+    backend = RECORD_WRITER_PWRITE;
+#else
+  if (backend == RECORD_WRITER_IO_URING)
+    backend = RECORD_WRITER_PWRITE;
+#endif
+
+  (*writer)->backend = backend;
+
+  ASSERT(!pthread_mutex_init(&(*writer)->mutex, NULL), "Unable to initialize the writer mutex", new_record_writer_backend);
+  ASSERT(!pthread_cond_init(&(*writer)->cond_pending, NULL), "Unable to initialize a writer condition", new_record_writer_backend);
+  ASSERT(!pthread_cond_init(&(*writer)->cond_free, NULL), "Unable to initialize a writer condition", new_record_writer_backend);
+
+  if (backend != RECORD_WRITER_IO_URING)
+    ASSERT(!pthread_create(&(*writer)->thread, NULL, writer_thread_fn, *writer), "Unable to start the writer thread",
+           new_record_writer_backend);
+
+  clock_gettime(CLOCK_MONOTONIC, &(*writer)->start_time);
+}
+
+/*---------------------------------------------------------------------------------------------------------------*/
+
+// PURPOSE: Prints the backend used by the writer and the achieved write bandwidth.
+static void report_bandwidth(const RecordWriter *writer) {
+  struct timespec end_time;
+  double seconds;
+
+  clock_gettime(CLOCK_MONOTONIC, &end_time);
+  seconds = (double) (end_time.tv_sec - writer->start_time.tv_sec) +
+            (double) (end_time.tv_nsec - writer->start_time.tv_nsec) / 1e9;
+
+  fprintf(stderr, "[WRITER]<backend=%s>: Wrote %llu bytes in %f seconds (%.1f MB/s).\n",
+          get_record_writer_backend_name(writer->backend), (unsigned long long) writer->bytes_written, seconds,
+          seconds > 0 ? (double) writer->bytes_written / seconds / 1e6 : 0.0);
+}
+
+/*---------------------------------------------------------------------------------------------------------------*/
+
+void clear_record_writer(RecordWriter **writer) {
+  size_t i;
+
+  ASSERT_NULL_PARAMETER(writer, clear_record_writer);
+  ASSERT_NULL_PARAMETER(*writer, clear_record_writer);
+
+#ifdef HAS_IO_URING
+  if ((*writer)->backend == RECORD_WRITER_IO_URING) {
+    if ((*writer)->lengths[(*writer)->fill_index] > 0)
+      submit_buffer(*writer);
+
+    for (i = 0; i < RECORD_WRITER_BUFFER_COUNT; ++i) {
+      while ((*writer)->in_flight[i])
+        wait_io_uring_writes(*writer);
+    }
+
+    close_io_uring((*writer)->ring);
+  }
+#endif
+
+  if ((*writer)->backend != RECORD_WRITER_IO_URING) {
+    pthread_mutex_lock(&(*writer)->mutex);
+
+    if ((*writer)->lengths[(*writer)->fill_index] > 0) {
+      i = (*writer)->fill_index;
+      (*writer)->buffer_offsets[i] = (*writer)->offset;
+      (*writer)->offset += (*writer)->lengths[i];
+      (*writer)->bytes_written += (*writer)->lengths[i];
+      (*writer)->pending++;
+      (*writer)->fill_index = (i + 1) % RECORD_WRITER_BUFFER_COUNT;
+    }
+
+    (*writer)->closing = 1;
+    pthread_cond_signal(&(*writer)->cond_pending);
+    pthread_mutex_unlock(&(*writer)->mutex);
+
+    ASSERT(!pthread_join((*writer)->thread, NULL), "Unable to join the writer thread", clear_record_writer);
+  }
+
+  // The positioned writes bypass the file stream, which is moved after the written bytes.
+  if ((*writer)->backend == RECORD_WRITER_STDIO)
+    ASSERT(!fflush((*writer)->file), "Unable to flush the output file", clear_record_writer);
+  else
+    ASSERT(!fseeko((*writer)->file, (off_t) (*writer)->offset, SEEK_SET), "Unable to seek the output file",
+           clear_record_writer);
+
+  if ((*writer)->report)
+    report_bandwidth(*writer);
+
+  pthread_mutex_destroy(&(*writer)->mutex);
+  pthread_cond_destroy(&(*writer)->cond_pending);
+  pthread_cond_destroy(&(*writer)->cond_free);
+
+  for (i = 0; i < RECORD_WRITER_BUFFER_COUNT; ++i)
+    free((*writer)->buffers[i]);
+
+  free(*writer);
+  *writer = NULL;
+}
+
+/*---------------------------------------------------------------------------------------------------------------*/
+
+size_t format_record(char *buffer, size_t size, const Record *record) {
+  int length;
+
+  ASSERT_NULL_PARAMETER(buffer, format_record);
+  ASSERT_NULL_PARAMETER(record, format_record);
+
+  length = snprintf(buffer, size, "%zu,%s,%d,%f\n",
+                    record->id,
+                    record->string_field,
+                    record->int_field,
+                    record->float_field);
+
+  ASSERT(length >= 0 && (size_t) length < size, "The formatted record does not fit into the buffer", format_record);
+  return (size_t) length;
+}
+
+/*---------------------------------------------------------------------------------------------------------------*/
+
+void write_record(RecordWriter *writer, const Record *record) {
+  size_t index;
+
+  ASSERT_NULL_PARAMETER(writer, write_record);
+  ASSERT_NULL_PARAMETER(record, write_record);
+
+  index = writer->fill_index;
+  writer->lengths[index] += format_record(writer->buffers[index] + writer->lengths[index],
+                                          RECORD_WRITER_BUFFER_SIZE - writer->lengths[index], record);
+
+  if (RECORD_WRITER_BUFFER_SIZE - writer->lengths[index] < MAX_FORMATTED_RECORD_LEN)
+    submit_buffer(writer);
+}
+
+/*---------------------------------------------------------------------------------------------------------------*/
+
+void write_record_bytes(RecordWriter *writer, const char *bytes, size_t size) {
+  size_t index, chunk_size;
+
+  ASSERT_NULL_PARAMETER(writer, write_record_bytes);
+  ASSERT(bytes || !size, "'bytes' parameter is NULL", write_record_bytes);
+
+  // The bytes are split across as many buffers as needed.
+  while (size > 0) {
+    index = writer->fill_index;
+    chunk_size = RECORD_WRITER_BUFFER_SIZE - writer->lengths[index];
+    chunk_size = chunk_size < size ? chunk_size : size;
+
+    memcpy(writer->buffers[index] + writer->lengths[index], bytes, chunk_size);
+    writer->lengths[index] += chunk_size;
+    bytes += chunk_size;
+    size -= chunk_size;
+
+    if (RECORD_WRITER_BUFFER_SIZE - writer->lengths[index] < MAX_FORMATTED_RECORD_LEN)
+      submit_buffer(writer);
+  }
+}
+
+/*---------------------------------------------------------------------------------------------------------------*/
+
+const char *get_record_writer_backend_name(RecordWriterBackend backend) {
+  switch (backend) {
+    case RECORD_WRITER_STDIO:
+      return "fwrite";
+    case RECORD_WRITER_PWRITE:
+      return "pwrite";
+    case RECORD_WRITER_IO_URING:
+      return "io_uring";
+  }
+
+  PRINT_ERROR("Invalid writer backend", get_record_writer_backend_name);
+  return NULL;
+}
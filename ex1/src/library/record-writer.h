@@ -0,0 +1,118 @@
+#pragma once
+
+#include <stdio.h>
+#include <stdint.h>
+#include <time.h>
+#include <pthread.h>
+#include "record.h"
+
+/**
+ * @brief The number of buffers of a record writer.
+ */
+#define RECORD_WRITER_BUFFER_COUNT 4
+
+/**
+ * @brief The size of each buffer of a record writer, in bytes.
+ */
+#define RECORD_WRITER_BUFFER_SIZE (1 << 20)
+
+/**
+ * @brief Defines how a record writer writes the full buffers to the file.
+ */
+typedef enum RecordWriterBackend {
+  /** @brief A background thread writes the buffers with @c fwrite. */
+  RECORD_WRITER_STDIO,
+  /** @brief A background thread writes the buffers with @c pwrite, bypassing the buffer of the file stream. */
+  RECORD_WRITER_PWRITE,
+  /**
+   * @brief The buffers are submitted to an io_uring instance, so that several writes are in flight while the next
+   * buffers are being filled (Linux only).
+   */
+  RECORD_WRITER_IO_URING
+} RecordWriterBackend;
+
+/**
+ * @brief Represents a writer of records, which formats the records into a set of buffers while the full buffers are
+ * written to the file in background.
+ *
+ * @remark The buffers are filled and written in round-robin order, so the caller only blocks when all the buffers are
+ * waiting to be written. The @c pwrite and io_uring backends require a regular file, and fall back to the next simpler
+ * backend (io_uring, then @c pwrite, then @c fwrite) when they are not available.
+ */
+typedef struct RecordWriter {
+  FILE *file;  ///< The destination file.
+  char *buffers[RECORD_WRITER_BUFFER_COUNT];  ///< The buffers.
+  size_t lengths[RECORD_WRITER_BUFFER_COUNT];  ///< Number of bytes stored in each buffer.
+  size_t fill_index;  ///< Index of the buffer being filled by the caller.
+  size_t flush_index;  ///< Index of the next buffer to be written by the background thread.
+  size_t pending;  ///< Number of full buffers waiting to be written.
+  int closing;  ///< 1 if no more buffers will be submitted.
+  pthread_mutex_t mutex;  ///< Protects @c pending and @c closing.
+  pthread_cond_t cond_pending;  ///< Signaled when a buffer is submitted or the writer is closing.
+  pthread_cond_t cond_free;  ///< Signaled when a buffer has been written.
+  pthread_t thread;  ///< The background thread (not used by the io_uring backend).
+  RecordWriterBackend backend;  ///< The backend actually used by the writer.
+  int fd;  ///< The descriptor of the destination file (@c pwrite and io_uring backends).
+  uint64_t offset;  ///< Offset in the file of the next submitted buffer (@c pwrite and io_uring backends).
+  uint64_t buffer_offsets[RECORD_WRITER_BUFFER_COUNT];  ///< Offset in the file of each submitted buffer.
+  int in_flight[RECORD_WRITER_BUFFER_COUNT];  ///< 1 if the buffer is being written (io_uring backend).
+  struct IoUring *ring;  ///< The io_uring instance (io_uring backend).
+  uint64_t bytes_written;  ///< Number of bytes submitted to the file.
+  struct timespec start_time;  ///< Time at which the writer has been created.
+  int report;  ///< 1 to print the achieved bandwidth when the writer is cleared.
+} RecordWriter;
+
+/**
+ * @brief Allocates a new writer of the specified file, and starts its background thread (@c fwrite backend).
+ * @param writer Pointer to the pointer that will hold the writer.
+ * @param file The destination file.
+ */
+void new_record_writer(RecordWriter **writer, FILE *file);
+
+/**
+ * @brief Allocates a new writer of the specified file, using the specified backend if it is available.
+ * @param writer Pointer to the pointer that will hold the writer.
+ * @param file The destination file.
+ * @param backend The requested backend.
+ * @param report 1 to print (to @c stderr) the backend used and the achieved write bandwidth when the writer is
+ * cleared.
+ */
+void new_record_writer_backend(RecordWriter **writer, FILE *file, RecordWriterBackend backend, int report);
+
+/**
+ * @brief Writes all the pending buffers, stops the background writes and deallocates the writer.
+ * @param writer Pointer to the writer to be cleared.
+ * @note The destination file is flushed (and positioned after the written bytes), but not closed.
+ */
+void clear_record_writer(RecordWriter **writer);
+
+/**
+ * @brief Formats a record (as a line of comma-separated fields) and appends it to the file.
+ * @param writer The writer.
+ * @param record The record to be written.
+ */
+void write_record(RecordWriter *writer, const Record *record);
+
+/**
+ * @brief Appends raw bytes (e.g. lines copied from a record file) to the file.
+ * @param writer The writer.
+ * @param bytes The bytes to be written.
+ * @param size The number of bytes.
+ */
+void write_record_bytes(RecordWriter *writer, const char *bytes, size_t size);
+
+/**
+ * @brief Formats a record as a line of comma-separated fields.
+ * @param buffer The destination buffer.
+ * @param size The size of the destination buffer, in bytes.
+ * @param record The record to be formatted.
+ * @return The number of characters written into the buffer (excluding the null terminator).
+ */
+size_t format_record(char *buffer, size_t size, const Record *record);
+
+/**
+ * @brief Returns the name of a backend.
+ * @param backend The backend.
+ * @return The name of the backend.
+ */
+const char *get_record_writer_backend_name(RecordWriterBackend backend);
@@ -0,0 +1,25 @@
+#pragma once
+
+#include <stddef.h>
+
+/**
+ * @brief The max length of a line of the record file.
+ */
+#define LINE_BUFFER_SIZE 128
+
+/**
+ * @brief The max length of the string field.
+ *
+ * @note Strings are stored statically to prevent allocations and memory fragmentation.
+ */
+#define STRING_FIELD_LEN 32
+
+/**
+ * @brief Represents a record read from the record file.
+ */
+typedef struct Record {
+  size_t id;  ///< The unique identifier of the record.
+  char string_field[STRING_FIELD_LEN];  ///< The string field (null-terminated).
+  int int_field;  ///< The integer field.
+  float float_field;  ///< The floating-point field.
+} Record;
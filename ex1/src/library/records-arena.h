@@ -0,0 +1,35 @@
+#pragma once
+
+#include <stdio.h>
+#include "records-sorter.h"
+
+#ifndef ARENA_INITIAL_CAPACITY
+/**
+ * @brief Defines the initial number of bytes of the string arena of the records, which grows as needed.
+ *
+ * @remark This number can be changed by setting this macro before including this header file.
+ */
+#define ARENA_INITIAL_CAPACITY ((size_t) 1 << 20)
+#endif
+
+/**
+ * @brief Sorts the records with their string fields stored in a string arena (see @c string-arena.h), rather than in
+ * the fixed-size string field of @c Record.
+ *
+ * @remark Each record holds a handle of its string field (its length, its first bytes and its offset in the arena)
+ * instead of the string itself, so the records moved by the sorting algorithm are smaller than a @c Record, and the
+ * string fields can be of any length (they are not truncated to <code>STRING_FIELD_LEN - 1</code> bytes). Most
+ * comparisons of the string fields are decided by the prefixes stored in the handles, without reading the arena.
+ *
+ * @remark The records are sorted by the engine of the options (the counting sort and the branchless merge sort of
+ * @c Record do not apply). The filters compare the truncated string fields, and the cache is not used. The records
+ * cannot be aggregated, since the aggregated rows are formatted from a @c Record.
+ *
+ * @param in_file The .csv file containing the records.
+ * @param out_file The .txt file in which the sorted records will be written.
+ * @param sorting_threshold The sorting threshold to be passed to the sorting algorithm.
+ * @param field_id The type of the fields to be sorted.
+ * @param options The options of the sorter (the engine, the number of threads, the filter and the writer backend).
+ */
+void sort_records_arena(FILE *in_file, FILE *out_file, size_t sorting_threshold, FieldId field_id,
+                        const SortOptions *options);
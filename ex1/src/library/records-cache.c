@@ -0,0 +1,345 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <malloc.h>
+#include <string.h>
+#include <stdlib.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "records-cache.h"
+#include "assert_util.h"
+
+/*---------------------------------------------------------------------------------------------------------------*/
+
+// PURPOSE: Identifies a records cache file.
+#define CACHE_MAGIC "RECCACHE"
+
+// PURPOSE: The version of the cache file format. Must be increased whenever the layout changes.
+#define CACHE_VERSION 1
+
+// PURPOSE: The number of columns stored in the cache.
+#define CACHE_FIELD_COUNT 4
+
+// PURPOSE: The alignment of the header and of each column inside the cache file.
+#define CACHE_ALIGNMENT 64
+
+// PURPOSE: The number of records gathered into a column buffer before being written.
+#define CACHE_WRITE_BATCH 4096
+
+// PURPOSE: Rounds the specified size up to the cache alignment.
+#define ALIGN_UP(size) (((size) + CACHE_ALIGNMENT - 1) / CACHE_ALIGNMENT * CACHE_ALIGNMENT)
+
+// PURPOSE: Represents the header of a cache file.
+typedef struct CacheHeader {
+  char magic[8];
+  uint32_t version;
+  uint32_t field_count;
+  uint32_t field_widths[CACHE_FIELD_COUNT];
+  uint64_t count;
+  int64_t source_mtime_sec;
+  int64_t source_mtime_nsec;
+  uint64_t source_size;
+} CacheHeader;
+
+// PURPOSE: The widths of the id, string, int and float columns, in this order.
+static const uint32_t g_field_widths[CACHE_FIELD_COUNT] = {
+    sizeof(uint64_t), STRING_FIELD_LEN, sizeof(int32_t), sizeof(float)
+};
+
+/*---------------------------------------------------------------------------------------------------------------*/
+
+// PURPOSE: Computes the offset of each column and the total size of a cache holding the specified number of records.
+static size_t compute_layout(uint64_t count, size_t offsets[CACHE_FIELD_COUNT]) {
+  size_t offset;
+  int i;
+
+  offset = ALIGN_UP(sizeof(CacheHeader));
+
+  for (i = 0; i < CACHE_FIELD_COUNT; ++i) {
+    offsets[i] = offset;
+    offset += ALIGN_UP(count * g_field_widths[i]);
+  }
+
+  return offset;
+}
+
+/*---------------------------------------------------------------------------------------------------------------*/
+
+// PURPOSE: Fills the header fields that depend on the source file.
+static int stat_source(FILE *source_file, CacheHeader *header) {
+  struct stat st;
+
+  if (fstat(fileno(source_file), &st))
+    return 0;
+
+  header->source_mtime_sec = (int64_t) st.st_mtim.tv_sec;
+  header->source_mtime_nsec = (int64_t) st.st_mtim.tv_nsec;
+  header->source_size = (uint64_t) st.st_size;
+  return 1;
+}
+
+/*---------------------------------------------------------------------------------------------------------------*/
+
+// PURPOSE: Returns 1 if the header describes a cache built by this version from the current source file.
+static int is_header_valid(const CacheHeader *header, const CacheHeader *expected, size_t file_size) {
+  size_t offsets[CACHE_FIELD_COUNT];
+
+  if (memcmp(header->magic, CACHE_MAGIC, sizeof(header->magic)) != 0) return 0;
+  if (header->version != CACHE_VERSION || header->field_count != CACHE_FIELD_COUNT) return 0;
+  if (memcmp(header->field_widths, g_field_widths, sizeof(g_field_widths)) != 0) return 0;
+
+  if (header->source_mtime_sec != expected->source_mtime_sec ||
+      header->source_mtime_nsec != expected->source_mtime_nsec ||
+      header->source_size != expected->source_size)
+    return 0;
+
+  return compute_layout(header->count, offsets) == file_size;
+}
+
+/*---------------------------------------------------------------------------------------------------------------*/
+
+int open_records_cache(RecordsCache **cache, const char *cache_path, FILE *source_file) {
+  CacheHeader expected;
+  const CacheHeader *header;
+  size_t offsets[CACHE_FIELD_COUNT];
+  struct stat st;
+  void *mapping;
+  int fd;
+
+  ASSERT_NULL_PARAMETER(cache, open_records_cache);
+  ASSERT_NULL_PARAMETER(cache_path, open_records_cache);
+  ASSERT_NULL_PARAMETER(source_file, open_records_cache);
+
+  *cache = NULL;
+
+  if (!stat_source(source_file, &expected))
+    return 0;
+
+  fd = open(cache_path, O_RDONLY);
+  if (fd < 0)
+    return 0;
+
+  if (fstat(fd, &st) || (size_t) st.st_size < sizeof(CacheHeader)) {
+    close(fd);
+    return 0;
+  }
+
+  mapping = mmap(NULL, (size_t) st.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+  close(fd);
+
+  if (mapping == MAP_FAILED)
+    return 0;
+
+  header = (const CacheHeader *) mapping;
+
+  if (!is_header_valid(header, &expected, (size_t) st.st_size)) {
+    munmap(mapping, (size_t) st.st_size);
+    return 0;
+  }
+
+  posix_madvise(mapping, (size_t) st.st_size, POSIX_MADV_SEQUENTIAL);
+  posix_madvise(mapping, (size_t) st.st_size, POSIX_MADV_WILLNEED);
+  compute_layout(header->count, offsets);
+
+  *cache = (RecordsCache *) malloc(sizeof(RecordsCache));
+  ASSERT(*cache, "Unable to allocate memory for the records cache", open_records_cache);
+
+  (*cache)->mapping = mapping;
+  (*cache)->mapping_size = (size_t) st.st_size;
+  (*cache)->columns.count = (size_t) header->count;
+  (*cache)->columns.capacity = 0;
+  (*cache)->columns.ids = (uint64_t *) ((char *) mapping + offsets[0]);
+  (*cache)->columns.string_fields = (char (*)[STRING_FIELD_LEN]) ((char *) mapping + offsets[1]);
+  (*cache)->columns.int_fields = (int32_t *) ((char *) mapping + offsets[2]);
+  (*cache)->columns.float_fields = (float *) ((char *) mapping + offsets[3]);
+
+  return 1;
+}
+
+/*---------------------------------------------------------------------------------------------------------------*/
+
+void close_records_cache(RecordsCache **cache) {
+  ASSERT_NULL_PARAMETER(cache, close_records_cache);
+  ASSERT_NULL_PARAMETER(*cache, close_records_cache);
+
+  ASSERT(!munmap((*cache)->mapping, (*cache)->mapping_size), "Unable to unmap the cache file", close_records_cache);
+  free(*cache);
+  *cache = NULL;
+}
+
+/*---------------------------------------------------------------------------------------------------------------*/
+
+void gather_records_cache(const RecordsCache *cache, Record *records, size_t count) {
+  size_t i;
+
+  ASSERT_NULL_PARAMETER(cache, gather_records_cache);
+  ASSERT_NULL_PARAMETER(records, gather_records_cache);
+  ASSERT(count <= cache->columns.count, "The cache does not contain enough records", gather_records_cache);
+
+  for (i = 0; i < count; ++i)
+    get_record_columns(&cache->columns, i, &records[i]);
+}
+
+/*---------------------------------------------------------------------------------------------------------------*/
+
+// PURPOSE: Copies the specified field of a batch of records into a contiguous buffer.
+static void gather_column(const Record *records, size_t count, int column, unsigned char *buffer) {
+  size_t i;
+  uint64_t id;
+  int32_t int_field;
+
+  for (i = 0; i < count; ++i) {
+    switch (column) {
+      case 0:
+        id = (uint64_t) records[i].id;
+        memcpy(buffer + i * sizeof(uint64_t), &id, sizeof(uint64_t));
+        break;
+      case 1:
+        memcpy(buffer + i * STRING_FIELD_LEN, records[i].string_field, STRING_FIELD_LEN);
+        break;
+      case 2:
+        int_field = (int32_t) records[i].int_field;
+        memcpy(buffer + i * sizeof(int32_t), &int_field, sizeof(int32_t));
+        break;
+      default:
+        memcpy(buffer + i * sizeof(float), &records[i].float_field, sizeof(float));
+        break;
+    }
+  }
+}
+
+/*---------------------------------------------------------------------------------------------------------------*/
+
+// PURPOSE: Writes zeroes to the file until its position reaches the specified offset.
+static int pad_to(FILE *file, size_t offset) {
+  static const unsigned char zeroes[CACHE_ALIGNMENT] = {0};
+  long position;
+
+  position = ftell(file);
+  if (position < 0)
+    return 0;
+
+  return fwrite(zeroes, 1, offset - (size_t) position, file) == offset - (size_t) position;
+}
+
+/*---------------------------------------------------------------------------------------------------------------*/
+
+// PURPOSE: Returns a pointer to the specified column of a column layout.
+static const void *get_column(const RecordColumns *columns, int column) {
+  switch (column) {
+    case 0:
+      return columns->ids;
+    case 1:
+      return columns->string_fields;
+    case 2:
+      return columns->int_fields;
+    default:
+      return columns->float_fields;
+  }
+}
+
+/*---------------------------------------------------------------------------------------------------------------*/
+
+// PURPOSE: Writes the header and all the columns into the specified file. The columns are read from the records
+//          array if it is not NULL, otherwise from the column layout.
+static int write_cache_file(FILE *file, const CacheHeader *header, const Record *records,
+                            const RecordColumns *columns) {
+  size_t offsets[CACHE_FIELD_COUNT], total_size, count, i, batch;
+  unsigned char *buffer;
+  int column, ok;
+
+  count = (size_t) header->count;
+  total_size = compute_layout(header->count, offsets);
+  buffer = (unsigned char *) malloc(CACHE_WRITE_BATCH * STRING_FIELD_LEN);
+  ASSERT(buffer, "Unable to allocate memory for the cache column buffer", write_cache_file);
+
+  ok = fwrite(header, sizeof(CacheHeader), 1, file) == 1;
+
+  for (column = 0; ok && column < CACHE_FIELD_COUNT; ++column) {
+    ok = pad_to(file, offsets[column]);
+
+    if (!records) {
+      ok = ok && fwrite(get_column(columns, column), g_field_widths[column], count, file) == count;
+      continue;
+    }
+
+    for (i = 0; ok && i < count; i += batch) {
+      batch = count - i < CACHE_WRITE_BATCH ? count - i : CACHE_WRITE_BATCH;
+      gather_column(records + i, batch, column, buffer);
+      ok = fwrite(buffer, g_field_widths[column], batch, file) == batch;
+    }
+  }
+
+  ok = ok && pad_to(file, total_size);
+
+  free(buffer);
+  return ok;
+}
+
+/*---------------------------------------------------------------------------------------------------------------*/
+
+// PURPOSE: Writes a cache file, reading the records either from the records array or from the column layout.
+static void write_cache(const char *cache_path, FILE *source_file, const Record *records,
+                        const RecordColumns *columns, size_t count) {
+  CacheHeader header;
+  char *tmp_path;
+  FILE *file;
+  int ok;
+
+  memset(&header, 0, sizeof(CacheHeader));
+  memcpy(header.magic, CACHE_MAGIC, sizeof(header.magic));
+  header.version = CACHE_VERSION;
+  header.field_count = CACHE_FIELD_COUNT;
+  memcpy(header.field_widths, g_field_widths, sizeof(g_field_widths));
+  header.count = (uint64_t) count;
+
+  if (!stat_source(source_file, &header)) {
+    fprintf(stderr, "WARNING(write_cache): Unable to stat the source file, the cache will not be written.\n");
+    return;
+  }
+
+  tmp_path = (char *) malloc(strlen(cache_path) + sizeof(".tmp"));
+  ASSERT(tmp_path, "Unable to allocate memory for the temporary cache path", write_cache);
+  strcpy(tmp_path, cache_path);
+  strcat(tmp_path, ".tmp");
+
+  file = fopen(tmp_path, "wb");
+
+  if (!file) {
+    fprintf(stderr, "WARNING(write_cache): Unable to create the cache file, the cache will not be written.\n");
+    free(tmp_path);
+    return;
+  }
+
+  ok = write_cache_file(file, &header, records, columns);
+  ok = !fclose(file) && ok;
+  ok = ok && !rename(tmp_path, cache_path);
+
+  if (!ok) {
+    fprintf(stderr, "WARNING(write_cache): Unable to write the cache file.\n");
+    remove(tmp_path);
+  }
+
+  free(tmp_path);
+}
+
+/*---------------------------------------------------------------------------------------------------------------*/
+
+void write_records_cache(const char *cache_path, FILE *source_file, const Record *records, size_t count) {
+  ASSERT_NULL_PARAMETER(cache_path, write_records_cache);
+  ASSERT_NULL_PARAMETER(source_file, write_records_cache);
+  ASSERT(records || !count, "'records' parameter is NULL", write_records_cache);
+
+  write_cache(cache_path, source_file, records, NULL, count);
+}
+
+/*---------------------------------------------------------------------------------------------------------------*/
+
+void write_record_columns_cache(const char *cache_path, FILE *source_file, const RecordColumns *columns) {
+  ASSERT_NULL_PARAMETER(cache_path, write_record_columns_cache);
+  ASSERT_NULL_PARAMETER(source_file, write_record_columns_cache);
+  ASSERT_NULL_PARAMETER(columns, write_record_columns_cache);
+
+  write_cache(cache_path, source_file, NULL, columns, columns->count);
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <stdio.h>
+#include <stdint.h>
+#include "record.h"
+#include "record-columns.h"
+
+/**
+ * @brief Represents a memory-mapped binary cache of the records parsed from a record file.
+ *
+ * @remark The cache stores the records as fixed-width columns (ids, string fields, integer fields and float fields),
+ * preceded by a header which describes the number of records, the schema of the columns, and the modification time
+ * and size of the source file. The columns point directly into the mapped file, which is mapped copy-on-write, so
+ * they can be used in place without any further copy.
+ */
+typedef struct RecordsCache {
+  void *mapping;  ///< Pointer to the beginning of the mapped cache file.
+  size_t mapping_size;  ///< Size of the mapped cache file, in bytes.
+  RecordColumns columns;  ///< The columns stored in the cache (not owned: their capacity is 0).
+} RecordsCache;
+
+/**
+ * @brief Opens the cache stored at the specified path, if it is still valid for the specified source file.
+ *
+ * @param cache Pointer to the pointer that will hold the cache.
+ * @param cache_path The path of the cache file.
+ * @param source_file The record file from which the cache has been built.
+ * @return 1 if the cache has been opened, 0 if it does not exist, it is corrupted or the source file has changed since
+ * it has been written. In the latter case, @c *cache is set to NULL.
+ */
+int open_records_cache(RecordsCache **cache, const char *cache_path, FILE *source_file);
+
+/**
+ * @brief Unmaps and deallocates the specified cache.
+ * @param cache Pointer to the cache to be closed.
+ */
+void close_records_cache(RecordsCache **cache);
+
+/**
+ * @brief Copies the first records of the cache into an array of records.
+ * @param cache The cache to be read.
+ * @param records The destination array, which must be able to hold @c count records.
+ * @param count The number of records to be copied (at most @c cache->columns.count).
+ */
+void gather_records_cache(const RecordsCache *cache, Record *records, size_t count);
+
+/**
+ * @brief Writes the specified records into a cache file bound to the specified source file.
+ *
+ * @remark The cache is first written into a temporary file, which is then renamed, so that a partially written cache
+ * is never observed. If the cache cannot be written, a warning is printed and the function returns.
+ *
+ * @param cache_path The path of the cache file.
+ * @param source_file The record file from which the records have been parsed.
+ * @param records The parsed records.
+ * @param count The number of parsed records.
+ */
+void write_records_cache(const char *cache_path, FILE *source_file, const Record *records, size_t count);
+
+/**
+ * @brief Same as @c write_records_cache, but reads the records from a column layout.
+ *
+ * @param cache_path The path of the cache file.
+ * @param source_file The record file from which the records have been parsed.
+ * @param columns The parsed records.
+ */
+void write_record_columns_cache(const char *cache_path, FILE *source_file, const RecordColumns *columns);
@@ -0,0 +1,168 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <malloc.h>
+#include <stdlib.h>
+#include <sys/mman.h>
+#include "records-external.h"
+#include "merge-binary-insertion-sort.h"
+#include "record-comparator.h"
+#include "record-reader.h"
+#include "record-output.h"
+#include "run-merger.h"
+#include "assert_util.h"
+
+/*---------------------------------------------------------------------------------------------------------------*/
+
+// PURPOSE: Represents a sorted run spilled to a temporary file, and mapped back into memory to be merged.
+typedef struct SpilledRun {
+  FILE *file;
+  Record *records;
+  size_t count;
+} SpilledRun;
+
+// PURPOSE: Represents the list of the spilled runs.
+typedef struct SpilledRuns {
+  SpilledRun *runs;
+  size_t count;
+  size_t capacity;
+} SpilledRuns;
+
+/*---------------------------------------------------------------------------------------------------------------*/
+
+// PURPOSE: Writes a sorted run into a new temporary file, and appends it to the list of the spilled runs.
+static void spill_run(SpilledRuns *spilled, const Record *records, size_t count) {
+  SpilledRun *run;
+
+  if (spilled->count == spilled->capacity) {
+    spilled->capacity = spilled->capacity ? spilled->capacity * 2 : 16;
+    spilled->runs = (SpilledRun *) realloc(spilled->runs, sizeof(SpilledRun) * spilled->capacity);
+    ASSERT(spilled->runs, "Unable to allocate memory for the spilled runs", spill_run);
+  }
+
+  run = &spilled->runs[spilled->count++];
+  run->file = tmpfile();
+  run->records = NULL;
+  run->count = count;
+
+  ASSERT(run->file, "Unable to create a temporary file for a sorted run", spill_run);
+  ASSERT(fwrite(records, sizeof(Record), count, run->file) == count, "Unable to write a sorted run", spill_run);
+  ASSERT(!fflush(run->file), "Unable to write a sorted run", spill_run);
+
+  fprintf(stderr, "Spilled run %zu (%zu records).\n", spilled->count, count);
+}
+
+/*---------------------------------------------------------------------------------------------------------------*/
+
+// PURPOSE: Maps a spilled run back into memory, so that it is paged in on demand while it is merged.
+static void map_run(SpilledRun *run) {
+  void *mapping;
+
+  mapping = mmap(NULL, sizeof(Record) * run->count, PROT_READ, MAP_PRIVATE, fileno(run->file), 0);
+  ASSERT(mapping != MAP_FAILED, "Unable to map a sorted run", map_run);
+
+  posix_madvise(mapping, sizeof(Record) * run->count, POSIX_MADV_SEQUENTIAL);
+  run->records = (Record *) mapping;
+}
+
+/*---------------------------------------------------------------------------------------------------------------*/
+
+// PURPOSE: Merges the spilled runs and the run left in memory (which is the last one), and writes the merged records
+//          into the output file.
+static void merge_runs(FILE *out_file, const SortOptions *options, SpilledRuns *spilled, Record *last_run,
+                       size_t last_count, FieldId field_id, compare_fn compare) {
+  RecordOutput *output;
+  RunMerger *merger;
+  const Record *record;
+  void **runs;
+  size_t *counts, run_count, i;
+
+  run_count = spilled->count + 1;
+  runs = (void **) malloc(sizeof(void *) * run_count);
+  counts = (size_t *) malloc(sizeof(size_t) * run_count);
+  ASSERT(runs && counts, "Unable to allocate memory for the runs", merge_runs);
+
+  // The runs are passed in input order, so that the merge is stable.
+  for (i = 0; i < spilled->count; ++i) {
+    map_run(&spilled->runs[i]);
+    runs[i] = spilled->runs[i].records;
+    counts[i] = spilled->runs[i].count;
+  }
+
+  runs[spilled->count] = last_run;
+  counts[spilled->count] = last_count;
+
+  new_record_output(&output, out_file, field_id, options);
+  new_run_merger(&merger, runs, counts, run_count, sizeof(Record), compare);
+
+  while ((record = (const Record *) next_run_merger(merger)))
+    write_record_output(output, record);
+
+  clear_run_merger(&merger);
+  clear_record_output(&output);
+
+  for (i = 0; i < spilled->count; ++i)
+    munmap(spilled->runs[i].records, sizeof(Record) * spilled->runs[i].count);
+
+  free(counts);
+  free(runs);
+}
+
+/*---------------------------------------------------------------------------------------------------------------*/
+
+void sort_records_external(FILE *in_file, FILE *out_file, size_t sorting_threshold, FieldId field_id,
+                           const SortOptions *options) {
+  RecordReader *reader;
+  SpilledRuns spilled;
+  Record *records;
+  compare_fn compare;
+  size_t memory_budget, capacity, count, i;
+
+  ASSERT_NULL_PARAMETER(in_file, sort_records_external);
+  ASSERT_NULL_PARAMETER(out_file, sort_records_external);
+  ASSERT_NULL_PARAMETER(options, sort_records_external);
+  ASSERT(field_id >= FIELD_STRING && field_id <= FIELD_FLOAT, "The field id is not in the valid range [1, 3]", sort_records_external);
+
+  memory_budget = options->memory_budget;
+
+  if (memory_budget == 0)
+    memory_budget = DEFAULT_MEMORY_BUDGET;
+
+  // Half of the budget holds the records, and the other half the temporary array of the top-level merge of the sort.
+  capacity = memory_budget / (2 * sizeof(Record));
+  ASSERT(capacity > 0, "The memory budget is too small to hold a record", sort_records_external);
+
+  records = (Record *) malloc(sizeof(Record) * capacity);
+  ASSERT(records, "Unable to allocate memory for records", sort_records_external);
+
+  compare = get_record_comparator(field_id);
+  spilled.runs = NULL;
+  spilled.count = spilled.capacity = 0;
+
+  fprintf(stderr, "Loading and sorting records...\n");
+  new_record_reader(&reader, in_file);
+  set_record_reader_filter(reader, options->filter);
+
+  // Every full buffer becomes a spilled run, while the last (partial) one is merged from memory.
+  for (;;) {
+    count = read_records(reader, records, capacity);
+
+    if (count > 0)
+      merge_binary_insertion_sort(records, count, sizeof(Record), sorting_threshold, compare);
+
+    if (count < capacity)
+      break;
+
+    spill_run(&spilled, records, count);
+  }
+
+  clear_record_reader(&reader);
+
+  fprintf(stderr, "Merging and storing records (%zu runs)...\n", spilled.count + 1);
+  merge_runs(out_file, options, &spilled, records, count, field_id, compare);
+
+  for (i = 0; i < spilled.count; ++i)
+    fclose(spilled.runs[i].file);
+
+  free(spilled.runs);
+  free(records);
+}
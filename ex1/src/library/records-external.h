@@ -0,0 +1,36 @@
+#pragma once
+
+#include <stdio.h>
+#include "records-sorter.h"
+
+#ifndef DEFAULT_MEMORY_BUDGET
+/**
+ * @brief Defines the default memory budget of the external sort, in bytes.
+ *
+ * @remark This number can be changed by setting this macro before including this header file.
+ */
+#define DEFAULT_MEMORY_BUDGET ((size_t) 1 << 30)
+#endif
+
+/**
+ * @brief Reads, sorts and stores the records keeping at most a memory budget worth of records in memory.
+ *
+ * @remark The records are read sequentially (so the input file can be a pipe) into a buffer as large as half the memory
+ * budget, since the merge binary insertion sort of the buffer needs a temporary array as large as the buffer (so the
+ * records and the sort never use more than the budget). Each time the buffer is full, its records are sorted and spilled to a temporary file as a sorted run. Once
+ * the input ends, the runs are merged with a k-way merge straight into the output file (so the output file can be a
+ * pipe as well). If the whole input fits into the budget, nothing is spilled. Progress messages are printed to
+ * @c stderr, since the output file may be @c stdout.
+ *
+ * @note The fixed-size buffers of the reader and of the writer (a few MiB) are not counted in the budget, and neither
+ * are the spilled runs, which are mapped from their temporary files while they are merged.
+ *
+ * @param in_file The .csv file containing the records.
+ * @param out_file The .txt file in which the sorted records will be written.
+ * @param sorting_threshold The sorting threshold to be passed to the sorting algorithm.
+ * @param field_id The type of the fields to be sorted.
+ * @param options The options of the sorter (the memory budget, the filter and the writer backend). A memory budget of
+ * 0 stands for @c DEFAULT_MEMORY_BUDGET.
+ */
+void sort_records_external(FILE *in_file, FILE *out_file, size_t sorting_threshold, FieldId field_id,
+                           const SortOptions *options);
@@ -0,0 +1,208 @@
+#include <malloc.h>
+#include <string.h>
+#include "records-join.h"
+#include "records-external.h"
+#include "records-verifier.h"
+#include "record-comparator.h"
+#include "record-reader.h"
+#include "record-writer.h"
+#include "assert_util.h"
+
+/*---------------------------------------------------------------------------------------------------------------*/
+
+// PURPOSE: The initial capacity of the group of right records with equal keys.
+#define INITIAL_GROUP_CAPACITY 16
+
+// PURPOSE: The max length of a joined row (two formatted records).
+#define MAX_JOINED_ROW_LEN (2 * LINE_BUFFER_SIZE)
+
+// PURPOSE: The empty right fields of a left row without a match.
+#define EMPTY_RIGHT_FIELDS ",,,\n"
+
+/*---------------------------------------------------------------------------------------------------------------*/
+
+// PURPOSE: Represents one side of the join: a reader of the sorted records, and the next record read from it.
+typedef struct JoinInput {
+  FILE *sorted_file;  // A temporary file if the input has been sorted, the input file itself otherwise.
+  RecordReader *reader;
+  Record next;
+  int has_next;
+} JoinInput;
+
+// PURPOSE: Represents the right records sharing the key of the current left record.
+typedef struct JoinGroup {
+  Record *records;
+  size_t count;
+  size_t capacity;
+} JoinGroup;
+
+/*---------------------------------------------------------------------------------------------------------------*/
+
+// PURPOSE: Opens one side of the join, sorting the input file into a temporary file if it is not sorted yet.
+static void open_join_input(JoinInput *input, FILE *file, const char *name, size_t sorting_threshold,
+                            FieldId field_id, const SortOptions *options) {
+  RecordsSummary summary;
+
+  // The order is checked among the records matching the filter only, since the others are skipped by the reader.
+  summarize_records(file, get_record_comparator(field_id), options->filter, options->thread_count, &summary);
+  input->sorted_file = file;
+
+  if (summary.unsorted_count > 0) {
+    fprintf(stderr, "Sorting the %s records (%zu out of order)...\n", name, summary.unsorted_count);
+
+    input->sorted_file = tmpfile();
+    ASSERT(input->sorted_file, "Unable to create a temporary file", open_join_input);
+
+    rewind(file);
+    sort_records_external(file, input->sorted_file, sorting_threshold, field_id, options);
+    rewind(input->sorted_file);
+  } else {
+    fprintf(stderr, "The %s records are already sorted.\n", name);
+    rewind(file);
+  }
+
+  new_record_reader(&input->reader, input->sorted_file);
+  set_record_reader_filter(input->reader, options->filter);
+  input->has_next = read_record(input->reader, &input->next);
+}
+
+/*---------------------------------------------------------------------------------------------------------------*/
+
+// PURPOSE: Closes one side of the join, deleting its temporary file (if any).
+static void close_join_input(JoinInput *input, FILE *file) {
+  clear_record_reader(&input->reader);
+
+  if (input->sorted_file != file)
+    fclose(input->sorted_file);
+}
+
+/*---------------------------------------------------------------------------------------------------------------*/
+
+// PURPOSE: Moves the next record of the input into the destination, and reads the following one.
+static void advance_join_input(JoinInput *input, Record *record) {
+  if (record)
+    *record = input->next;
+
+  input->has_next = read_record(input->reader, &input->next);
+}
+
+/*---------------------------------------------------------------------------------------------------------------*/
+
+// PURPOSE: Replaces the group with the right records whose key is equal to the key of the left record, skipping the
+//          smaller right records.
+static void load_join_group(JoinGroup *group, JoinInput *right, const Record *left, compare_fn compare) {
+  group->count = 0;
+
+  while (right->has_next && compare(&right->next, left) < 0)
+    advance_join_input(right, NULL);
+
+  while (right->has_next && compare(&right->next, left) == 0) {
+    if (group->count == group->capacity) {
+      group->capacity *= 2;
+      group->records = (Record *) realloc(group->records, sizeof(Record) * group->capacity);
+      ASSERT(group->records, "Unable to allocate memory for the group of right records", load_join_group);
+    }
+
+    advance_join_input(right, &group->records[group->count++]);
+  }
+}
+
+/*---------------------------------------------------------------------------------------------------------------*/
+
+// PURPOSE: Writes the row made of the left record followed by the right record (or by empty fields, if NULL).
+static void write_joined_row(RecordWriter *writer, const Record *left, const Record *right) {
+  char row[MAX_JOINED_ROW_LEN];
+  size_t length;
+
+  // The newline of the left record is replaced with the separator of the right fields.
+  length = format_record(row, sizeof(row), left);
+  row[length - 1] = ',';
+
+  if (right) {
+    length += format_record(row + length, sizeof(row) - length, right);
+  } else {
+    memcpy(row + length, EMPTY_RIGHT_FIELDS, strlen(EMPTY_RIGHT_FIELDS));
+    length += strlen(EMPTY_RIGHT_FIELDS);
+  }
+
+  write_record_bytes(writer, row, length);
+}
+
+/*---------------------------------------------------------------------------------------------------------------*/
+
+size_t join_records(FILE *left_file, FILE *right_file, FILE *out_file, size_t sorting_threshold, FieldId field_id,
+                    JoinKind kind, const SortOptions *options) {
+  JoinInput left, right;
+  JoinGroup group;
+  RecordWriter *writer;
+  compare_fn compare;
+  Record record;
+  size_t row_count, max_group_count, i;
+  int group_loaded;
+
+  ASSERT_NULL_PARAMETER(left_file, join_records);
+  ASSERT_NULL_PARAMETER(right_file, join_records);
+  ASSERT_NULL_PARAMETER(out_file, join_records);
+  ASSERT_NULL_PARAMETER(options, join_records);
+  ASSERT(field_id >= FIELD_STRING && field_id <= FIELD_FLOAT, "The field id is not in the valid range [1, 3]",
+         join_records);
+  ASSERT(kind >= JOIN_INNER && kind <= JOIN_ANTI, "Invalid join kind", join_records);
+
+  compare = get_record_comparator(field_id);
+
+  open_join_input(&left, left_file, "left", sorting_threshold, field_id, options);
+  open_join_input(&right, right_file, "right", sorting_threshold, field_id, options);
+
+  group.records = (Record *) malloc(sizeof(Record) * INITIAL_GROUP_CAPACITY);
+  ASSERT(group.records, "Unable to allocate memory for the group of right records", join_records);
+  group.count = 0;
+  group.capacity = INITIAL_GROUP_CAPACITY;
+  group_loaded = 0;
+
+  new_record_writer_backend(&writer, out_file, options->writer_backend, options->report_bandwidth);
+  fprintf(stderr, "Joining records...\n");
+
+  row_count = 0;
+  max_group_count = 0;
+
+  while (left.has_next) {
+    advance_join_input(&left, &record);
+
+    // The group is kept while the left records share its key.
+    if (!group_loaded || compare(&group.records[0], &record) != 0) {
+      load_join_group(&group, &right, &record, compare);
+      group_loaded = group.count > 0;
+
+      if (group.count > max_group_count)
+        max_group_count = group.count;
+    }
+
+    if (kind == JOIN_ANTI) {
+      if (group.count == 0) {
+        write_record(writer, &record);
+        row_count++;
+      }
+
+      continue;
+    }
+
+    for (i = 0; i < group.count; ++i)
+      write_joined_row(writer, &record, &group.records[i]);
+
+    row_count += group.count;
+
+    if (group.count == 0 && kind == JOIN_LEFT) {
+      write_joined_row(writer, &record, NULL);
+      row_count++;
+    }
+  }
+
+  clear_record_writer(&writer);
+  fprintf(stderr, "Joined records: %zu rows written (largest group of right records: %zu).\n", row_count,
+          max_group_count);
+
+  free(group.records);
+  close_join_input(&right, right_file);
+  close_join_input(&left, left_file);
+  return row_count;
+}
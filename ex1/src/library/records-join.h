@@ -0,0 +1,42 @@
+#pragma once
+
+#include <stdio.h>
+#include "records-sorter.h"
+
+/**
+ * @brief Defines which rows are written by the join of two record files.
+ */
+typedef enum JoinKind {
+  /** @brief One row for each pair of left and right records with equal keys. */
+  JOIN_INNER = 1,
+  /** @brief Same as @c JOIN_INNER, plus one row with empty right fields for each left record without a match. */
+  JOIN_LEFT,
+  /** @brief The left records without a match, written as they are (so the output is a record file). */
+  JOIN_ANTI
+} JoinKind;
+
+/**
+ * @brief Joins two record files on the specified field, with a merge join of the records sorted by that field.
+ *
+ * @remark Each input is first checked to be sorted, by a parallel scan of the file (see @c summarize_records); an
+ * unsorted input is sorted into a temporary file by the external sort, within the memory budget of the options. Both
+ * sorted inputs are then read sequentially, and only the right records sharing the key of the current left record are
+ * kept in memory, so the memory used by the join is bounded by the size of the largest group of equal right keys
+ * rather than by the size of the files.
+ *
+ * @remark A joined row is made of the fields of the left record followed by the fields of the right record
+ * (e.g. <code>1,abc,42,1.500000,7,abc,3,0.250000</code> when joining on the string field). The rows are written in the
+ * order of the keys, then of the left records, then of the right records.
+ *
+ * @param left_file The left .csv file containing the records (a regular file).
+ * @param right_file The right .csv file containing the records (a regular file).
+ * @param out_file The .txt file in which the joined rows will be written.
+ * @param sorting_threshold The sorting threshold to be passed to the sorting algorithm, if an input must be sorted.
+ * @param field_id The type of the fields on which the records are joined.
+ * @param kind The kind of join.
+ * @param options The options of the sorter (the memory budget, the number of threads, the writer backend, and the
+ * filter, which is applied to both inputs).
+ * @return The number of rows which have been written.
+ */
+size_t join_records(FILE *left_file, FILE *right_file, FILE *out_file, size_t sorting_threshold, FieldId field_id,
+                    JoinKind kind, const SortOptions *options);
@@ -0,0 +1,218 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <malloc.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <pthread.h>
+#include "records-pipeline.h"
+#include "merge-binary-insertion-sort.h"
+#include "record-comparator.h"
+#include "record-reader.h"
+#include "record-output.h"
+#include "run-merger.h"
+#include "assert_util.h"
+
+/*---------------------------------------------------------------------------------------------------------------*/
+
+// PURPOSE: Represents a chunk of records, which becomes a sorted run once a worker has processed it.
+typedef struct Chunk {
+  Record *records;
+  size_t count;
+} Chunk;
+
+// PURPOSE: Represents the queue of the chunks waiting to be sorted, shared by the reader and the workers.
+typedef struct ChunkQueue {
+  Chunk *chunks;  // Every chunk read so far (the sorted ones are the runs to be merged).
+  size_t count;  // Number of chunks read so far.
+  size_t capacity;  // Capacity of the chunks array.
+  size_t next;  // Index of the next chunk to be sorted.
+  int closed;  // 1 if the reader has reached the end of the input.
+  size_t sorting_threshold;
+  compare_fn compare;
+  pthread_mutex_t mutex;
+  pthread_cond_t cond;
+} ChunkQueue;
+
+/*---------------------------------------------------------------------------------------------------------------*/
+
+// PURPOSE: Returns the number of workers to be used when the caller does not specify it.
+static size_t get_default_thread_count(void) {
+  long count;
+
+  count = sysconf(_SC_NPROCESSORS_ONLN);
+  return count > 0 ? (size_t) count : 1;
+}
+
+/*---------------------------------------------------------------------------------------------------------------*/
+
+// PURPOSE: Appends a chunk to the queue and wakes up a worker.
+static void push_chunk(ChunkQueue *queue, Record *records, size_t count) {
+  pthread_mutex_lock(&queue->mutex);
+
+  if (queue->count == queue->capacity) {
+    queue->capacity = queue->capacity ? queue->capacity * 2 : 16;
+    queue->chunks = (Chunk *) realloc(queue->chunks, sizeof(Chunk) * queue->capacity);
+    ASSERT(queue->chunks, "Unable to allocate memory for the chunk queue", push_chunk);
+  }
+
+  queue->chunks[queue->count].records = records;
+  queue->chunks[queue->count].count = count;
+  queue->count++;
+
+  pthread_cond_signal(&queue->cond);
+  pthread_mutex_unlock(&queue->mutex);
+}
+
+/*---------------------------------------------------------------------------------------------------------------*/
+
+// PURPOSE: Marks the end of the input, and wakes up all the workers.
+static void close_queue(ChunkQueue *queue) {
+  pthread_mutex_lock(&queue->mutex);
+  queue->closed = 1;
+  pthread_cond_broadcast(&queue->cond);
+  pthread_mutex_unlock(&queue->mutex);
+}
+
+/*---------------------------------------------------------------------------------------------------------------*/
+
+// PURPOSE: Sorts the queued chunks into runs until the queue is closed and empty.
+static void *worker_thread_fn(void *arg) {
+  ChunkQueue *queue;
+  Chunk chunk;
+
+  queue = (ChunkQueue *) arg;
+
+  for (;;) {
+    pthread_mutex_lock(&queue->mutex);
+
+    while (queue->next == queue->count && !queue->closed)
+      pthread_cond_wait(&queue->cond, &queue->mutex);
+
+    if (queue->next == queue->count) {
+      pthread_mutex_unlock(&queue->mutex);
+      return NULL;
+    }
+
+    // The chunks array may be reallocated by the reader, so the chunk is copied while holding the lock.
+    chunk = queue->chunks[queue->next++];
+    pthread_mutex_unlock(&queue->mutex);
+
+    merge_binary_insertion_sort(chunk.records, chunk.count, sizeof(Record), queue->sorting_threshold, queue->compare);
+  }
+}
+
+/*---------------------------------------------------------------------------------------------------------------*/
+
+// PURPOSE: Reads the whole input in chunks, pushing each chunk to the queue as soon as it has been read.
+static void read_chunks(FILE *in_file, const RecordFilter *filter, ChunkQueue *queue) {
+  RecordReader *reader;
+  Record *records;
+  size_t count;
+
+  new_record_reader(&reader, in_file);
+  set_record_reader_filter(reader, filter);
+
+  for (;;) {
+    records = (Record *) malloc(sizeof(Record) * PIPELINE_CHUNK_RECORDS);
+    ASSERT(records, "Unable to allocate memory for a chunk of records", read_chunks);
+
+    count = read_records(reader, records, PIPELINE_CHUNK_RECORDS);
+
+    if (count == 0) {
+      free(records);
+      break;
+    }
+
+    push_chunk(queue, records, count);
+
+    if (count < PIPELINE_CHUNK_RECORDS)
+      break;
+  }
+
+  clear_record_reader(&reader);
+}
+
+/*---------------------------------------------------------------------------------------------------------------*/
+
+// PURPOSE: Merges the sorted runs straight into the record writer.
+static void merge_runs(FILE *out_file, FieldId field_id, const SortOptions *options, const ChunkQueue *queue) {
+  RecordOutput *output;
+  RunMerger *merger;
+  void **runs;
+  size_t *counts, i;
+  const Record *record;
+
+  runs = (void **) malloc(sizeof(void *) * (queue->count + 1));
+  counts = (size_t *) malloc(sizeof(size_t) * (queue->count + 1));
+  ASSERT(runs && counts, "Unable to allocate memory for the runs", merge_runs);
+
+  for (i = 0; i < queue->count; ++i) {
+    runs[i] = queue->chunks[i].records;
+    counts[i] = queue->chunks[i].count;
+  }
+
+  new_run_merger(&merger, runs, counts, queue->count, sizeof(Record), queue->compare);
+  new_record_output(&output, out_file, field_id, options);
+
+  while ((record = (const Record *) next_run_merger(merger)))
+    write_record_output(output, record);
+
+  clear_record_output(&output);
+  clear_run_merger(&merger);
+
+  free(counts);
+  free(runs);
+}
+
+/*---------------------------------------------------------------------------------------------------------------*/
+
+void sort_records_pipelined(FILE *in_file, FILE *out_file, size_t sorting_threshold, FieldId field_id,
+                            const SortOptions *options) {
+  ChunkQueue queue;
+  pthread_t *workers;
+  size_t thread_count, i;
+
+  ASSERT_NULL_PARAMETER(in_file, sort_records_pipelined);
+  ASSERT_NULL_PARAMETER(out_file, sort_records_pipelined);
+  ASSERT_NULL_PARAMETER(options, sort_records_pipelined);
+  ASSERT(field_id >= FIELD_STRING && field_id <= FIELD_FLOAT, "The field id is not in the valid range [1, 3]", sort_records_pipelined);
+
+  thread_count = options->thread_count;
+
+  if (thread_count == 0)
+    thread_count = get_default_thread_count();
+
+  queue.chunks = NULL;
+  queue.count = queue.capacity = queue.next = 0;
+  queue.closed = 0;
+  queue.sorting_threshold = sorting_threshold;
+  queue.compare = get_record_comparator(field_id);
+
+  ASSERT(!pthread_mutex_init(&queue.mutex, NULL), "Unable to initialize the queue mutex", sort_records_pipelined);
+  ASSERT(!pthread_cond_init(&queue.cond, NULL), "Unable to initialize the queue condition", sort_records_pipelined);
+
+  workers = (pthread_t *) malloc(sizeof(pthread_t) * thread_count);
+  ASSERT(workers, "Unable to allocate memory for the workers", sort_records_pipelined);
+
+  for (i = 0; i < thread_count; ++i)
+    ASSERT(!pthread_create(&workers[i], NULL, worker_thread_fn, &queue), "Unable to start a worker", sort_records_pipelined);
+
+  printf("Loading and sorting records...\n");
+  read_chunks(in_file, options->filter, &queue);
+  close_queue(&queue);
+
+  for (i = 0; i < thread_count; ++i)
+    ASSERT(!pthread_join(workers[i], NULL), "Unable to join a worker", sort_records_pipelined);
+
+  printf("Merging and storing records...\n");
+  merge_runs(out_file, field_id, options, &queue);
+
+  for (i = 0; i < queue.count; ++i)
+    free(queue.chunks[i].records);
+
+  free(queue.chunks);
+  free(workers);
+
+  pthread_mutex_destroy(&queue.mutex);
+  pthread_cond_destroy(&queue.cond);
+}
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <stdio.h>
+#include "records-sorter.h"
+
+#ifndef PIPELINE_CHUNK_RECORDS
+/**
+ * @brief Defines the number of records of each chunk handed by the reader to the sorting workers.
+ *
+ * @remark This number can be changed by setting this macro before including this header file.
+ */
+#define PIPELINE_CHUNK_RECORDS (1 << 18)
+#endif
+
+/**
+ * @brief Reads, sorts and stores the records overlapping the three stages.
+ *
+ * @remark The calling thread reads the records in fixed-size chunks, and hands each chunk to a pool of workers which
+ * sort it into a run while the following chunks are still being read. Once the input ends, the runs are merged with
+ * a k-way merge straight into a record writer, which writes the formatted records in background.
+ *
+ * @param in_file The .csv file containing the records.
+ * @param out_file The .txt file in which the sorted records will be written.
+ * @param sorting_threshold The sorting threshold to be passed to the sorting algorithm.
+ * @param field_id The type of the fields to be sorted.
+ * @param options The options of the sorter (the number of sorting workers, the filter and the writer backend).
+ */
+void sort_records_pipelined(FILE *in_file, FILE *out_file, size_t sorting_threshold, FieldId field_id,
+                            const SortOptions *options);
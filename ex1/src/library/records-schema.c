@@ -0,0 +1,164 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <malloc.h>
+#include <string.h>
+#include <stdlib.h>
+#include "records-schema.h"
+#include "record-writer.h"
+#include "assert_util.h"
+
+/*---------------------------------------------------------------------------------------------------------------*/
+
+// PURPOSE: The initial number of rows which can be stored without growing the array of the packed rows.
+#define INITIAL_ROWS_CAPACITY ((size_t) 1 << 16)
+
+/*---------------------------------------------------------------------------------------------------------------*/
+
+// PURPOSE: Represents the packed rows read from a record file.
+typedef struct SchemaRows {
+  unsigned char *rows;
+  size_t count;
+  size_t capacity;
+} SchemaRows;
+
+/*---------------------------------------------------------------------------------------------------------------*/
+
+// PURPOSE: Builds the schema from its list of columns, or from the header row of the file, and sets its key.
+// NOTE: The returned header row (NULL if the schema is a list of columns) must be freed once it has been written.
+static char *load_schema(FILE *in_file, const char *schema_spec, const char *key_column, RecordSchema *schema,
+                         size_t *line_number) {
+  char *header;
+  size_t header_capacity;
+  ssize_t header_length;
+
+  header = NULL;
+  header_length = 0;
+  header_capacity = 0;
+
+  if (!strcmp(schema_spec, SCHEMA_FROM_HEADER)) {
+    header_length = getline(&header, &header_capacity, in_file);
+    ASSERT(header_length > 0, "The record file has no header row", load_schema);
+
+    schema_spec = header;
+    *line_number = 1;
+  }
+
+  if (!add_schema_columns(schema, schema_spec)) {
+    fprintf(stderr, "RUNTIME_ERROR(load_schema): Invalid schema '%.*s'.\n", (int) strcspn(schema_spec, "\r\n"),
+            schema_spec);
+    abort();
+  }
+
+  if (!set_schema_key(schema, key_column)) {
+    fprintf(stderr, "RUNTIME_ERROR(load_schema): The schema has no column '%s'.\n", key_column);
+    abort();
+  }
+
+  // The header row is terminated, so that the first sorted record starts a new line.
+  if (header && header[header_length - 1] != '\n') {
+    header = (char *) realloc(header, (size_t) header_length + 2);
+    ASSERT(header, "Unable to allocate memory for the header row", load_schema);
+    strcpy(header + header_length, "\n");
+  }
+
+  return header;
+}
+
+/*---------------------------------------------------------------------------------------------------------------*/
+
+// PURPOSE: Parses the lines of the record file into packed rows, growing their array as needed.
+// NOTE: A line which does not match the schema aborts the sort, reporting its number.
+static void load_schema_rows(FILE *in_file, const RecordSchema *schema, SchemaRows *rows, size_t line_number) {
+  char *line;
+  size_t line_capacity;
+  ssize_t length;
+
+  line = NULL;
+  line_capacity = 0;
+  rows->count = 0;
+  rows->capacity = INITIAL_ROWS_CAPACITY;
+  rows->rows = (unsigned char *) malloc(schema->row_size * rows->capacity);
+  ASSERT(rows->rows, "Unable to allocate memory for the rows", load_schema_rows);
+
+  while ((length = getline(&line, &line_capacity, in_file)) > 0) {
+    line_number++;
+
+    if (line[0] == '\n' || (line[0] == '\r' && length > 1 && line[1] == '\n'))
+      continue;
+
+    if (rows->count == rows->capacity) {
+      rows->capacity *= 2;
+      rows->rows = (unsigned char *) realloc(rows->rows, schema->row_size * rows->capacity);
+      ASSERT(rows->rows, "Unable to allocate memory for the rows", load_schema_rows);
+    }
+
+    if (!parse_schema_row(schema, line, (size_t) length, rows->rows + rows->count * schema->row_size)) {
+      fprintf(stderr, "RUNTIME_ERROR(load_schema_rows): The line %zu does not match the schema.\n", line_number);
+      abort();
+    }
+
+    rows->count++;
+  }
+
+  free(line);
+}
+
+/*---------------------------------------------------------------------------------------------------------------*/
+
+// PURPOSE: Writes the header row (if not NULL) then formats the sorted rows into the output file.
+static void store_schema_rows(FILE *out_file, const char *header, const RecordSchema *schema, const SchemaRows *rows,
+                              const SortOptions *options) {
+  RecordWriter *writer;
+  char *buffer;
+  size_t length, i;
+
+  buffer = (char *) malloc(schema->max_line_length + 1);
+  ASSERT(buffer, "Unable to allocate memory for the formatted row", store_schema_rows);
+
+  new_record_writer_backend(&writer, out_file, options->writer_backend, options->report_bandwidth);
+
+  if (header)
+    write_record_bytes(writer, header, strlen(header));
+
+  for (i = 0; i < rows->count; ++i) {
+    length = format_schema_row(schema, rows->rows + i * schema->row_size, buffer, schema->max_line_length + 1);
+    write_record_bytes(writer, buffer, length);
+  }
+
+  clear_record_writer(&writer);
+  free(buffer);
+}
+
+/*---------------------------------------------------------------------------------------------------------------*/
+
+size_t sort_records_with_schema(FILE *in_file, FILE *out_file, size_t sorting_threshold, const char *schema_spec,
+                                const char *key_column, const SortOptions *options) {
+  RecordSchema *schema;
+  SchemaRows rows;
+  size_t line_number;
+  char *header;
+
+  ASSERT_NULL_PARAMETER(in_file, sort_records_with_schema);
+  ASSERT_NULL_PARAMETER(out_file, sort_records_with_schema);
+  ASSERT_NULL_PARAMETER(schema_spec, sort_records_with_schema);
+  ASSERT_NULL_PARAMETER(key_column, sort_records_with_schema);
+  ASSERT_NULL_PARAMETER(options, sort_records_with_schema);
+  ASSERT(in_file != out_file, "The two provided files are pointing to the same file", sort_records_with_schema);
+
+  line_number = 0;
+  new_record_schema(&schema);
+  header = load_schema(in_file, schema_spec, key_column, schema, &line_number);
+
+  // The progress messages go to stderr, since the records may be piped through the standard streams.
+  fprintf(stderr, "Loading records (%zu bytes per row)...\n", schema->row_size);
+  load_schema_rows(in_file, schema, &rows, line_number);
+  fprintf(stderr, "Sorting records...\n");
+  sort_items_with_engine(rows.rows, rows.count, schema->row_size, sorting_threshold, schema->compare, options);
+  fprintf(stderr, "Storing records...\n");
+  store_schema_rows(out_file, header, schema, &rows, options);
+
+  free(rows.rows);
+  free(header);
+  clear_record_schema(&schema);
+  return rows.count;
+}
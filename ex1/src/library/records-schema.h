@@ -0,0 +1,35 @@
+#pragma once
+
+#include <stdio.h>
+#include "records-sorter.h"
+#include "record-schema.h"
+
+/**
+ * @brief The schema argument which denotes that the schema is the first line (the header row) of the record file.
+ */
+#define SCHEMA_FROM_HEADER "header"
+
+/**
+ * @brief Sorts a record file whose columns are described by a schema only known at runtime (see @c record-schema.h),
+ * rather than by the fixed fields of @c Record.
+ *
+ * @remark Each line is parsed once into a packed row of the fixed-width layout computed from the schema, with the key
+ * column first, so the rows are sorted by the plain comparator of the type of the key, chosen once before sorting:
+ * no comparison looks up the type or the position of the key. The rows are then formatted again while they are
+ * written (so the integers and floats are normalized as the record writer does).
+ *
+ * @remark If the schema is @c SCHEMA_FROM_HEADER, it is read from the first line of the file, which is copied as it is
+ * to the output file. The empty lines are skipped, and a line which does not match the schema aborts the sort. All
+ * the rows are kept in memory; the progress messages are printed to @c stderr.
+ *
+ * @param in_file The .csv file containing the records.
+ * @param out_file The file in which the sorted records will be written.
+ * @param sorting_threshold The sorting threshold to be passed to the sorting algorithm.
+ * @param schema_spec The list of columns (e.g. <code>id:int,name:string:24,score:float</code>), or
+ * @c SCHEMA_FROM_HEADER.
+ * @param key_column The name or the (0-based) index of the column by which the records are sorted.
+ * @param options The options of the sorter (the engine, the number of threads and the writer backend).
+ * @return The number of sorted records.
+ */
+size_t sort_records_with_schema(FILE *in_file, FILE *out_file, size_t sorting_threshold, const char *schema_spec,
+                                const char *key_column, const SortOptions *options);
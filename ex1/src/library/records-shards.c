@@ -0,0 +1,293 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <malloc.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+#include "records-shards.h"
+#include "merge-binary-insertion-sort.h"
+#include "record-comparator.h"
+#include "record-output.h"
+#include "assert_util.h"
+
+/*---------------------------------------------------------------------------------------------------------------*/
+
+// PURPOSE: Represents a shard: its own array of the partitioned records, and the file in which it is written.
+// NOTE: Each shard owns its array, since the counting sort replaces the array that it sorts.
+typedef struct Shard {
+  Record *records;
+  size_t count;
+  char *path;
+} Shard;
+
+// PURPOSE: Represents the shards which are sorted and written concurrently by the workers.
+typedef struct ShardQueue {
+  Shard *shards;
+  size_t shard_count;
+  size_t sorting_threshold;
+  FieldId field_id;
+  const SortOptions *options;
+  size_t next_shard;  // Index of the next shard to be taken by a worker.
+  pthread_mutex_t mutex;
+} ShardQueue;
+
+/*---------------------------------------------------------------------------------------------------------------*/
+
+// PURPOSE: Chooses the splitters of the shards from a sorted sample of the records, evenly spaced in the input.
+// NOTE: The returned array holds shard_count - 1 splitters, and must be freed.
+static Record *choose_splitters(const Record *records, size_t count, size_t shard_count, size_t sorting_threshold,
+                                compare_fn compare) {
+  Record *sample, *splitters;
+  size_t sample_count, i;
+
+  sample_count = shard_count * SHARD_SAMPLES_PER_SHARD;
+  sample_count = sample_count < count ? sample_count : count;
+
+  sample = (Record *) malloc(sizeof(Record) * (sample_count ? sample_count : 1));
+  splitters = (Record *) malloc(sizeof(Record) * shard_count);
+  ASSERT(sample && splitters, "Unable to allocate memory for the splitters", choose_splitters);
+
+  for (i = 0; i < sample_count; ++i)
+    sample[i] = records[i * count / sample_count];
+
+  if (sample_count > 0)
+    merge_binary_insertion_sort(sample, sample_count, sizeof(Record), sorting_threshold, compare);
+
+  // The splitters are the quantiles of the sample.
+  for (i = 1; i < shard_count && sample_count > 0; ++i)
+    splitters[i - 1] = sample[i * sample_count / shard_count];
+
+  free(sample);
+  return splitters;
+}
+
+/*---------------------------------------------------------------------------------------------------------------*/
+
+// PURPOSE: Returns the shard of a record: the first shard whose splitter is not smaller than the record (the records
+//          greater than every splitter belong to the last shard).
+static size_t find_shard(const Record *record, const Record *splitters, size_t shard_count, compare_fn compare) {
+  size_t low, high, middle;
+
+  low = 0;
+  high = shard_count - 1;
+
+  while (low < high) {
+    middle = low + (high - low) / 2;
+
+    if (compare(&splitters[middle], record) < 0)
+      low = middle + 1;
+    else
+      high = middle;
+  }
+
+  return low;
+}
+
+/*---------------------------------------------------------------------------------------------------------------*/
+
+// PURPOSE: Partitions the records into the new arrays of the shards, keeping the input order of the records of each
+//          shard.
+static void partition_records(const Record *records, size_t count, const Record *splitters, Shard *shards,
+                              size_t shard_count, compare_fn compare) {
+  size_t *record_shards, *positions, i;
+
+  record_shards = (size_t *) malloc(sizeof(size_t) * (count ? count : 1));
+  positions = (size_t *) calloc(shard_count, sizeof(size_t));
+  ASSERT(record_shards && positions, "Unable to allocate memory for the shards", partition_records);
+
+  for (i = 0; i < count; ++i) {
+    record_shards[i] = find_shard(&records[i], splitters, shard_count, compare);
+    shards[record_shards[i]].count++;
+  }
+
+  for (i = 0; i < shard_count; ++i) {
+    shards[i].records = (Record *) malloc(sizeof(Record) * (shards[i].count ? shards[i].count : 1));
+    ASSERT(shards[i].records, "Unable to allocate memory for the shards", partition_records);
+  }
+
+  for (i = 0; i < count; ++i)
+    shards[record_shards[i]].records[positions[record_shards[i]]++] = records[i];
+
+  free(positions);
+  free(record_shards);
+}
+
+/*---------------------------------------------------------------------------------------------------------------*/
+
+// PURPOSE: Takes the shards from the queue until it is empty, sorting and writing each one of them.
+static void *shard_worker_fn(void *arg) {
+  ShardQueue *queue;
+  RecordOutput *output;
+  FILE *out_file;
+  Shard *shard;
+  size_t i, j;
+
+  queue = (ShardQueue *) arg;
+
+  for (;;) {
+    pthread_mutex_lock(&queue->mutex);
+    i = queue->next_shard++;
+    pthread_mutex_unlock(&queue->mutex);
+
+    if (i >= queue->shard_count)
+      return NULL;
+
+    shard = &queue->shards[i];
+
+    sort_records_array(&shard->records, shard->count, queue->sorting_threshold, queue->field_id, queue->options);
+
+    out_file = fopen(shard->path, "w");
+    ASSERT(out_file, "Unable to open a shard file", shard_worker_fn);
+
+    new_record_output(&output, out_file, queue->field_id, queue->options);
+
+    for (j = 0; j < shard->count; ++j)
+      write_record_output(output, &shard->records[j]);
+
+    clear_record_output(&output);
+    ASSERT(!fclose(out_file), "Unable to close a shard file", shard_worker_fn);
+  }
+}
+
+/*---------------------------------------------------------------------------------------------------------------*/
+
+// PURPOSE: Writes the key of a record, as it is written into the sorted files.
+static void write_key(FILE *file, const Record *record, FieldId field_id) {
+  switch (field_id) {
+    case FIELD_STRING:
+      fprintf(file, "%s", record->string_field);
+      break;
+    case FIELD_INTEGER:
+      fprintf(file, "%d", record->int_field);
+      break;
+    case FIELD_FLOAT:
+      fprintf(file, "%f", record->float_field);
+      break;
+  }
+}
+
+/*---------------------------------------------------------------------------------------------------------------*/
+
+// PURPOSE: Writes the manifest of the shards: the path, the number of records and the first and last keys (empty for
+//          an empty shard) of each shard, one shard per line.
+static void write_manifest(const char *out_path, const Shard *shards, size_t shard_count, FieldId field_id) {
+  FILE *file;
+  char *path;
+  size_t i;
+
+  path = (char *) malloc(strlen(out_path) + sizeof(SHARD_MANIFEST_PATH_FORMAT));
+  ASSERT(path, "Unable to allocate memory for the manifest path", write_manifest);
+  sprintf(path, SHARD_MANIFEST_PATH_FORMAT, out_path);
+
+  file = fopen(path, "w");
+  ASSERT(file, "Unable to open the manifest file", write_manifest);
+
+  fprintf(file, "shard,path,records,first_key,last_key\n");
+
+  for (i = 0; i < shard_count; ++i) {
+    fprintf(file, "%zu,%s,%zu,", i, shards[i].path, shards[i].count);
+
+    if (shards[i].count > 0)
+      write_key(file, &shards[i].records[0], field_id);
+
+    fprintf(file, ",");
+
+    if (shards[i].count > 0)
+      write_key(file, &shards[i].records[shards[i].count - 1], field_id);
+
+    fprintf(file, "\n");
+  }
+
+  ASSERT(!fclose(file), "Unable to close the manifest file", write_manifest);
+  free(path);
+}
+
+/*---------------------------------------------------------------------------------------------------------------*/
+
+void sort_records_sharded(FILE *in_file, const char *out_path, size_t sorting_threshold, FieldId field_id,
+                          const SortOptions *options) {
+  Record *records, *splitters;
+  ShardQueue queue;
+  Shard *shards;
+  pthread_t *workers;
+  compare_fn compare;
+  size_t count, shard_count, thread_count, i;
+  long online_count;
+
+  ASSERT_NULL_PARAMETER(in_file, sort_records_sharded);
+  ASSERT_NULL_PARAMETER(out_path, sort_records_sharded);
+  ASSERT_NULL_PARAMETER(options, sort_records_sharded);
+  ASSERT(options->layout == LAYOUT_ARRAY_OF_STRUCTS && !options->pipelined && !options->memory_budget &&
+         !options->two_pass && !options->append_path && options->index_kind == RECORD_INDEX_NONE,
+         "The shards can only be sorted in memory, as an array of structures", sort_records_sharded);
+
+  shard_count = options->shard_count;
+  ASSERT(shard_count > 0, "The number of shards must be > 0", sort_records_sharded);
+  ASSERT(field_id >= FIELD_STRING && field_id <= FIELD_FLOAT, "The field id is not in the valid range [1, 3]", sort_records_sharded);
+
+  compare = get_record_comparator(field_id);
+
+  printf("Loading records...\n");
+  records = acquire_records(in_file, options->cache_path, options->filter, &count);
+
+  printf("Partitioning records (%zu shards)...\n", shard_count);
+  shards = (Shard *) calloc(shard_count, sizeof(Shard));
+  ASSERT(shards, "Unable to allocate memory for the shards", sort_records_sharded);
+
+  for (i = 0; i < shard_count; ++i) {
+    shards[i].path = (char *) malloc(strlen(out_path) + 3 * sizeof(size_t) + sizeof(SHARD_PATH_FORMAT));
+    ASSERT(shards[i].path, "Unable to allocate memory for a shard path", sort_records_sharded);
+    sprintf(shards[i].path, SHARD_PATH_FORMAT, out_path, i);
+  }
+
+  splitters = choose_splitters(records, count, shard_count, sorting_threshold, compare);
+  partition_records(records, count, splitters, shards, shard_count, compare);
+  free(splitters);
+  free(records);
+
+  thread_count = options->thread_count;
+
+  if (thread_count == 0) {
+    online_count = sysconf(_SC_NPROCESSORS_ONLN);
+    thread_count = online_count > 0 ? (size_t) online_count : 1;
+  }
+
+  if (thread_count > shard_count)
+    thread_count = shard_count;
+
+  queue.shards = shards;
+  queue.shard_count = shard_count;
+  queue.sorting_threshold = sorting_threshold;
+  queue.field_id = field_id;
+  queue.options = options;
+  queue.next_shard = 0;
+  pthread_mutex_init(&queue.mutex, NULL);
+
+  printf("Sorting and storing shards (%zu threads)...\n", thread_count);
+
+  // The calling thread is one of the workers.
+  workers = (pthread_t *) malloc(sizeof(pthread_t) * thread_count);
+  ASSERT(workers, "Unable to allocate memory for the workers", sort_records_sharded);
+
+  for (i = 1; i < thread_count; ++i)
+    ASSERT(!pthread_create(&workers[i], NULL, shard_worker_fn, &queue), "Unable to start a worker",
+           sort_records_sharded);
+
+  shard_worker_fn(&queue);
+
+  for (i = 1; i < thread_count; ++i)
+    pthread_join(workers[i], NULL);
+
+  free(workers);
+  pthread_mutex_destroy(&queue.mutex);
+
+  printf("Storing manifest...\n");
+  write_manifest(out_path, shards, shard_count, field_id);
+
+  for (i = 0; i < shard_count; ++i) {
+    free(shards[i].records);
+    free(shards[i].path);
+  }
+
+  free(shards);
+}
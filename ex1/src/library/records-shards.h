@@ -0,0 +1,48 @@
+#pragma once
+
+#include <stdio.h>
+#include "records-sorter.h"
+
+#ifndef SHARD_SAMPLES_PER_SHARD
+/**
+ * @brief Defines the number of keys sampled for each shard to choose the splitters of the shards.
+ *
+ * @remark This number can be changed by setting this macro before including this header file.
+ */
+#define SHARD_SAMPLES_PER_SHARD 256
+#endif
+
+/**
+ * @brief Defines the format of the path of a shard, from the output path and the index of the shard.
+ */
+#define SHARD_PATH_FORMAT "%s.%zu"
+
+/**
+ * @brief Defines the format of the path of the manifest of the shards, from the output path.
+ */
+#define SHARD_MANIFEST_PATH_FORMAT "%s.manifest"
+
+/**
+ * @brief Reads the records, and writes them sorted into the specified number of shard files, whose key ranges do not
+ * overlap, together with a manifest of the shards.
+ *
+ * @remark The splitters of the shards are chosen from a sorted sample of the keys, so that the shards hold roughly the
+ * same number of records (the records with equal keys always belong to the same shard, so shards may be smaller or
+ * empty when many records share a key). The records are partitioned into the shards in input order, then each shard
+ * is sorted and written concurrently (one shard per worker thread): concatenating the shards in order gives the same
+ * output as sorting the records into a single file. The i-th shard is written into <code>out_path.i</code>, and the
+ * manifest (a .csv file with the path, the number of records and the first and last keys of each shard) into
+ * <code>out_path.manifest</code>.
+ *
+ * @remark The records are loaded as by @c sort_records_with_options with the array-of-structures layout (from the
+ * cache, if it is enabled), and each shard is sorted as such an array is (see @c sort_records_array).
+ *
+ * @param in_file The .csv file containing the records.
+ * @param out_path The path from which the paths of the shards and of the manifest are built.
+ * @param sorting_threshold The sorting threshold to be passed to the sorting algorithm.
+ * @param field_id The type of the fields to be sorted.
+ * @param options The options of the sorter (the number of shards, which must be > 0, the number of worker threads, the
+ * cache path, the engine, the filter and the writer backend).
+ */
+void sort_records_sharded(FILE *in_file, const char *out_path, size_t sorting_threshold, FieldId field_id,
+                          const SortOptions *options);
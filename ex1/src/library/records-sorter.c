@@ -1,139 +1,613 @@
+#define _POSIX_C_SOURCE 200809L
+
 #include <malloc.h>
 #include <string.h>
 #include <stdlib.h>
+#include <unistd.h>
+#include <pthread.h>
 #include "merge-binary-insertion-sort.h"
 #include "assert_util.h"
 #include "records-sorter.h"
+#include "records-cache.h"
+#include "record-columns.h"
+#include "record-comparator.h"
+#include "record-reader.h"
+#include "record-output.h"
+#include "records-pipeline.h"
+#include "records-external.h"
+#include "records-two-pass.h"
+#include "records-arena.h"
+#include "record-index.h"
+#include "counting-sort.h"
+#include "sample-sort.h"
+#include "multiway-merge-sort.h"
+#include "branchless-merge-sort.h"
+#include "pdq-sort.h"
+#include "sort-iterator.h"
+#include "record.h"
+
+/*---------------------------------------------------------------------------------------------------------------*/
+
+// PURPOSE: The initial capacity of the arrays of loaded records, which grow as needed up to NUMBER_OF_RECORDS.
+// NOTE: The arrays grow with the loaded records (rather than being allocated for NUMBER_OF_RECORDS records), so that
+//       the memory used by a filtered load depends on the number of records which match the filter.
+#define INITIAL_RECORDS_CAPACITY ((size_t) 1 << 16)
 
 /*---------------------------------------------------------------------------------------------------------------*/
 
-// PURPOSE: The max length of a line.
-#define LINE_BUFFER_SIZE 128
+// PURPOSE: Loads the records (matching the filter, if any) from a file into a new array, and returns it.
+static Record *load_records(FILE *in_file, const RecordFilter *filter, size_t *count) {
+  RecordReader *reader;
+  Record *records;
+  size_t capacity;
+
+  capacity = INITIAL_RECORDS_CAPACITY < NUMBER_OF_RECORDS ? INITIAL_RECORDS_CAPACITY : NUMBER_OF_RECORDS;
+  records = (Record *) malloc(sizeof(Record) * capacity);
+  ASSERT(records, "Unable to allocate memory for records", load_records);
 
-// PURPOSE: The max length of the string field.
-// NOTE: Strings are stored statically to prevent allocations and memory fragmentation.
-#define STRING_FIELD_LEN 32
+  new_record_reader(&reader, in_file);
+  set_record_reader_filter(reader, filter);
 
-// PURPOSE: Represents a record.
-typedef struct Record {
-  size_t id;
-  char string_field[STRING_FIELD_LEN];
-  int int_field;
-  float float_field;
-} Record;
+  *count = 0;
+
+  for (;;) {
+    *count += read_records(reader, records + *count, capacity - *count);
+
+    if (*count < capacity || capacity == NUMBER_OF_RECORDS)
+      break;
+
+    capacity = capacity * 2 < NUMBER_OF_RECORDS ? capacity * 2 : NUMBER_OF_RECORDS;
+    records = (Record *) realloc(records, sizeof(Record) * capacity);
+    ASSERT(records, "Unable to allocate memory for records", load_records);
+  }
+
+  clear_record_reader(&reader);
+
+  return records;
+}
 
 /*---------------------------------------------------------------------------------------------------------------*/
 
-// PURPOSE: Parses a record id from its string representation and stores it into the record array.
-#define LOAD_ID(records, i, str_id) ((records)[(i)].id = atoi((str_id)))
+Record *acquire_records(FILE *in_file, const char *cache_path, const RecordFilter *filter, size_t *count) {
+  RecordsCache *cache;
+  Record *records;
+
+  ASSERT_NULL_PARAMETER(in_file, acquire_records);
+  ASSERT_NULL_PARAMETER(count, acquire_records);
 
-// PURPOSE: Parses a string field and stores it into the record array.
-#define LOAD_STRING(records, i, field) strcpy((records)[(i)].string_field, (field))                           \
+  if (!cache_path || filter)
+    return load_records(in_file, filter, count);
 
-// PURPOSE: Parses an int field and stores it into the record array.
-#define LOAD_INT(records, i, field) ((records)[(i)].int_field = atoll((field)))
+  if (open_records_cache(&cache, cache_path, in_file)) {
+    *count = cache->columns.count < NUMBER_OF_RECORDS ? cache->columns.count : NUMBER_OF_RECORDS;
+    records = (Record *) malloc(sizeof(Record) * (*count ? *count : 1));
+    ASSERT(records, "Unable to allocate memory for records", acquire_records);
 
-// PURPOSE: Parses a float field and stores it into the record array.
-#define LOAD_FLOAT(records, i, field) ((records)[(i)].float_field = atof((field)))
+    gather_records_cache(cache, records, *count);
+    close_records_cache(&cache);
+    return records;
+  }
+
+  records = load_records(in_file, NULL, count);
+  write_records_cache(cache_path, in_file, records, *count);
+  return records;
+}
 
 /*---------------------------------------------------------------------------------------------------------------*/
 
-static void load_record(char *line, Record *records, size_t index) {
-  char *field;
+// PURPOSE: Loads the records (matching the filter, if any) from a file, and appends them to the columns.
+static void load_record_columns(FILE *in_file, const RecordFilter *filter, RecordColumns *columns) {
+  RecordReader *reader;
+  Record record;
 
-  field = strtok(line, ",");
-  LOAD_ID(records, index, field); // NOLINT(*-err34-c)
+  new_record_reader(&reader, in_file);
+  set_record_reader_filter(reader, filter);
 
-  field = strtok(NULL, ",");
-  LOAD_STRING(records, index, field);
+  while (columns->count < NUMBER_OF_RECORDS && read_record(reader, &record))
+    push_record_columns(columns, &record);
 
-  field = strtok(NULL, ",");
-  LOAD_INT(records, index, field); // NOLINT(*-err34-c)
+  clear_record_reader(&reader);
+}
+
+/*---------------------------------------------------------------------------------------------------------------*/
+
+// PURPOSE: Loads the records (matching the filter, if any) from a file into new columns, and returns a new array with
+//          the offset of the line of each record in the file.
+static uint64_t *load_record_offsets(FILE *in_file, const RecordFilter *filter, RecordColumns **columns) {
+  RecordReader *reader;
+  Record record;
+  uint64_t *offsets, offset;
+  size_t capacity;
+
+  capacity = INITIAL_RECORDS_CAPACITY;
+  offsets = (uint64_t *) malloc(sizeof(uint64_t) * capacity);
+  ASSERT(offsets, "Unable to allocate memory for the record offsets", load_record_offsets);
+
+  new_record_columns(columns, INITIAL_RECORDS_CAPACITY);
+  new_record_reader(&reader, in_file);
+  set_record_reader_filter(reader, filter);
+
+  while ((*columns)->count < NUMBER_OF_RECORDS && read_record_at(reader, &record, &offset)) {
+    if ((*columns)->count == capacity) {
+      capacity *= 2;
+      offsets = (uint64_t *) realloc(offsets, sizeof(uint64_t) * capacity);
+      ASSERT(offsets, "Unable to allocate memory for the record offsets", load_record_offsets);
+    }
+
+    offsets[(*columns)->count] = offset;
+    push_record_columns(*columns, &record);
+  }
 
-  field = strtok(NULL, ",");
-  LOAD_FLOAT(records, index, field); // NOLINT(*-err34-c)
+  clear_record_reader(&reader);
+
+  return offsets;
 }
 
 /*---------------------------------------------------------------------------------------------------------------*/
 
-// PURPOSE: Loads the records from a file, and saves them into the records array.
-static void load_records(FILE *in_file, Record *records) {
-  char line_buffer[LINE_BUFFER_SIZE];
-  size_t count;
+// PURPOSE: Returns the record columns, reading them in place from the cache if it is valid, otherwise parsing the
+//          record file (and rebuilding the cache, if enabled). The cache is not used if the records are filtered.
+// NOTE: Exactly one of *cache and *owned is set, and must be released once the columns are no longer used.
+static const RecordColumns *acquire_record_columns(FILE *in_file, const char *cache_path, const RecordFilter *filter,
+                                                   RecordsCache **cache, RecordColumns **owned) {
+  *cache = NULL;
+  *owned = NULL;
+
+  if (filter)
+    cache_path = NULL;
+
+  if (cache_path && open_records_cache(cache, cache_path, in_file)) {
+    if ((*cache)->columns.count > NUMBER_OF_RECORDS)
+      (*cache)->columns.count = NUMBER_OF_RECORDS;
+    return &(*cache)->columns;
+  }
 
-  count = 0;
+  new_record_columns(owned, INITIAL_RECORDS_CAPACITY);
+  load_record_columns(in_file, filter, *owned);
 
-  while (count < NUMBER_OF_RECORDS && fgets(line_buffer, LINE_BUFFER_SIZE, in_file))
-    load_record(line_buffer, records, count++);
+  if (cache_path)
+    write_record_columns_cache(cache_path, in_file, *owned);
+
+  return *owned;
 }
 
 /*---------------------------------------------------------------------------------------------------------------*/
 
-// PURPOSE: Writes the records array into the specified file.
-static void store_records(FILE *out_file, Record *records) {
-  int i;
-  Record *record;
+// PURPOSE: Writes the records into the specified file, gathering the fields from the columns in permutation order.
+static void store_record_columns(FILE *out_file, const RecordColumns *columns, const uint32_t *permutation,
+                                 FieldId field_id, const SortOptions *options) {
+  RecordOutput *output;
+  Record record;
+  size_t i;
+
+  new_record_output(&output, out_file, field_id, options);
 
-  for (i = 0; i < NUMBER_OF_RECORDS; ++i) {
-    record = &records[i];
-    fprintf(out_file, "%zu,%s,%d,%f\n",
-            record->id,
-            record->string_field,
-            record->int_field,
-            record->float_field);
+  for (i = 0; i < columns->count; ++i) {
+    get_record_columns(columns, permutation[i], &record);
+    write_record_output(output, &record);
   }
+
+  clear_record_output(&output);
 }
 
 /*---------------------------------------------------------------------------------------------------------------*/
 
-// PURPOSE: The field id to be used in the comparator function.
-static FieldId g_field_id;
+// PURPOSE: Writes the records array, sorted by the specified field, into the specified file.
+static void store_records(FILE *out_file, Record *records, size_t count, FieldId field_id,
+                          const SortOptions *options) {
+  RecordOutput *output;
+  size_t i;
 
-// PURPOSE: The records comparator function.
-static int compare_records_fn(const void *record_a, const void *record_b) {
-  const Record *a = (const Record *) record_a;
-  const Record *b = (const Record *) record_b;
+  new_record_output(&output, out_file, field_id, options);
 
-  switch (g_field_id) {
-    case FIELD_STRING:
-      return string_comparator(a->string_field, b->string_field);
-    case FIELD_INTEGER:
-      return int_comparator(&a->int_field, &b->int_field);
-    case FIELD_FLOAT:
-      return float_comparator(&a->float_field, &b->float_field);
+  for (i = 0; i < count; ++i)
+    write_record_output(output, &records[i]);
+
+  clear_record_output(&output);
+}
+
+/*---------------------------------------------------------------------------------------------------------------*/
+
+// PURPOSE: Merges the records array, sorted by the specified field, with the records of the already sorted file
+//          whose path is in the options, and writes the merged records into the specified file.
+// NOTE: The sorted file is read sequentially, and its order is checked while it is merged.
+static void store_appended_records(FILE *out_file, const Record *records, size_t count, FieldId field_id,
+                                   const SortOptions *options) {
+  RecordOutput *output;
+  RecordReader *reader;
+  compare_fn compare;
+  FILE *sorted_file;
+  Record sorted[2], *next, *previous;
+  size_t i;
+
+  sorted_file = fopen(options->append_path, "r");
+  ASSERT(sorted_file, "Unable to open the sorted file to append to", store_appended_records);
+
+  compare = get_record_comparator(field_id);
+  new_record_reader(&reader, sorted_file);
+  new_record_output(&output, out_file, field_id, options);
+
+  next = &sorted[0];
+  previous = NULL;
+  i = 0;
+
+  while (read_record(reader, next)) {
+    ASSERT(!previous || compare(previous, next) <= 0, "The file to append to is not sorted by the field",
+           store_appended_records);
+
+    // The new records which are smaller than the next sorted record are written before it.
+    while (i < count && compare(&records[i], next) < 0)
+      write_record_output(output, &records[i++]);
+
+    write_record_output(output, next);
+    previous = next;
+    next = next == &sorted[0] ? &sorted[1] : &sorted[0];
   }
 
-  PRINT_ERROR("Invalid field ID", compare_records_fn);
-  return 0;
+  while (i < count)
+    write_record_output(output, &records[i++]);
+
+  clear_record_output(&output);
+  clear_record_reader(&reader);
+  fclose(sorted_file);
+}
+
+/*---------------------------------------------------------------------------------------------------------------*/
+
+void init_sort_options(SortOptions *options) {
+  ASSERT_NULL_PARAMETER(options, init_sort_options);
+
+  options->cache_path = NULL;
+  options->layout = LAYOUT_ARRAY_OF_STRUCTS;
+  options->pipelined = 0;
+  options->thread_count = 0;
+  options->engine = SORT_ENGINE_MERGE_BINARY_INSERTION;
+  options->shard_count = 0;
+  options->memory_budget = 0;
+  options->two_pass = 0;
+  options->aggregate = 0;
+  options->append_path = NULL;
+  options->filter = NULL;
+  options->index_kind = RECORD_INDEX_NONE;
+  options->writer_backend = RECORD_WRITER_STDIO;
+  options->report_bandwidth = 0;
 }
 
 /*---------------------------------------------------------------------------------------------------------------*/
 
 void sort_records(FILE *in_file, FILE *out_file, size_t sorting_threshold, FieldId field_id) {
+  SortOptions options;
+
+  init_sort_options(&options);
+  sort_records_with_options(in_file, out_file, sorting_threshold, field_id, &options);
+}
+
+/*---------------------------------------------------------------------------------------------------------------*/
+
+// PURPOSE: Sorts the records stored as columns by the specified field, and writes them into the specified file.
+static void sort_and_store_columns(const RecordColumns *columns, FILE *out_file, size_t sorting_threshold,
+                                   FieldId field_id, const SortOptions *options) {
+  uint32_t *permutation;
+
+  permutation = (uint32_t *) malloc(sizeof(uint32_t) * (columns->count ? columns->count : 1));
+  ASSERT(permutation, "Unable to allocate memory for the permutation", sort_and_store_columns);
+
+  sort_record_permutation(columns, field_id, sorting_threshold, options, permutation);
+  store_record_columns(out_file, columns, permutation, field_id, options);
+
+  free(permutation);
+}
+
+/*---------------------------------------------------------------------------------------------------------------*/
+
+// PURPOSE: Sorts the records stored as a structure of arrays, moving only the key column and the permutation.
+static void sort_record_columns(FILE *in_file, FILE *out_file, size_t sorting_threshold, FieldId field_id,
+                                const SortOptions *options) {
+  const RecordColumns *columns;
+  RecordsCache *cache;
+  RecordColumns *owned;
+  uint32_t *permutation;
+
+  printf("Loading records...\n");
+  columns = acquire_record_columns(in_file, options->cache_path, options->filter, &cache, &owned);
+
+  permutation = (uint32_t *) malloc(sizeof(uint32_t) * (columns->count ? columns->count : 1));
+  ASSERT(permutation, "Unable to allocate memory for the permutation", sort_record_columns);
+
+  printf("Sorting records...\n");
+  sort_record_permutation(columns, field_id, sorting_threshold, options, permutation);
+  printf("Storing records...\n");
+  store_record_columns(out_file, columns, permutation, field_id, options);
+
+  free(permutation);
+
+  if (cache) close_records_cache(&cache);
+  else clear_record_columns(&owned);
+}
+
+/*---------------------------------------------------------------------------------------------------------------*/
+
+// PURPOSE: Sorts the records stored as a structure of arrays, and writes the ids or the offsets of the records in sorted
+//          order as a binary index.
+static void sort_record_index(FILE *in_file, FILE *out_file, size_t sorting_threshold, FieldId field_id,
+                              const SortOptions *options) {
+  const RecordColumns *columns;
+  RecordsCache *cache;
+  RecordColumns *owned;
+  uint64_t *offsets;
+  uint32_t *permutation;
+
+  printf("Loading records...\n");
+
+  if (options->index_kind == RECORD_INDEX_OFFSETS) {
+    cache = NULL;
+    offsets = load_record_offsets(in_file, options->filter, &owned);
+    columns = owned;
+  } else {
+    offsets = NULL;
+    columns = acquire_record_columns(in_file, options->cache_path, options->filter, &cache, &owned);
+  }
+
+  permutation = (uint32_t *) malloc(sizeof(uint32_t) * (columns->count ? columns->count : 1));
+  ASSERT(permutation, "Unable to allocate memory for the permutation", sort_record_index);
+
+  printf("Sorting records...\n");
+  sort_record_permutation(columns, field_id, sorting_threshold, options, permutation);
+  printf("Storing index...\n");
+  write_record_index(out_file, options->index_kind, field_id, offsets ? offsets : columns->ids, permutation,
+                     columns->count);
+
+  free(permutation);
+  free(offsets);
+
+  if (cache) close_records_cache(&cache);
+  else clear_record_columns(&owned);
+}
+
+/*---------------------------------------------------------------------------------------------------------------*/
+
+SortStrategy sort_items_with_engine(void *base, size_t count, size_t size, size_t sorting_threshold,
+                                    compare_fn compare, const SortOptions *options) {
+  ASSERT_NULL_PARAMETER(compare, sort_items_with_engine);
+  ASSERT_NULL_PARAMETER(options, sort_items_with_engine);
+
+  if (count == 0)
+    return SORT_STRATEGY_MERGE_BINARY_INSERTION;
+
+  ASSERT_NULL_PARAMETER(base, sort_items_with_engine);
+
+  if (options->engine == SORT_ENGINE_PARALLEL_SAMPLE) {
+    parallel_sample_sort_threads(base, count, size, sorting_threshold, compare, options->thread_count);
+    return SORT_STRATEGY_PARALLEL_SAMPLE;
+  }
+
+  if (options->engine == SORT_ENGINE_MULTIWAY_MERGE) {
+    multiway_merge_sort(base, count, size, sorting_threshold, compare);
+    return SORT_STRATEGY_MULTIWAY_MERGE;
+  }
+
+  if (options->engine == SORT_ENGINE_PDQ) {
+    pdq_sort(base, count, size, sorting_threshold, compare);
+    return SORT_STRATEGY_PDQ;
+  }
+
+  merge_binary_insertion_sort(base, count, size, sorting_threshold, compare);
+  return SORT_STRATEGY_MERGE_BINARY_INSERTION;
+}
+
+/*---------------------------------------------------------------------------------------------------------------*/
+
+// NOTE: The merge binary insertion sort of the integer and float fields is replaced by the branchless merge sort,
+//       since the type of their keys is known.
+SortStrategy sort_records_array(Record **records, size_t count, size_t sorting_threshold, FieldId field_id,
+                                const SortOptions *options) {
+  ASSERT_NULL_PARAMETER(records, sort_records_array);
+  ASSERT_NULL_PARAMETER(options, sort_records_array);
+
+  if (field_id == FIELD_INTEGER && counting_sort_records(records, count))
+    return SORT_STRATEGY_COUNTING;
+
+  if (count == 0)
+    return SORT_STRATEGY_MERGE_BINARY_INSERTION;
+
+  if (options->engine != SORT_ENGINE_MERGE_BINARY_INSERTION)
+    return sort_items_with_engine(*records, count, sizeof(Record), sorting_threshold, get_record_comparator(field_id),
+                                  options);
+
+  if (field_id == FIELD_INTEGER) {
+    branchless_merge_sort_records_by_int(*records, count, sorting_threshold);
+    return SORT_STRATEGY_BRANCHLESS_MERGE;
+  }
+
+  if (field_id == FIELD_FLOAT) {
+    branchless_merge_sort_records_by_float(*records, count, sorting_threshold);
+    return SORT_STRATEGY_BRANCHLESS_MERGE;
+  }
+
+  merge_binary_insertion_sort(*records, count, sizeof(Record), sorting_threshold, get_record_comparator(field_id));
+  return SORT_STRATEGY_MERGE_BINARY_INSERTION;
+}
+
+/*---------------------------------------------------------------------------------------------------------------*/
+
+void sort_records_with_options(FILE *in_file, FILE *out_file, size_t sorting_threshold, FieldId field_id,
+                               const SortOptions *options) {
   Record *records;
+  size_t count;
+
+  ASSERT_NULL_PARAMETER(in_file, sort_records_with_options);
+  ASSERT_NULL_PARAMETER(out_file, sort_records_with_options);
+  ASSERT_NULL_PARAMETER(options, sort_records_with_options);
+  ASSERT(sorting_threshold >= 0, "The sorting threshold must be >= 0", sort_records_with_options);
+  ASSERT(field_id >= FIELD_STRING && field_id <= FIELD_FLOAT, "The field id is not in the valid range [1, 3]", sort_records_with_options);
+  ASSERT(in_file != out_file, "The two provided files are pointing to the same file", sort_records_with_options);
+  ASSERT(options->layout != LAYOUT_STRING_ARENA || (options->index_kind == RECORD_INDEX_NONE && !options->two_pass &&
+                                                    !options->append_path && !options->memory_budget &&
+                                                    !options->pipelined),
+         "The string arena cannot be used by the modes which parse the records into a Record",
+         sort_records_with_options);
+
+  if (options->index_kind != RECORD_INDEX_NONE) {
+    sort_record_index(in_file, out_file, sorting_threshold, field_id, options);
+    return;
+  }
+
+  if (options->two_pass) {
+    sort_records_two_pass(in_file, out_file, sorting_threshold, field_id, options);
+    return;
+  }
+
+  // The progress messages go to stderr, as those of the external sort.
+  if (options->append_path) {
+    ASSERT(!options->memory_budget && !options->pipelined && options->layout == LAYOUT_ARRAY_OF_STRUCTS,
+           "The new records can only be appended in memory, as an array of structures", sort_records_with_options);
 
-  ASSERT_NULL_PARAMETER(in_file, sort_records);
-  ASSERT_NULL_PARAMETER(out_file, sort_records);
-  ASSERT(sorting_threshold >= 0, "The sorting threshold must be >= 0", sort_records);
-  ASSERT(field_id >= FIELD_STRING && field_id <= FIELD_FLOAT, "The field id is not in the valid range [1, 3]", sort_records);
-  ASSERT(in_file != out_file, "The two provided files are pointing to the same file", sort_records);
+    fprintf(stderr, "Loading new records...\n");
+    records = acquire_records(in_file, options->cache_path, options->filter, &count);
+    fprintf(stderr, "Sorting new records...\n");
+    sort_records_array(&records, count, sorting_threshold, field_id, options);
+    fprintf(stderr, "Merging with the sorted records...\n");
+    store_appended_records(out_file, records, count, field_id, options);
 
-  g_field_id = field_id;
+    free((void *) records);
+    return;
+  }
+
+  if (options->memory_budget) {
+    sort_records_external(in_file, out_file, sorting_threshold, field_id, options);
+    return;
+  }
 
-  records = (Record *) malloc(sizeof(Record) * NUMBER_OF_RECORDS);
+  if (options->pipelined) {
+    sort_records_pipelined(in_file, out_file, sorting_threshold, field_id, options);
+    return;
+  }
 
-  ASSERT(records, "Unable to allocate memory for records", sort_records);
+  if (options->layout == LAYOUT_STRUCT_OF_ARRAYS) {
+    sort_record_columns(in_file, out_file, sorting_threshold, field_id, options);
+    return;
+  }
+
+  if (options->layout == LAYOUT_STRING_ARENA) {
+    sort_records_arena(in_file, out_file, sorting_threshold, field_id, options);
+    return;
+  }
 
   printf("Loading records...\n");
-  load_records(in_file, records);
+  records = acquire_records(in_file, options->cache_path, options->filter, &count);
   printf("Sorting records...\n");
-  merge_binary_insertion_sort(records, NUMBER_OF_RECORDS, sizeof(Record), sorting_threshold, compare_records_fn);
+  sort_records_array(&records, count, sorting_threshold, field_id, options);
   printf("Storing records...\n");
-  store_records(out_file, records);
+  store_records(out_file, records, count, field_id, options);
 
   free((void *) records);
+}
+
+/*---------------------------------------------------------------------------------------------------------------*/
+
+// PURPOSE: Represents the fields which are sorted concurrently by sort_records_by_fields, from the shared columns.
+typedef struct FieldQueue {
+  const RecordColumns *columns;
+  FILE *const *out_files;
+  const FieldId *field_ids;
+  size_t field_count;
+  size_t sorting_threshold;
+  const SortOptions *options;
+  size_t next_field;  // Index of the next field to be taken by a worker.
+  pthread_mutex_t mutex;
+} FieldQueue;
+
+/*---------------------------------------------------------------------------------------------------------------*/
+
+// PURPOSE: Takes the fields from the queue until it is empty, sorting and storing each one of them.
+static void *field_worker_fn(void *arg) {
+  FieldQueue *queue;
+  size_t i;
+
+  queue = (FieldQueue *) arg;
+
+  for (;;) {
+    pthread_mutex_lock(&queue->mutex);
+    i = queue->next_field++;
+    pthread_mutex_unlock(&queue->mutex);
+
+    if (i >= queue->field_count)
+      return NULL;
+
+    sort_and_store_columns(queue->columns, queue->out_files[i], queue->sorting_threshold, queue->field_ids[i],
+                           queue->options);
+  }
+}
+
+/*---------------------------------------------------------------------------------------------------------------*/
 
-  g_field_id = -1;
+void sort_records_by_fields(FILE *in_file, FILE *const *out_files, const FieldId *field_ids, size_t field_count,
+                            size_t sorting_threshold, const SortOptions *options) {
+  const RecordColumns *columns;
+  RecordsCache *cache;
+  RecordColumns *owned;
+  FieldQueue queue;
+  pthread_t *workers;
+  size_t thread_count, i;
+  long online_count;
+
+  ASSERT_NULL_PARAMETER(in_file, sort_records_by_fields);
+  ASSERT_NULL_PARAMETER(out_files, sort_records_by_fields);
+  ASSERT_NULL_PARAMETER(field_ids, sort_records_by_fields);
+  ASSERT_NULL_PARAMETER(options, sort_records_by_fields);
+  ASSERT(field_count > 0, "No field to be sorted", sort_records_by_fields);
+  ASSERT(options->layout != LAYOUT_STRING_ARENA, "The string arena cannot be used to sort several fields",
+         sort_records_by_fields);
+
+  for (i = 0; i < field_count; ++i) {
+    ASSERT(out_files[i] && out_files[i] != in_file, "An output file is NULL or points to the input file",
+           sort_records_by_fields);
+    ASSERT(field_ids[i] >= FIELD_STRING && field_ids[i] <= FIELD_FLOAT, "The field id is not in the valid range [1, 3]",
+           sort_records_by_fields);
+  }
+
+  printf("Loading records...\n");
+  columns = acquire_record_columns(in_file, options->cache_path, options->filter, &cache, &owned);
+
+  thread_count = options->thread_count;
+
+  if (thread_count == 0) {
+    online_count = sysconf(_SC_NPROCESSORS_ONLN);
+    thread_count = online_count > 0 ? (size_t) online_count : 1;
+  }
+
+  if (thread_count > field_count)
+    thread_count = field_count;
+
+  queue.columns = columns;
+  queue.out_files = out_files;
+  queue.field_ids = field_ids;
+  queue.field_count = field_count;
+  queue.sorting_threshold = sorting_threshold;
+  queue.options = options;
+  queue.next_field = 0;
+  pthread_mutex_init(&queue.mutex, NULL);
+
+  printf("Sorting and storing records (%zu fields, %zu threads)...\n", field_count, thread_count);
+
+  // The calling thread is one of the workers.
+  workers = (pthread_t *) malloc(sizeof(pthread_t) * thread_count);
+  ASSERT(workers, "Unable to allocate memory for the workers", sort_records_by_fields);
+
+  for (i = 1; i < thread_count; ++i)
+    ASSERT(!pthread_create(&workers[i], NULL, field_worker_fn, &queue), "Unable to start a worker",
+           sort_records_by_fields);
+
+  field_worker_fn(&queue);
+
+  for (i = 1; i < thread_count; ++i)
+    pthread_join(workers[i], NULL);
+
+  free(workers);
+  pthread_mutex_destroy(&queue.mutex);
+
+  if (cache) close_records_cache(&cache);
+  else clear_record_columns(&owned);
 }
 
 /*---------------------------------------------------------------------------------------------------------------*/
@@ -143,23 +617,47 @@ void sort_records(FILE *in_file, FILE *out_file, size_t sorting_threshold, Field
 #include <time.h>
 
 #define PROFILER_PRINT(msg) printf("[PROFILER]: " msg "\n")
-#define PROFILER_PRINT_RESULT(threshold, field_id, start, end) \
-    printf("[PROFILER]<field=%s, threshold=%zu>: Sorted in %f seconds.\n", get_field_name((field_id)), (threshold), (double) ((end) - (start)) / CLOCKS_PER_SEC)
+#define PROFILER_PRINT_RESULT(threshold, field_id, strategy, start, end) \
+    printf("[PROFILER]<field=%s, threshold=%zu, strategy=%s>: Sorted in %f seconds.\n", get_field_name((field_id)), (threshold), get_sort_strategy_name((strategy)), get_elapsed_seconds(&(start), &(end)))
+
+// PURPOSE: Returns the seconds elapsed between two readings of the monotonic clock.
+// NOTE: The wall-clock time is measured (rather than the processor time), since the parallel engines run on several
+//       threads.
+static double get_elapsed_seconds(const struct timespec *start, const struct timespec *end) {
+  return (double) (end->tv_sec - start->tv_sec) + (double) (end->tv_nsec - start->tv_nsec) / 1e9;
+}
+
+// PURPOSE: Prints the number of passes over the memory made by the merge sorts, and the bytes moved by each pass.
+// NOTE: Each binary merge of the merge binary insertion sort copies the merged items into a temporary array and back,
+//       so each level of its recursion moves the array twice.
+static void print_memory_passes(SortStrategy strategy, size_t count, size_t size, size_t threshold) {
+  MultiwaySortPlan plan;
+  size_t level_count, n;
+
+  if (strategy == SORT_STRATEGY_MULTIWAY_MERGE) {
+    plan_multiway_merge_sort(count, size, &plan);
+    printf("[PROFILER]<blocks=%zu, fan_in=%zu>: %zu passes over memory, %zu bytes moved per pass.\n",
+           plan.block_count, plan.fan_in, plan.pass_count, plan.bytes_per_pass);
+  } else if (strategy == SORT_STRATEGY_MERGE_BINARY_INSERTION) {
+    for (level_count = 1, n = count; n > threshold && n > 1; n = (n + 1) / 2)
+      level_count++;
+
+    printf("[PROFILER]<blocks=1, fan_in=2>: %zu passes over memory, %zu bytes moved per pass.\n",
+           level_count, 4 * count * size);
+  }
+}
 
 static Record *unsorted_records = NULL;
+static size_t unsorted_count = 0;
 
-void init_profiler__records_sorter(FILE *in_file) {
+void init_profiler__records_sorter(FILE *in_file, const char *cache_path) {
   ASSERT_NULL_PARAMETER(in_file, init_profiler__records_sorter);
   ASSERT(!unsorted_records, "Profiler has been already initialized", init_profiler__records_sorter);
 
   PROFILER_PRINT("Initializing profiler...");
 
-  PROFILER_PRINT("Allocating unsorted records...");
-  unsorted_records = (Record *) malloc(sizeof(Record) * NUMBER_OF_RECORDS);
-  ASSERT(unsorted_records, "Unable to allocate memory for the unsorted records array", init_profiler__records_sorter);
-
   PROFILER_PRINT("Loading records...");
-  load_records(in_file, unsorted_records);
+  unsorted_records = acquire_records(in_file, cache_path, NULL, &unsorted_count);
 
   PROFILER_PRINT("Profiler initialized.");
 }
@@ -171,6 +669,8 @@ void shutdown_profiler__records_sorter(void) {
 
   PROFILER_PRINT("Deallocating unsorted records...");
   free((void *) unsorted_records);
+  unsorted_records = NULL;
+  unsorted_count = 0;
 
   PROFILER_PRINT("Profiler shut down.");
 }
@@ -190,28 +690,105 @@ static const char *get_field_name(FieldId field_id) {
 }
 
 void profile__records_sorter(size_t threshold, FieldId field_id) {
+  profile_engine__records_sorter(threshold, field_id, SORT_ENGINE_MERGE_BINARY_INSERTION);
+}
+
+void profile_engine__records_sorter(size_t threshold, FieldId field_id, SortEngine engine) {
   Record *to_be_sorted;
-  clock_t start, end;
+  SortOptions options;
+  SortStrategy strategy;
+  struct timespec start, end;
 
-  ASSERT(threshold >= 0, "The sorting threshold must be >= 0", profile__records_sorter);
-  ASSERT(field_id >= FIELD_STRING && field_id <= FIELD_FLOAT, "The field id is not in the valid range [1, 3]", profile__records_sorter);
+  ASSERT(threshold >= 0, "The sorting threshold must be >= 0", profile_engine__records_sorter);
+  ASSERT(field_id >= FIELD_STRING && field_id <= FIELD_FLOAT, "The field id is not in the valid range [1, 3]", profile_engine__records_sorter);
 
-  to_be_sorted = (Record *) malloc(sizeof(Record) * NUMBER_OF_RECORDS);
-  ASSERT(to_be_sorted, "Unable to allocate memory for records to be sorted", profile__records_sorter);
+  ASSERT(unsorted_count > 0, "No records have been loaded by the profiler", profile_engine__records_sorter);
 
-  ASSERT(memcpy(to_be_sorted, unsorted_records, sizeof(Record) * NUMBER_OF_RECORDS), "Unable to copy the unsorted records array", profile__records_sorter);
+  to_be_sorted = (Record *) malloc(sizeof(Record) * unsorted_count);
+  ASSERT(to_be_sorted, "Unable to allocate memory for records to be sorted", profile_engine__records_sorter);
 
-  g_field_id = field_id;
+  ASSERT(memcpy(to_be_sorted, unsorted_records, sizeof(Record) * unsorted_count), "Unable to copy the unsorted records array", profile_engine__records_sorter);
 
-  start = clock();
-  merge_binary_insertion_sort(to_be_sorted, NUMBER_OF_RECORDS, sizeof(Record), threshold, compare_records_fn);
-  end = clock();
+  init_sort_options(&options);
+  options.engine = engine;
 
-  PROFILER_PRINT_RESULT(threshold, field_id, start, end);
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  strategy = sort_records_array(&to_be_sorted, unsorted_count, threshold, field_id, &options);
+  clock_gettime(CLOCK_MONOTONIC, &end);
 
+  PROFILER_PRINT_RESULT(threshold, field_id, strategy, start, end);
+  print_memory_passes(strategy, unsorted_count, sizeof(Record), threshold);
+
+  free((void *) to_be_sorted);
+}
+
+// PURPOSE: The number of records after which the lazy sort is timed, besides the first one and the last one.
+#define PROFILER_ITERATOR_PREFIX_COUNT 1000
+
+void profile_iterator__records_sorter(size_t threshold, FieldId field_id) {
+  Record *to_be_sorted;
+  SortIter *iter;
+  struct timespec start, first, prefix, end;
+  size_t returned;
+
+  ASSERT(field_id >= FIELD_STRING && field_id <= FIELD_FLOAT, "The field id is not in the valid range [1, 3]", profile_iterator__records_sorter);
+  ASSERT(unsorted_count > 0, "No records have been loaded by the profiler", profile_iterator__records_sorter);
+
+  to_be_sorted = (Record *) malloc(sizeof(Record) * unsorted_count);
+  ASSERT(to_be_sorted, "Unable to allocate memory for records to be sorted", profile_iterator__records_sorter);
+  memcpy(to_be_sorted, unsorted_records, sizeof(Record) * unsorted_count);
+
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  new_sort_iter(&iter, to_be_sorted, unsorted_count, sizeof(Record), threshold, get_record_comparator(field_id));
+  sort_iter_next(iter);
+  clock_gettime(CLOCK_MONOTONIC, &first);
+
+  for (returned = 1; returned < PROFILER_ITERATOR_PREFIX_COUNT && sort_iter_next(iter); ++returned);
+  clock_gettime(CLOCK_MONOTONIC, &prefix);
+
+  while (sort_iter_next(iter));
+  clock_gettime(CLOCK_MONOTONIC, &end);
+
+  printf("[PROFILER]<field=%s, threshold=%zu, strategy=sort-iterator>: First record in %f seconds, first %zu records "
+         "in %f seconds, all records in %f seconds.\n", get_field_name(field_id), threshold,
+         get_elapsed_seconds(&start, &first), returned, get_elapsed_seconds(&start, &prefix),
+         get_elapsed_seconds(&start, &end));
+
+  clear_sort_iter(&iter);
   free((void *) to_be_sorted);
+}
+
+void profile_columns__records_sorter(size_t threshold, FieldId field_id, SortEngine engine) {
+  RecordColumns *columns;
+  uint32_t *permutation;
+  SortOptions options;
+  SortStrategy strategy;
+  struct timespec start, end;
+  size_t i;
+
+  ASSERT(field_id >= FIELD_STRING && field_id <= FIELD_FLOAT, "The field id is not in the valid range [1, 3]", profile_columns__records_sorter);
+  ASSERT(unsorted_count > 0, "No records have been loaded by the profiler", profile_columns__records_sorter);
+
+  new_record_columns(&columns, unsorted_count);
+
+  for (i = 0; i < unsorted_count; ++i)
+    push_record_columns(columns, &unsorted_records[i]);
+
+  permutation = (uint32_t *) malloc(sizeof(uint32_t) * unsorted_count);
+  ASSERT(permutation, "Unable to allocate memory for the permutation", profile_columns__records_sorter);
+
+  init_sort_options(&options);
+  options.engine = engine;
+
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  strategy = sort_record_permutation(columns, field_id, threshold, &options, permutation);
+  clock_gettime(CLOCK_MONOTONIC, &end);
+
+  printf("[PROFILER]<field=%s, threshold=%zu, layout=SOA, strategy=%s>: Sorted in %f seconds.\n",
+         get_field_name(field_id), threshold, get_sort_strategy_name(strategy), get_elapsed_seconds(&start, &end));
 
-  g_field_id = -1;
+  free(permutation);
+  clear_record_columns(&columns);
 }
 
 #endif
@@ -1,6 +1,10 @@
 #pragma once
 
 #include <stdio.h>
+#include "record-filter.h"
+#include "record-writer.h"
+#include "counting-sort.h"
+#include "comparator.h"
 
 #ifndef NUMBER_OF_RECORDS
 /**
@@ -34,13 +38,271 @@ typedef enum FieldId {
  */
 void sort_records(FILE *in_file, FILE *out_file, size_t sorting_threshold, FieldId field_id);
 
+/**
+ * @brief Defines how the records are stored in memory while they are sorted.
+ */
+typedef enum RecordsLayout {
+  /** @brief Records are stored as an array of structures, and moved as a whole by the sorting algorithm. */
+  LAYOUT_ARRAY_OF_STRUCTS,
+  /**
+   * @brief Records are stored as a structure of arrays (one column per field). Only the key column is sorted, together
+   * with a permutation vector, and the other columns are gathered while the sorted records are written.
+   */
+  LAYOUT_STRUCT_OF_ARRAYS,
+  /**
+   * @brief Records are stored as an array of compact structures, whose string fields are kept in a string arena and
+   * referenced by a handle with an inline prefix, so the string fields are not truncated (see @c records-arena.h).
+   */
+  LAYOUT_STRING_ARENA
+} RecordsLayout;
+
+/**
+ * @brief Defines the algorithm by which the arrays of records (or of keys) are sorted.
+ */
+typedef enum SortEngine {
+  /** @brief The merge binary insertion sort, run by the calling thread. */
+  SORT_ENGINE_MERGE_BINARY_INSERTION,
+  /**
+   * @brief The stable parallel sample sort (see @c sample-sort.h), run by the worker threads, whose buckets are sorted
+   * by the merge binary insertion sort.
+   */
+  SORT_ENGINE_PARALLEL_SAMPLE,
+  /**
+   * @brief The cache-aware multiway merge sort (see @c multiway-merge-sort.h), run by the calling thread, which makes
+   * fewer passes over the main memory.
+   */
+  SORT_ENGINE_MULTIWAY_MERGE,
+  /**
+   * @brief The pattern-defeating quicksort (see @c pdq-sort.h), run by the calling thread, which sorts in place without
+   * a temporary array, but is not stable: the records with equal keys can be written in any order.
+   */
+  SORT_ENGINE_PDQ
+} SortEngine;
+
+/**
+ * @brief Defines what is written into the output file.
+ */
+typedef enum RecordIndexKind {
+  /** @brief The sorted records, one per line. */
+  RECORD_INDEX_NONE,
+  /** @brief A binary index holding the ids of the records, in sorted order. */
+  RECORD_INDEX_IDS,
+  /** @brief A binary index holding the byte offsets of the lines of the records in the input file, in sorted order. */
+  RECORD_INDEX_OFFSETS
+} RecordIndexKind;
+
+/**
+ * @brief Defines the optional behaviours of the records sorter.
+ */
+typedef struct SortOptions {
+  /**
+   * @brief The path of the binary cache of the parsed records, or NULL to always parse the record file.
+   *
+   * @remark If the cache is valid for the record file, the records are read from it instead of being parsed, otherwise
+   * the record file is parsed and the cache is (re)built.
+   */
+  const char *cache_path;
+
+  /**
+   * @brief How the records are stored in memory while they are sorted.
+   *
+   * @remark The string arena cannot be combined with the modes which ignore the layout (the pipelined mode, the
+   * external sort, the two-pass mode, the append mode, the index, the shards and the sort of several fields), since
+   * they would truncate the string fields: the sorter aborts instead.
+   */
+  RecordsLayout layout;
+
+  /**
+   * @brief 1 to overlap loading, sorting and storing: the records are read in chunks which are sorted into runs by a
+   * pool of workers while the following chunks are read, then the runs are merged straight into the output.
+   *
+   * @remark The pipelined mode ignores the cache and the layout.
+   */
+  int pipelined;
+
+  /** @brief The number of worker threads (0 to use one worker per online processor). */
+  size_t thread_count;
+
+  /**
+   * @brief The algorithm by which the loaded records (or their key column) are sorted.
+   *
+   * @remark The pipelined mode, the external sort and the two-pass mode always sort with the merge binary insertion
+   * sort. The integer fields may be sorted by counting sort regardless of the engine.
+   */
+  SortEngine engine;
+
+  /**
+   * @brief The number of range-partitioned shard files written by @c sort_records_sharded (0 to write a single file).
+   *
+   * @remark It is ignored by @c sort_records_with_options, which always writes a single file. The shards are loaded
+   * and sorted as the array-of-structures layout is (with the cache and the engine), and cannot be combined with the
+   * other layouts, the pipelined mode, the memory budget, the two-pass mode, the append mode nor the index.
+   */
+  size_t shard_count;
+
+  /**
+   * @brief The max number of bytes of the records (and of the temporary array by which they are sorted) kept in
+   * memory, or 0 to load all the records in memory.
+   *
+   * @remark If it is not 0, the records are sorted with an external sort which spills the sorted runs to temporary
+   * files, and the input and output files are accessed sequentially (so they can be pipes). Progress messages are
+   * printed to @c stderr. Each run holds at most half the budget worth of records, since sorting it needs as much
+   * temporary memory; the fixed-size buffers of the reader and the writer come on top of the budget. The external sort
+   * ignores the cache, the layout and the pipelined mode.
+   */
+  size_t memory_budget;
+
+  /**
+   * @brief 1 to sort in two passes without keeping the records in memory: the first pass reads only the key and the
+   * byte span of the line of each record, which are sorted, and the second pass copies the lines of the records from
+   * the memory-mapped input file to the output file, in sorted order.
+   *
+   * @remark The input file must be a regular file. The lines are copied as they are (so the fields are not formatted
+   * again by the writer). The two-pass mode ignores the cache, the layout, the pipelined mode and the memory budget.
+   */
+  int two_pass;
+
+  /**
+   * @brief 1 to collapse the records with equal keys into one aggregated row per distinct key, while the sorted records
+   * are written: each row holds the key, the number of records, the sum of their integer fields and the mean of their
+   * float fields (see @c record-output.h).
+   *
+   * @remark The aggregation is fused into the final output (or merge) pass of every mode but the two-pass mode and the
+   * index, which do not parse the fields of the sorted records.
+   */
+  int aggregate;
+
+  /**
+   * @brief The path of a record file already sorted by the same field, into which the sorted records are merged, or
+   * NULL to write only the sorted records.
+   *
+   * @remark Only the new records are loaded and sorted: the sorted file is streamed once, and merged with them into the
+   * output file (the records of the sorted file come first among equal keys). The append mode cannot be combined with
+   * the other layouts, the pipelined mode, the memory budget, the two-pass mode nor the index.
+   */
+  const char *append_path;
+
+  /**
+   * @brief The filter of the records to be sorted, or NULL to sort every record.
+   *
+   * @remark The filter is evaluated while the records are parsed, so the records which do not match it are never
+   * stored. Since the cache holds every record of the file, the cache is not used when a filter is set.
+   */
+  const RecordFilter *filter;
+
+  /**
+   * @brief What is written into the output file: the sorted records, or a binary index of the records in sorted order
+   * (see @c record-index.h), which is much smaller and cheaper to write.
+   *
+   * @remark The index is built from the structure-of-arrays layout, and ignores the layout, the pipelined mode and the
+   * memory budget. The cache is not used for an index of byte offsets.
+   */
+  RecordIndexKind index_kind;
+
+  /**
+   * @brief How the sorted records are written: the records are formatted into large buffers, which are written in
+   * background by the specified backend (falling back to a simpler backend when it is not available).
+   */
+  RecordWriterBackend writer_backend;
+
+  /** @brief 1 to print (to @c stderr) the writer backend used and the achieved write bandwidth. */
+  int report_bandwidth;
+} SortOptions;
+
+/**
+ * @brief Initializes the specified options with the default behaviour of @c sort_records.
+ * @param options The options to be initialized.
+ */
+void init_sort_options(SortOptions *options);
+
+/**
+ * @brief Same as @c sort_records, but customizes the behaviour of the sorter with the specified options.
+ *
+ * @param in_file The .csv file containing the records.
+ * @param out_file The .txt file in which the sorted records will be written.
+ * @param sorting_threshold The sorting threshold to be passed to the sorting algorithm.
+ * @param field_id The type of the fields to be sorted.
+ * @param options The options of the sorter.
+ */
+void sort_records_with_options(FILE *in_file, FILE *out_file, size_t sorting_threshold, FieldId field_id,
+                               const SortOptions *options);
+
+/**
+ * @brief Sorts an array of generic items with the engine selected by the options.
+ *
+ * @remark The merge binary insertion sort replaces the engines which only apply to the records (the branchless merge
+ * sort of their numeric keys and the counting sort are chosen by @c sort_records_with_options itself).
+ *
+ * @param base Pointer to the beginning of the array to be sorted.
+ * @param count Number of elements in the array (which can be 0).
+ * @param size Size of each element in the array, in bytes.
+ * @param sorting_threshold The sorting threshold to be passed to the sorting algorithm.
+ * @param compare Pointer to the comparison function that defines the order of elements.
+ * @param options The options of the sorter (the engine and the number of worker threads).
+ * @return The strategy by which the items have been sorted.
+ */
+SortStrategy sort_items_with_engine(void *base, size_t count, size_t size, size_t sorting_threshold,
+                                    compare_fn compare, const SortOptions *options);
+
+/**
+ * @brief Returns a new array of the records of a file, read from the cache if it is valid, otherwise parsed from the
+ * file (rebuilding the cache, if enabled).
+ *
+ * @remark At most @c NUMBER_OF_RECORDS records are loaded. The cache is not used if the records are filtered, since
+ * it holds every record of the file.
+ *
+ * @param in_file The .csv file containing the records.
+ * @param cache_path The path of the binary cache of the parsed records, or NULL to always parse the record file.
+ * @param filter The filter of the records to be loaded, or NULL to load every record.
+ * @param count The destination of the number of loaded records.
+ * @return The array of the records, which must be freed.
+ */
+Record *acquire_records(FILE *in_file, const char *cache_path, const RecordFilter *filter, size_t *count);
+
+/**
+ * @brief Sorts an array of records by the specified field, as @c sort_records_with_options does: with the counting
+ * sort if the field is the integer one and its range is small, with the branchless merge sort if the field is numeric
+ * and the engine is the merge binary insertion sort, otherwise with the engine selected by the options.
+ *
+ * @remark The counting sort frees the array and replaces it with a new one, so the array must have been allocated by
+ * @c malloc on its own.
+ *
+ * @param records Pointer to the array of the records, which may be replaced.
+ * @param count Number of records in the array (which can be 0).
+ * @param sorting_threshold The sorting threshold to be passed to the sorting algorithm.
+ * @param field_id The type of the fields to be sorted.
+ * @param options The options of the sorter (the engine and the number of worker threads).
+ * @return The strategy by which the records have been sorted.
+ */
+SortStrategy sort_records_array(Record **records, size_t count, size_t sorting_threshold, FieldId field_id,
+                                const SortOptions *options);
+
+/**
+ * @brief Reads the records stored in the provided file once, then sorts them by each one of the specified fields,
+ * saving each sorted copy in its own file.
+ *
+ * @remark The records are stored as a structure of arrays, shared by all the fields: each field only sorts its key
+ * column into its own permutation, so the fields are sorted and stored concurrently (one field per worker thread).
+ * The layout and the pipelined mode of the options are ignored.
+ *
+ * @param in_file The .csv file containing the records.
+ * @param out_files The files in which the sorted records will be written, one for each field.
+ * @param field_ids The types of the fields to be sorted.
+ * @param field_count The number of fields to be sorted.
+ * @param sorting_threshold The sorting threshold to be passed to the sorting algorithm.
+ * @param options The options of the sorter (the cache path, the filter and the number of worker threads).
+ */
+void sort_records_by_fields(FILE *in_file, FILE *const *out_files, const FieldId *field_ids, size_t field_count,
+                            size_t sorting_threshold, const SortOptions *options);
+
 #if __PROFILER
 
 /**
  * @brief Initializes he profiler loading the records.
  * @param in_file The .csv file containing the records.
+ * @param cache_path The path of the binary cache of the parsed records, or NULL to always parse the record file.
  */
-void init_profiler__records_sorter(FILE *in_file);
+void init_profiler__records_sorter(FILE *in_file, const char *cache_path);
 
 /**
  * @brief Shutdowns the profiler.
@@ -54,4 +316,29 @@ void shutdown_profiler__records_sorter(void);
  */
 void profile__records_sorter(size_t threshold, FieldId field_id);
 
+/**
+ * @brief Same as @c profile__records_sorter, but sorts with the specified engine.
+ * @param threshold The sorting threshold to be passed to the sorting algorithm.
+ * @param field_id The type of fields to be sorted.
+ * @param engine The sorting algorithm.
+ */
+void profile_engine__records_sorter(size_t threshold, FieldId field_id, SortEngine engine);
+
+/**
+ * @brief Profiles the lazy sort of @c sort-iterator.h over the unsorted array: the time until the first record, until
+ * the first thousand records, and until the last record are printed.
+ * @param threshold The length of the leaf runs.
+ * @param field_id The type of fields to be sorted.
+ */
+void profile_iterator__records_sorter(size_t threshold, FieldId field_id);
+
+/**
+ * @brief Profile the execution of the sorting algorithm over the key column of the unsorted records, stored as a
+ * structure of arrays.
+ * @param threshold The sorting threshold to be passed to the sorting algorithm.
+ * @param field_id The type of fields to be sorted.
+ * @param engine The sorting algorithm.
+ */
+void profile_columns__records_sorter(size_t threshold, FieldId field_id, SortEngine engine);
+
 #endif
@@ -0,0 +1,294 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <malloc.h>
+#include <string.h>
+#include <stdint.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "records-two-pass.h"
+#include "merge-binary-insertion-sort.h"
+#include "comparator.h"
+#include "record-reader.h"
+#include "record-writer.h"
+#include "assert_util.h"
+
+/*---------------------------------------------------------------------------------------------------------------*/
+
+// PURPOSE: The number of the low bits of a span which hold the length of a line (the high bits hold its offset).
+#define SPAN_LENGTH_BITS 24
+
+// PURPOSE: Packs the offset and the length of a line into a span.
+#define MAKE_SPAN(offset, length) (((uint64_t) (offset) << SPAN_LENGTH_BITS) | (uint64_t) (length))
+
+// PURPOSE: Unpacks the offset of a line from its span.
+#define SPAN_OFFSET(span) ((span) >> SPAN_LENGTH_BITS)
+
+// PURPOSE: Unpacks the length of a line from its span.
+#define SPAN_LENGTH(span) ((size_t) ((span) & (((uint64_t) 1 << SPAN_LENGTH_BITS) - 1)))
+
+// PURPOSE: The max number of lines copied by each batch of the second pass.
+#define BATCH_LINES (TWO_PASS_BATCH_SIZE >> 6)
+
+/*---------------------------------------------------------------------------------------------------------------*/
+
+// PURPOSE: Pairs an integer key with the span of the line of its record.
+// NOTE: The key is the first member, so the pair can be compared with int_comparator.
+typedef struct IntKeySpan {
+  int32_t key;
+  uint64_t span;
+} IntKeySpan;
+
+// PURPOSE: Pairs a float key with the span of the line of its record.
+// NOTE: The key is the first member, so the pair can be compared with float_comparator.
+typedef struct FloatKeySpan {
+  float key;
+  uint64_t span;
+} FloatKeySpan;
+
+// PURPOSE: Pairs a string key with the span of the line of its record.
+// NOTE: The key is the first member, so the pair can be compared with string_comparator.
+typedef struct StringKeySpan {
+  char key[STRING_FIELD_LEN];
+  uint64_t span;
+} StringKeySpan;
+
+// PURPOSE: Represents the growable array of the key spans of the specified field.
+typedef struct KeySpans {
+  FieldId field_id;
+  unsigned char *items;
+  size_t item_size;
+  size_t count;
+  size_t capacity;
+} KeySpans;
+
+// PURPOSE: Represents a line copied by a batch of the second pass.
+typedef struct BatchLine {
+  uint64_t offset;  // Offset of the line in the input file.
+  size_t length;
+  size_t position;  // Offset of the line in the batch.
+} BatchLine;
+
+/*---------------------------------------------------------------------------------------------------------------*/
+
+// PURPOSE: Returns the size of the key spans of the specified field.
+static size_t get_key_span_size(FieldId field_id) {
+  switch (field_id) {
+    case FIELD_STRING:
+      return sizeof(StringKeySpan);
+    case FIELD_INTEGER:
+      return sizeof(IntKeySpan);
+    case FIELD_FLOAT:
+      return sizeof(FloatKeySpan);
+  }
+
+  PRINT_ERROR("Invalid field ID", get_key_span_size);
+  return 0;
+}
+
+/*---------------------------------------------------------------------------------------------------------------*/
+
+// PURPOSE: Returns the comparator of the key spans of the specified field.
+static compare_fn get_key_span_comparator(FieldId field_id) {
+  switch (field_id) {
+    case FIELD_STRING:
+      return string_comparator;
+    case FIELD_INTEGER:
+      return int_comparator;
+    case FIELD_FLOAT:
+      return float_comparator;
+  }
+
+  PRINT_ERROR("Invalid field ID", get_key_span_comparator);
+  return NULL;
+}
+
+/*---------------------------------------------------------------------------------------------------------------*/
+
+// PURPOSE: Appends the key of a record, paired with the span of its line, to the key spans.
+static void push_key_span(KeySpans *spans, const Record *record, uint64_t span) {
+  unsigned char *item;
+
+  if (spans->count == spans->capacity) {
+    spans->capacity *= 2;
+    spans->items = (unsigned char *) realloc(spans->items, spans->item_size * spans->capacity);
+    ASSERT(spans->items, "Unable to allocate memory for the key spans", push_key_span);
+  }
+
+  item = spans->items + spans->item_size * spans->count++;
+
+  switch (spans->field_id) {
+    case FIELD_STRING:
+      memcpy(((StringKeySpan *) item)->key, record->string_field, STRING_FIELD_LEN);
+      ((StringKeySpan *) item)->span = span;
+      break;
+    case FIELD_INTEGER:
+      ((IntKeySpan *) item)->key = (int32_t) record->int_field;
+      ((IntKeySpan *) item)->span = span;
+      break;
+    case FIELD_FLOAT:
+      ((FloatKeySpan *) item)->key = record->float_field;
+      ((FloatKeySpan *) item)->span = span;
+      break;
+  }
+}
+
+/*---------------------------------------------------------------------------------------------------------------*/
+
+// PURPOSE: Returns the span of the i-th key span.
+static uint64_t get_span(const KeySpans *spans, size_t i) {
+  const unsigned char *item;
+
+  item = spans->items + spans->item_size * i;
+
+  switch (spans->field_id) {
+    case FIELD_STRING:
+      return ((const StringKeySpan *) item)->span;
+    case FIELD_INTEGER:
+      return ((const IntKeySpan *) item)->span;
+    case FIELD_FLOAT:
+      return ((const FloatKeySpan *) item)->span;
+  }
+
+  PRINT_ERROR("Invalid field ID", get_span);
+  return 0;
+}
+
+/*---------------------------------------------------------------------------------------------------------------*/
+
+// PURPOSE: Reads the key and the span of the line of each record (matching the filter, if any) of the input file.
+static void load_key_spans(FILE *in_file, const RecordFilter *filter, KeySpans *spans) {
+  RecordReader *reader;
+  Record record;
+  uint64_t base_offset, offset;
+  size_t length;
+  off_t position;
+
+  // The offsets of the reader are relative to the current position of the file.
+  position = ftello(in_file);
+  ASSERT(position >= 0, "Unable to get the position of the input file", load_key_spans);
+  base_offset = (uint64_t) position;
+
+  new_record_reader(&reader, in_file);
+  set_record_reader_filter(reader, filter);
+
+  while (read_record_span(reader, &record, &offset, &length)) {
+    ASSERT(length < ((size_t) 1 << SPAN_LENGTH_BITS), "The line of a record is too long", load_key_spans);
+    ASSERT(base_offset + offset < ((uint64_t) 1 << (64 - SPAN_LENGTH_BITS)), "The input file is too large",
+           load_key_spans);
+    push_key_span(spans, &record, MAKE_SPAN(base_offset + offset, length));
+  }
+
+  clear_record_reader(&reader);
+}
+
+/*---------------------------------------------------------------------------------------------------------------*/
+
+// PURPOSE: Compares two lines of a batch by their offset in the input file.
+static int compare_batch_lines_fn(const void *line_a, const void *line_b) {
+  uint64_t offset_a, offset_b;
+
+  offset_a = ((const BatchLine *) line_a)->offset;
+  offset_b = ((const BatchLine *) line_b)->offset;
+  return (offset_a > offset_b) - (offset_a < offset_b);
+}
+
+/*---------------------------------------------------------------------------------------------------------------*/
+
+// PURPOSE: Copies the lines of the sorted key spans from the mapped input file to the writer, batch by batch.
+// NOTE: The lines of a batch are copied in file order into their sorted position of the batch, which is then written.
+static void copy_lines(const char *data, size_t size, const KeySpans *spans, size_t sorting_threshold,
+                       RecordWriter *writer) {
+  BatchLine *lines;
+  char *batch;
+  uint64_t span;
+  size_t batch_size, line_count, copy_size, i, j;
+
+  batch = (char *) malloc(TWO_PASS_BATCH_SIZE);
+  lines = (BatchLine *) malloc(sizeof(BatchLine) * BATCH_LINES);
+  ASSERT(batch && lines, "Unable to allocate memory for the batches", copy_lines);
+
+  for (i = 0; i < spans->count;) {
+    batch_size = line_count = 0;
+
+    for (; i < spans->count && line_count < BATCH_LINES; ++i) {
+      span = get_span(spans, i);
+
+      if (batch_size + SPAN_LENGTH(span) > TWO_PASS_BATCH_SIZE)
+        break;
+
+      lines[line_count].offset = SPAN_OFFSET(span);
+      lines[line_count].length = SPAN_LENGTH(span);
+      lines[line_count].position = batch_size;
+      batch_size += lines[line_count++].length;
+    }
+
+    ASSERT(line_count > 0, "The line of a record is longer than a batch", copy_lines);
+    merge_binary_insertion_sort(lines, line_count, sizeof(BatchLine), sorting_threshold, compare_batch_lines_fn);
+
+    for (j = 0; j < line_count; ++j) {
+      ASSERT(lines[j].offset < size, "The input file has changed while it was sorted", copy_lines);
+      copy_size = size - lines[j].offset < lines[j].length ? size - lines[j].offset : lines[j].length;
+      memcpy(batch + lines[j].position, data + lines[j].offset, copy_size);
+
+      // The last line of the file may lack its newline, which is counted in its length.
+      if (copy_size < lines[j].length)
+        batch[lines[j].position + copy_size] = '\n';
+    }
+
+    write_record_bytes(writer, batch, batch_size);
+  }
+
+  free(lines);
+  free(batch);
+}
+
+/*---------------------------------------------------------------------------------------------------------------*/
+
+void sort_records_two_pass(FILE *in_file, FILE *out_file, size_t sorting_threshold, FieldId field_id,
+                           const SortOptions *options) {
+  RecordWriter *writer;
+  KeySpans spans;
+  struct stat status;
+  void *mapping;
+  size_t size;
+
+  ASSERT_NULL_PARAMETER(in_file, sort_records_two_pass);
+  ASSERT_NULL_PARAMETER(out_file, sort_records_two_pass);
+  ASSERT_NULL_PARAMETER(options, sort_records_two_pass);
+  ASSERT(field_id >= FIELD_STRING && field_id <= FIELD_FLOAT, "The field id is not in the valid range [1, 3]", sort_records_two_pass);
+  ASSERT(!fstat(fileno(in_file), &status) && S_ISREG(status.st_mode), "The input file must be a regular file",
+         sort_records_two_pass);
+
+  spans.field_id = field_id;
+  spans.item_size = get_key_span_size(field_id);
+  spans.count = 0;
+  spans.capacity = 1 << 16;
+  spans.items = (unsigned char *) malloc(spans.item_size * spans.capacity);
+  ASSERT(spans.items, "Unable to allocate memory for the key spans", sort_records_two_pass);
+
+  fprintf(stderr, "Loading keys...\n");
+  load_key_spans(in_file, options->filter, &spans);
+
+  fprintf(stderr, "Sorting keys (%zu records, %zu bytes each)...\n", spans.count, spans.item_size);
+  if (spans.count > 0)
+    merge_binary_insertion_sort(spans.items, spans.count, spans.item_size, sorting_threshold,
+                                get_key_span_comparator(field_id));
+
+  fprintf(stderr, "Copying lines...\n");
+  new_record_writer_backend(&writer, out_file, options->writer_backend, options->report_bandwidth);
+
+  if (spans.count > 0) {
+    // The file is mapped once it has been read, so its size covers every span.
+    ASSERT(!fstat(fileno(in_file), &status), "Unable to get the size of the input file", sort_records_two_pass);
+    size = (size_t) status.st_size;
+
+    mapping = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fileno(in_file), 0);
+    ASSERT(mapping != MAP_FAILED, "Unable to map the input file", sort_records_two_pass);
+
+    copy_lines((const char *) mapping, size, &spans, sorting_threshold, writer);
+    munmap(mapping, size);
+  }
+
+  clear_record_writer(&writer);
+  free(spans.items);
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <stdio.h>
+#include "records-sorter.h"
+
+#ifndef TWO_PASS_BATCH_SIZE
+/**
+ * @brief Defines the number of bytes of the lines copied by each batch of the second pass of the two-pass sort.
+ *
+ * @remark This number can be changed by setting this macro before including this header file.
+ */
+#define TWO_PASS_BATCH_SIZE ((size_t) 8 << 20)
+#endif
+
+/**
+ * @brief Sorts the records in two passes, keeping in memory only the key and the byte span of the line of each record.
+ *
+ * @remark The first pass reads the records sequentially and stores, for each one of them, its key paired with the
+ * offset and the length of its line. The pairs are sorted with the merge binary insertion sort, so the peak memory
+ * depends on the size of the key rather than on the size of the record. The second pass maps the input file into
+ * memory and copies the lines into the output file in sorted order: the lines are copied in batches, and the lines of
+ * each batch are read in file order (and placed at their sorted position in the batch), so that the input file is
+ * read sequentially as far as possible. Progress messages are printed to @c stderr, since the output file may be
+ * @c stdout.
+ *
+ * @param in_file The .csv file containing the records, which must be a regular file.
+ * @param out_file The .txt file in which the sorted lines will be written.
+ * @param sorting_threshold The sorting threshold to be passed to the sorting algorithm.
+ * @param field_id The type of the fields to be sorted.
+ * @param options The options of the sorter (the filter and the writer backend).
+ */
+void sort_records_two_pass(FILE *in_file, FILE *out_file, size_t sorting_threshold, FieldId field_id,
+                           const SortOptions *options);
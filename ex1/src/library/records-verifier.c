@@ -0,0 +1,280 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <malloc.h>
+#include <string.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "records-verifier.h"
+#include "record-comparator.h"
+#include "record-reader.h"
+#include "assert_util.h"
+
+/*---------------------------------------------------------------------------------------------------------------*/
+
+// PURPOSE: Represents a chunk of a mapped record file, and the summary of its records computed by a worker.
+typedef struct RecordsChunk {
+  const char *data;  // The whole mapped file.
+  size_t size;
+  size_t begin;  // The records whose line begins in [begin, end) belong to the chunk.
+  size_t end;
+  compare_fn compare;
+  const RecordFilter *filter;
+  RecordsSummary summary;
+  Record first;  // The first and the last records of the chunk, to check the order across the chunks.
+  Record last;
+  uint64_t first_offset;
+} RecordsChunk;
+
+/*---------------------------------------------------------------------------------------------------------------*/
+
+// PURPOSE: Mixes the bits of a 64-bit value (the finalizer of splitmix64).
+static uint64_t mix_bits(uint64_t value) {
+  value ^= value >> 30;
+  value *= 0xbf58476d1ce4e5b9ULL;
+  value ^= value >> 27;
+  value *= 0x94d049bb133111ebULL;
+  return value ^ (value >> 31);
+}
+
+/*---------------------------------------------------------------------------------------------------------------*/
+
+// PURPOSE: Rounds a float field to the millionths printed by the record writer ("%f"), so that a field keeps its
+//          rounded value once it is written and parsed back.
+// NOTE: The product is exact in double precision, and adding and subtracting 2^52 rounds it to the nearest integer,
+//       with ties to even as printf does (larger values are integers already). Adding 0 turns -0 into +0.
+static double round_float_field(float value) {
+  const double shift = 4503599627370496.0;
+  double millionths;
+
+  millionths = (double) value * 1e6;
+
+  if (millionths >= 0 && millionths < shift)
+    millionths = (millionths + shift) - shift;
+  else if (millionths < 0 && millionths > -shift)
+    millionths = -((-millionths + shift) - shift);
+
+  return millionths + 0.0;
+}
+
+/*---------------------------------------------------------------------------------------------------------------*/
+
+// PURPOSE: Computes the hash of a record, from all of its fields.
+static uint64_t hash_record(const Record *record) {
+  uint64_t hash, float_bits;
+  double float_value;
+  const char *c;
+
+  // FNV-1a of the string field.
+  hash = 0xcbf29ce484222325ULL;
+
+  for (c = record->string_field; *c; ++c)
+    hash = (hash ^ (unsigned char) *c) * 0x100000001b3ULL;
+
+  float_value = round_float_field(record->float_field);
+  memcpy(&float_bits, &float_value, sizeof(float_bits));
+
+  hash = mix_bits(hash ^ (uint64_t) record->id);
+  hash = mix_bits(hash ^ (uint32_t) record->int_field);
+  return mix_bits(hash ^ float_bits);
+}
+
+/*---------------------------------------------------------------------------------------------------------------*/
+
+// PURPOSE: Records that the record at the specified offset is smaller than the previous one.
+static void add_unsorted_record(RecordsSummary *summary, uint64_t offset) {
+  if (summary->unsorted_count++ == 0 || offset < summary->first_unsorted_offset)
+    summary->first_unsorted_offset = offset;
+}
+
+/*---------------------------------------------------------------------------------------------------------------*/
+
+// PURPOSE: Summarizes the records of a chunk.
+static void *summarize_chunk_fn(void *arg) {
+  RecordsChunk *chunk;
+  Record records[2], *record, *previous;
+  const char *line, *newline;
+  size_t position, length;
+
+  chunk = (RecordsChunk *) arg;
+  position = chunk->begin;
+  previous = NULL;
+  record = &records[0];
+
+  // The chunk begins with the first line which begins in it.
+  if (position > 0 && chunk->data[position - 1] != '\n') {
+    newline = (const char *) memchr(chunk->data + position, '\n', chunk->size - position);
+    position = newline ? (size_t) (newline - chunk->data) + 1 : chunk->size;
+  }
+
+  // The last line of the chunk may end in the following chunk.
+  while (position < chunk->end) {
+    line = chunk->data + position;
+    newline = (const char *) memchr(line, '\n', chunk->size - position);
+    length = newline ? (size_t) (newline - line) + 1 : chunk->size - position;
+
+    // The empty lines are skipped, as the record reader does.
+    if (line[0] != '\n') {
+      if (!parse_record(line, length, record)) {
+        chunk->summary.malformed_count++;
+      } else if (!chunk->filter || match_record_filter(chunk->filter, record)) {
+        if (!previous) {
+          chunk->first = *record;
+          chunk->first_offset = position;
+        } else if (chunk->compare && chunk->compare(previous, record) > 0) {
+          add_unsorted_record(&chunk->summary, position);
+        }
+
+        chunk->summary.count++;
+        chunk->summary.checksum += hash_record(record);
+        previous = record;
+        record = record == &records[0] ? &records[1] : &records[0];
+      }
+    }
+
+    position += length;
+  }
+
+  if (previous)
+    chunk->last = *previous;
+
+  return NULL;
+}
+
+/*---------------------------------------------------------------------------------------------------------------*/
+
+void summarize_records(FILE *file, compare_fn compare, const RecordFilter *filter, size_t thread_count,
+                       RecordsSummary *summary) {
+  RecordsChunk *chunks;
+  const Record *last;
+  pthread_t *workers;
+  struct stat status;
+  void *mapping;
+  size_t size, i;
+  long online_count;
+
+  ASSERT_NULL_PARAMETER(file, summarize_records);
+  ASSERT_NULL_PARAMETER(summary, summarize_records);
+
+  memset(summary, 0, sizeof(RecordsSummary));
+
+  ASSERT(!fstat(fileno(file), &status) && S_ISREG(status.st_mode), "The record file must be a regular file",
+         summarize_records);
+
+  size = (size_t) status.st_size;
+
+  if (size == 0)
+    return;
+
+  mapping = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fileno(file), 0);
+  ASSERT(mapping != MAP_FAILED, "Unable to map the record file", summarize_records);
+  posix_madvise(mapping, size, POSIX_MADV_SEQUENTIAL);
+
+  if (thread_count == 0) {
+    online_count = sysconf(_SC_NPROCESSORS_ONLN);
+    thread_count = online_count > 0 ? (size_t) online_count : 1;
+  }
+
+  chunks = (RecordsChunk *) calloc(thread_count, sizeof(RecordsChunk));
+  workers = (pthread_t *) malloc(sizeof(pthread_t) * thread_count);
+  ASSERT(chunks && workers, "Unable to allocate memory for the workers", summarize_records);
+
+  for (i = 0; i < thread_count; ++i) {
+    chunks[i].data = (const char *) mapping;
+    chunks[i].size = size;
+    chunks[i].begin = size / thread_count * i;
+    chunks[i].end = i + 1 < thread_count ? size / thread_count * (i + 1) : size;
+    chunks[i].compare = compare;
+    chunks[i].filter = filter;
+  }
+
+  // The calling thread summarizes the first chunk.
+  for (i = 1; i < thread_count; ++i)
+    ASSERT(!pthread_create(&workers[i], NULL, summarize_chunk_fn, &chunks[i]), "Unable to start a worker",
+           summarize_records);
+
+  summarize_chunk_fn(&chunks[0]);
+
+  for (i = 1; i < thread_count; ++i)
+    pthread_join(workers[i], NULL);
+
+  last = NULL;
+
+  for (i = 0; i < thread_count; ++i) {
+    summary->malformed_count += chunks[i].summary.malformed_count;
+
+    if (chunks[i].summary.count == 0)
+      continue;
+
+    // The first record of a chunk must not be smaller than the last record of the previous (non-empty) chunk.
+    if (compare && last && compare(last, &chunks[i].first) > 0)
+      add_unsorted_record(summary, chunks[i].first_offset);
+
+    if (chunks[i].summary.unsorted_count > 0) {
+      add_unsorted_record(summary, chunks[i].summary.first_unsorted_offset);
+      summary->unsorted_count += chunks[i].summary.unsorted_count - 1;
+    }
+
+    summary->count += chunks[i].summary.count;
+    summary->checksum += chunks[i].summary.checksum;
+    last = &chunks[i].last;
+  }
+
+  free(workers);
+  free(chunks);
+  munmap(mapping, size);
+}
+
+/*---------------------------------------------------------------------------------------------------------------*/
+
+int verify_sorted_records(FILE *in_file, FILE *sorted_file, FieldId field_id, const SortOptions *options) {
+  RecordsSummary in_summary, sorted_summary;
+  int valid;
+
+  ASSERT_NULL_PARAMETER(in_file, verify_sorted_records);
+  ASSERT_NULL_PARAMETER(sorted_file, verify_sorted_records);
+  ASSERT_NULL_PARAMETER(options, verify_sorted_records);
+  ASSERT(field_id >= FIELD_STRING && field_id <= FIELD_FLOAT, "The field id is not in the valid range [1, 3]",
+         verify_sorted_records);
+
+  printf("Summarizing input records...\n");
+  summarize_records(in_file, NULL, options->filter, options->thread_count, &in_summary);
+
+  // The sorted file holds only the records which matched the filter, so it is not filtered again.
+  printf("Verifying sorted records...\n");
+  summarize_records(sorted_file, get_record_comparator(field_id), NULL, options->thread_count, &sorted_summary);
+
+  valid = 1;
+
+  if (in_summary.malformed_count > 0) {
+    printf("FAILED: %zu malformed lines in the input file.\n", in_summary.malformed_count);
+    valid = 0;
+  }
+
+  if (sorted_summary.malformed_count > 0) {
+    printf("FAILED: %zu malformed lines in the sorted file.\n", sorted_summary.malformed_count);
+    valid = 0;
+  }
+
+  if (sorted_summary.unsorted_count > 0) {
+    printf("FAILED: %zu records out of order (the first one at byte %llu).\n", sorted_summary.unsorted_count,
+           (unsigned long long) sorted_summary.first_unsorted_offset);
+    valid = 0;
+  }
+
+  if (sorted_summary.count != in_summary.count) {
+    printf("FAILED: %zu sorted records, %zu input records.\n", sorted_summary.count, in_summary.count);
+    valid = 0;
+  } else if (sorted_summary.checksum != in_summary.checksum) {
+    printf("FAILED: the checksum of the sorted records (%016llx) does not match the input (%016llx).\n",
+           (unsigned long long) sorted_summary.checksum, (unsigned long long) in_summary.checksum);
+    valid = 0;
+  }
+
+  if (valid)
+    printf("OK: %zu records sorted (checksum %016llx).\n", sorted_summary.count,
+           (unsigned long long) sorted_summary.checksum);
+
+  return valid;
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <stdio.h>
+#include <stdint.h>
+#include "comparator.h"
+#include "records-sorter.h"
+
+/**
+ * @brief Summarizes the records of a record file, as computed by a single scan of the file.
+ */
+typedef struct RecordsSummary {
+  size_t count;  ///< Number of records.
+  uint64_t checksum;  ///< Order-independent checksum of the records (the sum of the hashes of the records).
+  size_t malformed_count;  ///< Number of lines which are not valid records.
+  size_t unsorted_count;  ///< Number of records which are smaller than the previous record.
+  uint64_t first_unsorted_offset;  ///< Byte offset of the line of the first unsorted record (if there is one).
+} RecordsSummary;
+
+/**
+ * @brief Summarizes the records of a record file, scanning the file in parallel chunks.
+ *
+ * @remark The file is memory-mapped (so it must be a regular file) and split into one chunk per thread, aligned to the
+ * beginning of the lines. The order of the records is checked within each chunk and across the boundaries of the
+ * chunks. The hash of a record depends on its float field as it is printed by the record writer (with 6 decimals), so
+ * a record file and the file written by sorting it have the same checksum.
+ *
+ * @param file The record file.
+ * @param compare The comparator of the records (@c Record) which must be sorted, or NULL not to check the order.
+ * @param filter The filter of the records to be summarized, or NULL to summarize every record.
+ * @param thread_count The number of threads (0 to use one thread per online processor).
+ * @param summary The destination summary.
+ */
+void summarize_records(FILE *file, compare_fn compare, const RecordFilter *filter, size_t thread_count,
+                       RecordsSummary *summary);
+
+/**
+ * @brief Verifies that a file written by the records sorter holds the records of the input file, sorted by the
+ * specified field, and prints the outcome.
+ *
+ * @remark Both files are read only once: the sorted file is verified to be in order and to hold valid records, and its
+ * number of records and its checksum are compared with the ones of the input file.
+ *
+ * @param in_file The .csv file containing the records.
+ * @param sorted_file The file in which the sorted records have been written.
+ * @param field_id The type of the sorted fields.
+ * @param options The options with which the records have been sorted (only the filter and the number of threads are
+ * used).
+ * @return 1 if the sorted file is valid, 0 otherwise.
+ */
+int verify_sorted_records(FILE *in_file, FILE *sorted_file, FieldId field_id, const SortOptions *options);
@@ -0,0 +1,119 @@
+#include <malloc.h>
+#include <stdlib.h>
+#include "run-merger.h"
+#include "assert_util.h"
+
+/*---------------------------------------------------------------------------------------------------------------*/
+
+// PURPOSE: Returns 1 if the head of run a must be extracted before the head of run b.
+// NOTE: A consumed run never wins, and ties are broken by run index to keep the merge stable.
+static int beats(const RunMerger *merger, size_t a, size_t b) {
+  int cmp_res;
+
+  if (merger->heads[a] == merger->ends[a]) return 0;
+  if (merger->heads[b] == merger->ends[b]) return 1;
+
+  cmp_res = merger->compare(merger->heads[a], merger->heads[b]);
+  return cmp_res < 0 || (cmp_res == 0 && a < b);
+}
+
+/*---------------------------------------------------------------------------------------------------------------*/
+
+// PURPOSE: Plays the matches of the subtree rooted at the specified node, storing the losers and returning the winner.
+// NOTE: The leaves (runs) are the nodes [run_count, 2 * run_count - 1].
+static size_t build_tree(RunMerger *merger, size_t node) { // NOLINT(*-no-recursion)
+  size_t left, right;
+
+  if (node >= merger->run_count)
+    return node - merger->run_count;
+
+  left = build_tree(merger, 2 * node);
+  right = build_tree(merger, 2 * node + 1);
+
+  if (beats(merger, left, right)) {
+    merger->tree[node] = right;
+    return left;
+  }
+
+  merger->tree[node] = left;
+  return right;
+}
+
+/*---------------------------------------------------------------------------------------------------------------*/
+
+void new_run_merger(RunMerger **merger, void *const *runs, const size_t *counts, size_t run_count, size_t size,
+                    compare_fn compare) {
+  size_t i;
+
+  ASSERT_NULL_PARAMETER(merger, new_run_merger);
+  ASSERT(runs || !run_count, "'runs' parameter is NULL", new_run_merger);
+  ASSERT(counts || !run_count, "'counts' parameter is NULL", new_run_merger);
+  ASSERT_NULL_PARAMETER(compare, new_run_merger);
+  ASSERT(size > 0, "The element size cannot be zero", new_run_merger);
+
+  *merger = (RunMerger *) malloc(sizeof(RunMerger));
+  ASSERT(*merger, "Unable to allocate memory for the run merger", new_run_merger);
+
+  (*merger)->run_count = run_count;
+  (*merger)->size = size;
+  (*merger)->compare = compare;
+  (*merger)->heads = (const unsigned char **) malloc(sizeof(unsigned char *) * (run_count + 1));
+  (*merger)->ends = (const unsigned char **) malloc(sizeof(unsigned char *) * (run_count + 1));
+  (*merger)->tree = (size_t *) malloc(sizeof(size_t) * (run_count + 1));
+
+  ASSERT((*merger)->heads && (*merger)->ends && (*merger)->tree, "Unable to allocate memory for the loser tree",
+         new_run_merger);
+
+  for (i = 0; i < run_count; ++i) {
+    (*merger)->heads[i] = (const unsigned char *) runs[i];
+    (*merger)->ends[i] = (const unsigned char *) runs[i] + counts[i] * size;
+  }
+
+  if (run_count > 0)
+    (*merger)->tree[0] = build_tree(*merger, 1);
+}
+
+/*---------------------------------------------------------------------------------------------------------------*/
+
+void clear_run_merger(RunMerger **merger) {
+  ASSERT_NULL_PARAMETER(merger, clear_run_merger);
+  ASSERT_NULL_PARAMETER(*merger, clear_run_merger);
+
+  free((*merger)->heads);
+  free((*merger)->ends);
+  free((*merger)->tree);
+  free(*merger);
+  *merger = NULL;
+}
+
+/*---------------------------------------------------------------------------------------------------------------*/
+
+const void *next_run_merger(RunMerger *merger) {
+  const void *item;
+  size_t winner, node, tmp;
+
+  ASSERT_NULL_PARAMETER(merger, next_run_merger);
+
+  if (merger->run_count == 0)
+    return NULL;
+
+  winner = merger->tree[0];
+
+  if (merger->heads[winner] == merger->ends[winner])
+    return NULL;
+
+  item = merger->heads[winner];
+  merger->heads[winner] += merger->size;
+
+  // Replays the matches on the path from the winner leaf to the root.
+  for (node = (winner + merger->run_count) / 2; node > 0; node /= 2) {
+    if (beats(merger, merger->tree[node], winner)) {
+      tmp = merger->tree[node];
+      merger->tree[node] = winner;
+      winner = tmp;
+    }
+  }
+
+  merger->tree[0] = winner;
+  return item;
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <stddef.h>
+#include "comparator.h"
+
+/**
+ * @brief Represents a k-way merger of sorted runs of generic items, based on a tournament (loser) tree.
+ *
+ * @remark Each call to @c next_run_merger costs O(log k) comparisons. Items which compare equal are returned in run
+ * order (and, within a run, in their original order), so merging the runs of a stable sort keeps it stable.
+ */
+typedef struct RunMerger {
+  const unsigned char **heads;  ///< Pointer to the next item of each run.
+  const unsigned char **ends;  ///< Pointer past the last item of each run.
+  size_t *tree;  ///< The loser tree: <code>tree[0]</code> is the current winner, the other nodes hold the losers.
+  size_t run_count;  ///< Number of merged runs.
+  size_t size;  ///< Size of each item, in bytes.
+  compare_fn compare;  ///< Pointer to the comparison function for ordering items.
+} RunMerger;
+
+/**
+ * @brief Allocates a new merger over the specified sorted runs.
+ * @param merger Pointer to the pointer that will hold the merger.
+ * @param runs Array of pointers to the first item of each run.
+ * @param counts Array containing the number of items of each run.
+ * @param run_count Number of runs.
+ * @param size Size of each item, in bytes.
+ * @param compare Pointer to the comparison function used for ordering items.
+ * @note The runs are not copied, so they must outlive the merger.
+ */
+void new_run_merger(RunMerger **merger, void *const *runs, const size_t *counts, size_t run_count, size_t size,
+                    compare_fn compare);
+
+/**
+ * @brief Deallocates the specified merger.
+ * @param merger Pointer to the merger to be cleared.
+ */
+void clear_run_merger(RunMerger **merger);
+
+/**
+ * @brief Extracts the smallest item among the heads of the runs.
+ * @param merger The merger.
+ * @return Pointer to the extracted item (which lives inside its run), or NULL if all the runs have been consumed.
+ */
+const void *next_run_merger(RunMerger *merger);
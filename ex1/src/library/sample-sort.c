@@ -0,0 +1,264 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <malloc.h>
+#include <string.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <pthread.h>
+#include "sample-sort.h"
+#include "merge-binary-insertion-sort.h"
+#include "assert_util.h"
+
+/*---------------------------------------------------------------------------------------------------------------*/
+
+// PURPOSE: Represents the state of a parallel sample sort, shared by its threads. There is one bucket per thread.
+typedef struct SampleSort {
+  unsigned char *base;
+  unsigned char *buffer;  // The temporary array into which the items are scattered by bucket.
+  size_t count;
+  size_t size;
+  size_t threshold;
+  compare_fn compare;
+  size_t thread_count;
+  unsigned char *splitters;  // The thread_count - 1 splitters of the buckets.
+  uint32_t *item_buckets;  // The bucket of each item.
+  size_t *offsets;  // The per-thread counts of each bucket (thread-major), then the per-thread scatter offsets.
+  size_t *bucket_starts;  // The offset of each bucket in the temporary array (thread_count + 1 entries).
+} SampleSort;
+
+// PURPOSE: Represents the task of a thread during a phase of the sort.
+typedef struct SampleSortTask {
+  SampleSort *sort;
+  size_t index;
+} SampleSortTask;
+
+/*---------------------------------------------------------------------------------------------------------------*/
+
+// PURPOSE: Returns the number of threads to be used when the caller does not specify it.
+static size_t get_default_thread_count(void) {
+  long count;
+
+  count = sysconf(_SC_NPROCESSORS_ONLN);
+  return count > 0 ? (size_t) count : 1;
+}
+
+/*---------------------------------------------------------------------------------------------------------------*/
+
+// PURPOSE: Returns the first item of the slice of the array assigned to the specified thread.
+static size_t get_slice_begin(const SampleSort *sort, size_t index) {
+  return sort->count / sort->thread_count * index + (index < sort->count % sort->thread_count ? index :
+                                                     sort->count % sort->thread_count);
+}
+
+/*---------------------------------------------------------------------------------------------------------------*/
+
+// PURPOSE: Returns the bucket of an item: the first bucket whose splitter is not smaller than the item (the items
+//          greater than every splitter belong to the last bucket), so that equal items share their bucket.
+static size_t find_bucket(const SampleSort *sort, const void *item) {
+  size_t low, high, middle;
+
+  low = 0;
+  high = sort->thread_count - 1;
+
+  while (low < high) {
+    middle = low + (high - low) / 2;
+
+    if (sort->compare(sort->splitters + middle * sort->size, item) < 0)
+      low = middle + 1;
+    else
+      high = middle;
+  }
+
+  return low;
+}
+
+/*---------------------------------------------------------------------------------------------------------------*/
+
+// PURPOSE: Chooses the splitters of the buckets from a sorted sample of the array, evenly spaced in the array.
+static void choose_splitters(SampleSort *sort) {
+  unsigned char *sample;
+  size_t sample_count, i;
+
+  sample_count = sort->thread_count * SAMPLE_SORT_OVERSAMPLING;
+  sample_count = sample_count < sort->count ? sample_count : sort->count;
+
+  sample = (unsigned char *) malloc(sort->size * sample_count);
+  ASSERT(sample, "Unable to allocate memory for the sample", choose_splitters);
+
+  for (i = 0; i < sample_count; ++i)
+    memcpy(sample + i * sort->size, sort->base + i * sort->count / sample_count * sort->size, sort->size);
+
+  merge_binary_insertion_sort(sample, sample_count, sort->size, sort->threshold, sort->compare);
+
+  for (i = 1; i < sort->thread_count; ++i)
+    memcpy(sort->splitters + (i - 1) * sort->size, sample + i * sample_count / sort->thread_count * sort->size,
+           sort->size);
+
+  free(sample);
+}
+
+/*---------------------------------------------------------------------------------------------------------------*/
+
+// PURPOSE: Assigns the items of the slice of a thread to their buckets, and counts the items of each bucket.
+static void *classify_slice_fn(void *arg) {
+  SampleSortTask *task;
+  SampleSort *sort;
+  size_t *counts, begin, end, bucket, i;
+
+  task = (SampleSortTask *) arg;
+  sort = task->sort;
+  counts = sort->offsets + task->index * sort->thread_count;
+  begin = get_slice_begin(sort, task->index);
+  end = get_slice_begin(sort, task->index + 1);
+
+  for (i = begin; i < end; ++i) {
+    bucket = find_bucket(sort, sort->base + i * sort->size);
+    sort->item_buckets[i] = (uint32_t) bucket;
+    counts[bucket]++;
+  }
+
+  return NULL;
+}
+
+/*---------------------------------------------------------------------------------------------------------------*/
+
+// PURPOSE: Scatters the items of the slice of a thread into their buckets of the temporary array.
+static void *scatter_slice_fn(void *arg) {
+  SampleSortTask *task;
+  SampleSort *sort;
+  size_t *offsets, begin, end, i;
+
+  task = (SampleSortTask *) arg;
+  sort = task->sort;
+  offsets = sort->offsets + task->index * sort->thread_count;
+  begin = get_slice_begin(sort, task->index);
+  end = get_slice_begin(sort, task->index + 1);
+
+  for (i = begin; i < end; ++i)
+    memcpy(sort->buffer + offsets[sort->item_buckets[i]]++ * sort->size, sort->base + i * sort->size, sort->size);
+
+  return NULL;
+}
+
+/*---------------------------------------------------------------------------------------------------------------*/
+
+// PURPOSE: Sorts the bucket of a thread, and copies it back into the array.
+static void *sort_bucket_fn(void *arg) {
+  SampleSortTask *task;
+  SampleSort *sort;
+  size_t begin, count;
+
+  task = (SampleSortTask *) arg;
+  sort = task->sort;
+  begin = sort->bucket_starts[task->index];
+  count = sort->bucket_starts[task->index + 1] - begin;
+
+  if (count == 0)
+    return NULL;
+
+  merge_binary_insertion_sort(sort->buffer + begin * sort->size, count, sort->size, sort->threshold, sort->compare);
+  memcpy(sort->base + begin * sort->size, sort->buffer + begin * sort->size, count * sort->size);
+  return NULL;
+}
+
+/*---------------------------------------------------------------------------------------------------------------*/
+
+// PURPOSE: Runs a phase of the sort, with one task per thread (the calling thread runs the first task).
+static void run_phase(SampleSort *sort, SampleSortTask *tasks, pthread_t *threads, void *(*phase_fn)(void *)) {
+  size_t i;
+
+  for (i = 1; i < sort->thread_count; ++i)
+    ASSERT(!pthread_create(&threads[i], NULL, phase_fn, &tasks[i]), "Unable to start a thread", run_phase);
+
+  phase_fn(&tasks[0]);
+
+  for (i = 1; i < sort->thread_count; ++i)
+    pthread_join(threads[i], NULL);
+}
+
+/*---------------------------------------------------------------------------------------------------------------*/
+
+// PURPOSE: Turns the per-thread counts of the buckets into the offsets at which each thread scatters its items: the
+//          items of a bucket are ordered by thread, so that the scatter keeps the array order of the items.
+static void prefix_sum_offsets(SampleSort *sort) {
+  size_t offset, count, bucket, thread;
+
+  offset = 0;
+
+  for (bucket = 0; bucket < sort->thread_count; ++bucket) {
+    sort->bucket_starts[bucket] = offset;
+
+    for (thread = 0; thread < sort->thread_count; ++thread) {
+      count = sort->offsets[thread * sort->thread_count + bucket];
+      sort->offsets[thread * sort->thread_count + bucket] = offset;
+      offset += count;
+    }
+  }
+
+  sort->bucket_starts[sort->thread_count] = offset;
+}
+
+/*---------------------------------------------------------------------------------------------------------------*/
+
+void parallel_sample_sort(void *base, size_t count, size_t size, size_t threshold, compare_fn compare) {
+  parallel_sample_sort_threads(base, count, size, threshold, compare, 0);
+}
+
+/*---------------------------------------------------------------------------------------------------------------*/
+
+void parallel_sample_sort_threads(void *base, size_t count, size_t size, size_t threshold, compare_fn compare,
+                                  size_t thread_count) {
+  SampleSort sort;
+  SampleSortTask *tasks;
+  pthread_t *threads;
+  size_t i;
+
+  ASSERT_NULL_PARAMETER(base, parallel_sample_sort);
+  ASSERT_NULL_PARAMETER(compare, parallel_sample_sort);
+  ASSERT(count > 0, "The array must contain at least one element", parallel_sample_sort);
+  ASSERT(size > 0, "The element size cannot be zero", parallel_sample_sort);
+
+  if (thread_count == 0)
+    thread_count = get_default_thread_count();
+
+  if (thread_count == 1 || count < SAMPLE_SORT_MIN_COUNT) {
+    merge_binary_insertion_sort(base, count, size, threshold, compare);
+    return;
+  }
+
+  sort.base = (unsigned char *) base;
+  sort.count = count;
+  sort.size = size;
+  sort.threshold = threshold;
+  sort.compare = compare;
+  sort.thread_count = thread_count;
+  sort.buffer = (unsigned char *) malloc(size * count);
+  sort.splitters = (unsigned char *) malloc(size * (thread_count - 1));
+  sort.item_buckets = (uint32_t *) malloc(sizeof(uint32_t) * count);
+  sort.offsets = (size_t *) calloc(thread_count * thread_count, sizeof(size_t));
+  sort.bucket_starts = (size_t *) malloc(sizeof(size_t) * (thread_count + 1));
+  tasks = (SampleSortTask *) malloc(sizeof(SampleSortTask) * thread_count);
+  threads = (pthread_t *) malloc(sizeof(pthread_t) * thread_count);
+
+  ASSERT(sort.buffer && sort.splitters && sort.item_buckets && sort.offsets && sort.bucket_starts && tasks && threads,
+         "Unable to allocate memory for the sample sort", parallel_sample_sort);
+
+  for (i = 0; i < thread_count; ++i) {
+    tasks[i].sort = &sort;
+    tasks[i].index = i;
+  }
+
+  choose_splitters(&sort);
+  run_phase(&sort, tasks, threads, classify_slice_fn);
+  prefix_sum_offsets(&sort);
+  run_phase(&sort, tasks, threads, scatter_slice_fn);
+  run_phase(&sort, tasks, threads, sort_bucket_fn);
+
+  free(threads);
+  free(tasks);
+  free(sort.bucket_starts);
+  free(sort.offsets);
+  free(sort.item_buckets);
+  free(sort.splitters);
+  free(sort.buffer);
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <stddef.h>
+#include "comparator.h"
+
+#ifndef SAMPLE_SORT_OVERSAMPLING
+/**
+ * @brief Defines the number of items sampled for each bucket to choose the splitters of the parallel sample sort.
+ *
+ * @remark This number can be changed by setting this macro before including this header file.
+ */
+#define SAMPLE_SORT_OVERSAMPLING 64
+#endif
+
+#ifndef SAMPLE_SORT_MIN_COUNT
+/**
+ * @brief Defines the min number of items for which the parallel sample sort runs in parallel: smaller arrays are
+ * sorted by the calling thread with the merge binary insertion sort.
+ *
+ * @remark This number can be changed by setting this macro before including this header file.
+ */
+#define SAMPLE_SORT_MIN_COUNT (1 << 14)
+#endif
+
+/**
+ * @brief Perform a stable parallel sample sort over an array of generic items.
+ *
+ * @remark The splitters of one bucket per thread are chosen from a sorted sample of the array (oversampled by
+ * @c SAMPLE_SORT_OVERSAMPLING). Each thread assigns the items of its own slice of the array to the buckets, then the
+ * per-thread counts are prefix-summed so that each thread scatters its items into their buckets of a temporary array,
+ * without locks. Finally each bucket is sorted by a thread with the merge binary insertion sort, and copied back. The
+ * items are scattered in array order and the buckets are sorted by a stable algorithm, so the sort is stable. Unlike
+ * the recursive halving of the merge sort, no pass touches the whole array from a single thread.
+ *
+ * @param base      Pointer to the beginning of the array to be sorted.
+ * @param count     Number of elements in the array.
+ * @param size      Size of each element in the array, in bytes.
+ * @param threshold The threshold passed to the merge binary insertion sort of the buckets.
+ * @param compare   Pointer to the comparison function that defines the order of elements.
+ *
+ * @note One thread per online processor is used.
+ */
+void parallel_sample_sort(void *base, size_t count, size_t size, size_t threshold, compare_fn compare);
+
+/**
+ * @brief Same as @c parallel_sample_sort, but uses the specified number of threads.
+ *
+ * @param base         Pointer to the beginning of the array to be sorted.
+ * @param count        Number of elements in the array.
+ * @param size         Size of each element in the array, in bytes.
+ * @param threshold    The threshold passed to the merge binary insertion sort of the buckets.
+ * @param compare      Pointer to the comparison function that defines the order of elements.
+ * @param thread_count The number of threads (0 to use one thread per online processor).
+ */
+void parallel_sample_sort_threads(void *base, size_t count, size_t size, size_t threshold, compare_fn compare,
+                                  size_t thread_count);
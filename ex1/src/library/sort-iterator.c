@@ -0,0 +1,59 @@
+#include <malloc.h>
+#include "sort-iterator.h"
+#include "merge-binary-insertion-sort.h"
+#include "assert_util.h"
+
+/*---------------------------------------------------------------------------------------------------------------*/
+
+void new_sort_iter(SortIter **iter, void *base, size_t count, size_t size, size_t threshold, compare_fn compare) {
+  unsigned char *items;
+  size_t i;
+
+  ASSERT_NULL_PARAMETER(iter, new_sort_iter);
+  ASSERT(base || !count, "'base' parameter is NULL", new_sort_iter);
+  ASSERT_NULL_PARAMETER(compare, new_sort_iter);
+  ASSERT(size > 0, "The element size cannot be zero", new_sort_iter);
+
+  if (threshold == 0)
+    threshold = 1;
+
+  *iter = (SortIter *) malloc(sizeof(SortIter));
+  ASSERT(*iter, "Unable to allocate memory for the sort iterator", new_sort_iter);
+
+  (*iter)->run_count = (count + threshold - 1) / threshold;
+  (*iter)->runs = (void **) malloc(sizeof(void *) * ((*iter)->run_count + 1));
+  (*iter)->counts = (size_t *) malloc(sizeof(size_t) * ((*iter)->run_count + 1));
+  ASSERT((*iter)->runs && (*iter)->counts, "Unable to allocate memory for the leaf runs", new_sort_iter);
+
+  items = (unsigned char *) base;
+
+  // Each leaf run is not longer than the threshold, so it is sorted by binary insertion.
+  for (i = 0; i < (*iter)->run_count; ++i) {
+    (*iter)->runs[i] = items + i * threshold * size;
+    (*iter)->counts[i] = i + 1 < (*iter)->run_count ? threshold : count - i * threshold;
+    merge_binary_insertion_sort((*iter)->runs[i], (*iter)->counts[i], size, threshold, compare);
+  }
+
+  new_run_merger(&(*iter)->merger, (*iter)->runs, (*iter)->counts, (*iter)->run_count, size, compare);
+}
+
+/*---------------------------------------------------------------------------------------------------------------*/
+
+void clear_sort_iter(SortIter **iter) {
+  ASSERT_NULL_PARAMETER(iter, clear_sort_iter);
+  ASSERT_NULL_PARAMETER(*iter, clear_sort_iter);
+
+  clear_run_merger(&(*iter)->merger);
+  free((*iter)->runs);
+  free((*iter)->counts);
+  free(*iter);
+  *iter = NULL;
+}
+
+/*---------------------------------------------------------------------------------------------------------------*/
+
+const void *sort_iter_next(SortIter *iter) {
+  ASSERT_NULL_PARAMETER(iter, sort_iter_next);
+
+  return next_run_merger(iter->merger);
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <stddef.h>
+#include "comparator.h"
+#include "run-merger.h"
+
+/**
+ * @brief Represents a lazy sort of an array of generic items, which returns the items in sorted order one at a time.
+ *
+ * @remark The array is split into leaf runs of @c threshold items, each one sorted in place by binary insertion, then
+ * a tournament tree (see @c run-merger.h) is built over the leaf runs. Only the leaf runs are sorted before the first
+ * item is returned, which costs O(n * threshold) comparisons, i.e. O(n) for a constant threshold; each following item
+ * costs O(log(n / threshold)) comparisons. A consumer which stops after the first k items never pays for the full
+ * merge of the runs.
+ *
+ * @remark Items which compare equal are returned in their original order.
+ */
+typedef struct SortIter {
+  RunMerger *merger;  ///< The merger of the leaf runs.
+  void **runs;  ///< Pointer to the first item of each leaf run.
+  size_t *counts;  ///< Number of items of each leaf run.
+  size_t run_count;  ///< Number of leaf runs.
+} SortIter;
+
+/**
+ * @brief Sorts the leaf runs of the array, and allocates a new iterator over its items in sorted order.
+ * @param iter Pointer to the pointer that will hold the iterator.
+ * @param base Pointer to the beginning of the array, whose leaf runs are sorted in place.
+ * @param count Number of items of the array.
+ * @param size Size of each item, in bytes.
+ * @param threshold The length of the leaf runs (0 is taken as 1).
+ * @param compare Pointer to the comparison function that defines the order of the items.
+ * @note The array is not copied, so it must outlive the iterator and must not be modified while it is iterated.
+ */
+void new_sort_iter(SortIter **iter, void *base, size_t count, size_t size, size_t threshold, compare_fn compare);
+
+/**
+ * @brief Deallocates the specified iterator (the items which have not been returned are left partially sorted).
+ * @param iter Pointer to the iterator to be cleared.
+ */
+void clear_sort_iter(SortIter **iter);
+
+/**
+ * @brief Returns the next item in sorted order.
+ * @param iter The iterator.
+ * @return Pointer to the next item (which lives inside the array), or NULL if all the items have been returned.
+ */
+const void *sort_iter_next(SortIter *iter);
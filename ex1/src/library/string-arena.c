@@ -0,0 +1,95 @@
+#include <malloc.h>
+#include <string.h>
+#include <stdlib.h>
+#include "string-arena.h"
+#include "assert_util.h"
+
+/*---------------------------------------------------------------------------------------------------------------*/
+
+void new_string_arena(StringArena **arena, size_t capacity) {
+  ASSERT_NULL_PARAMETER(arena, new_string_arena);
+  ASSERT(capacity > 0, "The capacity of the arena must be > 0", new_string_arena);
+
+  *arena = (StringArena *) malloc(sizeof(StringArena));
+  ASSERT(*arena, "Unable to allocate memory for the string arena", new_string_arena);
+
+  (*arena)->bytes = (char *) malloc(capacity);
+  ASSERT((*arena)->bytes, "Unable to allocate memory for the strings of the arena", new_string_arena);
+
+  (*arena)->length = 0;
+  (*arena)->capacity = capacity;
+}
+
+/*---------------------------------------------------------------------------------------------------------------*/
+
+void clear_string_arena(StringArena **arena) {
+  ASSERT_NULL_PARAMETER(arena, clear_string_arena);
+  ASSERT_NULL_PARAMETER(*arena, clear_string_arena);
+
+  free((*arena)->bytes);
+  free(*arena);
+  *arena = NULL;
+}
+
+/*---------------------------------------------------------------------------------------------------------------*/
+
+void store_arena_string(StringArena *arena, const char *string, size_t length, StringHandle *handle) {
+  size_t prefix_length;
+
+  ASSERT_NULL_PARAMETER(arena, store_arena_string);
+  ASSERT(string || !length, "'string' parameter is NULL", store_arena_string);
+  ASSERT_NULL_PARAMETER(handle, store_arena_string);
+  ASSERT(length <= UINT32_MAX, "The string is too long to be stored in the arena", store_arena_string);
+
+  while (arena->capacity - arena->length < length) {
+    arena->capacity *= 2;
+    arena->bytes = (char *) realloc(arena->bytes, arena->capacity);
+    ASSERT(arena->bytes, "Unable to allocate memory for the strings of the arena", store_arena_string);
+  }
+
+  // The prefix is padded with null bytes, which are ordered before any character of a longer string.
+  prefix_length = length < STRING_HANDLE_PREFIX_LEN ? length : STRING_HANDLE_PREFIX_LEN;
+  memset(handle->prefix, 0, STRING_HANDLE_PREFIX_LEN);
+  memcpy(handle->prefix, string, prefix_length);
+
+  handle->length = (uint32_t) length;
+  handle->offset = (uint64_t) arena->length;
+
+  memcpy(arena->bytes + arena->length, string, length);
+  arena->length += length;
+}
+
+/*---------------------------------------------------------------------------------------------------------------*/
+
+const char *get_arena_string(const StringArena *arena, const StringHandle *handle) {
+  ASSERT_NULL_PARAMETER(arena, get_arena_string);
+  ASSERT_NULL_PARAMETER(handle, get_arena_string);
+
+  return arena->bytes + handle->offset;
+}
+
+/*---------------------------------------------------------------------------------------------------------------*/
+
+int compare_arena_strings(const StringArena *arena, const StringHandle *handle_a, const StringHandle *handle_b) {
+  uint32_t min_length;
+  int result;
+
+  result = memcmp(handle_a->prefix, handle_b->prefix, STRING_HANDLE_PREFIX_LEN);
+
+  if (result)
+    return result;
+
+  min_length = handle_a->length < handle_b->length ? handle_a->length : handle_b->length;
+
+  // Only the bytes after the (equal) prefixes are read from the arena.
+  if (min_length > STRING_HANDLE_PREFIX_LEN) {
+    result = memcmp(arena->bytes + handle_a->offset + STRING_HANDLE_PREFIX_LEN,
+                    arena->bytes + handle_b->offset + STRING_HANDLE_PREFIX_LEN, min_length - STRING_HANDLE_PREFIX_LEN);
+
+    if (result)
+      return result;
+  }
+
+  // One string is a prefix of the other one, which is greater if it is longer.
+  return (handle_a->length > handle_b->length) - (handle_a->length < handle_b->length);
+}
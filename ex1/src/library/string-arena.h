@@ -0,0 +1,82 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifndef STRING_HANDLE_PREFIX_LEN
+/**
+ * @brief The number of leading bytes of a string stored inline in its handle.
+ *
+ * @remark This number can be changed by setting this macro before including this header file.
+ */
+#define STRING_HANDLE_PREFIX_LEN 4
+#endif
+
+/**
+ * @brief Represents a string of arbitrary length stored in a string arena.
+ *
+ * @remark The first bytes of the string are copied into the handle (padded with null bytes), so two strings which
+ * differ within their prefix are compared without reading the arena.
+ */
+typedef struct StringHandle {
+  uint32_t length;  ///< The length of the string, in bytes.
+  unsigned char prefix[STRING_HANDLE_PREFIX_LEN];  ///< The first bytes of the string, padded with null bytes.
+  uint64_t offset;  ///< The offset of the string in the arena.
+} StringHandle;
+
+/**
+ * @brief Represents a bump-allocated arena of strings: the strings are appended one after the other to a single
+ * buffer, which doubles its capacity when it is full, and are only released all together.
+ *
+ * @remark The strings are referenced by their offset rather than by a pointer, so the handles stay valid when the
+ * buffer grows. The strings are not null-terminated.
+ */
+typedef struct StringArena {
+  char *bytes;  ///< The buffer holding the strings.
+  size_t length;  ///< Number of bytes used by the strings.
+  size_t capacity;  ///< Number of bytes that the buffer can hold before growing.
+} StringArena;
+
+/**
+ * @brief Allocates an empty arena able to hold the specified number of bytes before growing.
+ * @param arena Pointer to the pointer that will hold the arena.
+ * @param capacity Initial number of bytes that the arena can hold (> 0).
+ */
+void new_string_arena(StringArena **arena, size_t capacity);
+
+/**
+ * @brief Deallocates the specified arena, and all its strings.
+ * @param arena Pointer to the arena to be cleared.
+ */
+void clear_string_arena(StringArena **arena);
+
+/**
+ * @brief Appends a copy of a string to the arena.
+ * @param arena The arena.
+ * @param string The string (which does not need to be null-terminated, but must not contain null bytes).
+ * @param length The length of the string, in bytes (less than 4 GiB).
+ * @param handle The destination handle of the stored string.
+ */
+void store_arena_string(StringArena *arena, const char *string, size_t length, StringHandle *handle);
+
+/**
+ * @brief Returns the stored string referenced by a handle (which is not null-terminated).
+ * @param arena The arena holding the string.
+ * @param handle The handle of the string.
+ * @return A pointer to the first of the @c handle->length bytes of the string, valid until the arena grows.
+ */
+const char *get_arena_string(const StringArena *arena, const StringHandle *handle);
+
+/**
+ * @brief Compares two strings stored in an arena, in the order of @c strcmp.
+ *
+ * @remark The inline prefixes are compared first, so the arena is only read when they are equal and both strings
+ * are longer than the prefix.
+ *
+ * @param arena The arena holding both strings.
+ * @param handle_a The handle of the first string.
+ * @param handle_b The handle of the second string.
+ * @return A negative number, zero or a positive number if the first string is respectively less than, equal to or
+ * greater than the second one.
+ */
+int compare_arena_strings(const StringArena *arena, const StringHandle *handle_a, const StringHandle *handle_b);
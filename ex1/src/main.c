@@ -1,6 +1,14 @@
+#define _POSIX_C_SOURCE 200809L
+
 #include <stdlib.h>
 #include <string.h>
+#include <sys/stat.h>
 #include "records-sorter.h"
+#include "records-external.h"
+#include "records-verifier.h"
+#include "records-join.h"
+#include "records-schema.h"
+#include "records-shards.h"
 #include "assert_util.h"
 
 /*---------------------------------------------------------------------------------------------------------------*/
@@ -14,20 +22,104 @@ enum Args {
   ARG_NUM_ARGS
 };
 
+// PURPOSE: Defines constants for indexing argv in verify mode ("main_ex1 verify <in_file> <sorted_file> <field>").
+enum VerifyArgs {
+  VERIFY_ARG_MODE = 1,
+  VERIFY_ARG_IN_FILE_PATH,
+  VERIFY_ARG_SORTED_FILE_PATH,
+  VERIFY_ARG_SORTING_FIELD,
+  VERIFY_ARG_NUM_ARGS
+};
+
+// PURPOSE: Defines constants for indexing argv in join mode
+//          ("main_ex1 join <kind> <left_file> <right_file> <out_file> <threshold> <field>").
+enum JoinArgs {
+  JOIN_ARG_MODE = 1,
+  JOIN_ARG_KIND,
+  JOIN_ARG_LEFT_FILE_PATH,
+  JOIN_ARG_RIGHT_FILE_PATH,
+  JOIN_ARG_OUT_FILE_PATH,
+  JOIN_ARG_SORTING_THRESHOLD,
+  JOIN_ARG_SORTING_FIELD,
+  JOIN_ARG_NUM_ARGS
+};
+
+// PURPOSE: Defines constants for indexing argv in schema mode
+//          ("main_ex1 schema <schema|header> <in_file> <out_file> <threshold> <key_column>").
+enum SchemaArgs {
+  SCHEMA_ARG_MODE = 1,
+  SCHEMA_ARG_SCHEMA,
+  SCHEMA_ARG_IN_FILE_PATH,
+  SCHEMA_ARG_OUT_FILE_PATH,
+  SCHEMA_ARG_SORTING_THRESHOLD,
+  SCHEMA_ARG_KEY_COLUMN,
+  SCHEMA_ARG_NUM_ARGS
+};
+
+// PURPOSE: The first argument which selects the verify mode.
+#define VERIFY_MODE "verify"
+
+// PURPOSE: The first argument which selects the join mode.
+#define JOIN_MODE "join"
+
+// PURPOSE: The first argument which selects the schema mode.
+#define SCHEMA_MODE "schema"
+
+// PURPOSE: The max number of fields which can be sorted by a single invocation.
+#define MAX_FIELD_COUNT 16
+
+// PURPOSE: The suffix appended to the input file path to obtain the default path of the records cache.
+#define CACHE_PATH_SUFFIX ".cache"
+
+// PURPOSE: The path which denotes the standard input (as input file path) or the standard output (as output file path).
+#define STD_STREAM_PATH "-"
+
+/*---------------------------------------------------------------------------------------------------------------*/
+
+// PURPOSE: Returns 1 if two file statuses refer to the same file, 0 otherwise.
+static int is_same_file(const struct stat *stat_a, const struct stat *stat_b) {
+  return stat_a->st_dev == stat_b->st_dev && stat_a->st_ino == stat_b->st_ino;
+}
+
+/*---------------------------------------------------------------------------------------------------------------*/
+
+// PURPOSE: Checks that the sorted file to append to is neither the input file nor the output file, before the output
+//          file is opened (and truncated).
+// NOTE: Different paths (e.g. "sorted.csv" and "./sorted.csv") may name the same file, so the files are compared by
+//       their device and inode numbers. The output file may not exist yet.
+static void check_append_file(const char *append_path, FILE *in_file, const char *out_path) {
+  struct stat append_stat, other_stat;
+
+  ASSERT(!stat(append_path, &append_stat), "Unable to get the status of the sorted file to append to",
+         check_append_file);
+
+  ASSERT(!fstat(fileno(in_file), &other_stat), "Unable to get the status of the input file", check_append_file);
+  ASSERT(!is_same_file(&append_stat, &other_stat), "The sorted file to append to is the input file.\n",
+         check_append_file);
+
+  if (!stat(out_path, &other_stat))
+    ASSERT(!is_same_file(&append_stat, &other_stat), "The sorted file to append to is the output file.\n",
+           check_append_file);
+}
+
 /*---------------------------------------------------------------------------------------------------------------*/
 
 // PURPOSE: Performs the processing of the input file, reading and sorting the specified field, and saving the result
 //          in the specified file.
-static void process_file(const char *in_path, const char *out_path, size_t sorting_threshold, FieldId field_id) {
+static void process_file(const char *in_path, const char *out_path, size_t sorting_threshold, FieldId field_id,
+                         const SortOptions *options) {
   FILE *in_file, *out_file;
 
-  in_file = fopen(in_path, "r");
+  in_file = strcmp(in_path, STD_STREAM_PATH) ? fopen(in_path, "r") : stdin;
   ASSERT(in_file, "Unable to open the input file", process_file);
 
-  out_file = fopen(out_path, "w");
+  if (options->append_path)
+    check_append_file(options->append_path, in_file, out_path);
+
+  out_file = strcmp(out_path, STD_STREAM_PATH) ? fopen(out_path, options->index_kind ? "wb" : "w") : stdout;
   ASSERT(out_file, "Unable to open the output file", process_file);
 
-  sort_records(in_file, out_file, sorting_threshold, field_id);
+  sort_records_with_options(in_file, out_file, sorting_threshold, field_id, options);
 
   ASSERT(!fclose(out_file), "Unable to close the output file", process_file);
   ASSERT(!fclose(in_file), "Unable to close the input file", process_file);
@@ -35,16 +127,384 @@ static void process_file(const char *in_path, const char *out_path, size_t sorti
 
 /*---------------------------------------------------------------------------------------------------------------*/
 
+// PURPOSE: Performs the processing of the input file, reading it once and sorting each one of the specified fields,
+//          saving each result in its own file.
+static void process_file_fields(const char *in_path, char *const *out_paths, const FieldId *field_ids,
+                                size_t field_count, size_t sorting_threshold, const SortOptions *options) {
+  FILE *in_file, *out_files[MAX_FIELD_COUNT];
+  struct stat out_stats[MAX_FIELD_COUNT];
+  size_t i, j;
+
+  in_file = fopen(in_path, "r");
+  ASSERT(in_file, "Unable to open the input file", process_file_fields);
+
+  for (i = 0; i < field_count; ++i) {
+    out_files[i] = fopen(out_paths[i], "w");
+    ASSERT(out_files[i], "Unable to open an output file", process_file_fields);
+    ASSERT(!fstat(fileno(out_files[i]), &out_stats[i]), "Unable to get the status of an output file",
+           process_file_fields);
+
+    // Different paths may still name the same file, which would be written concurrently by two fields.
+    for (j = 0; j < i; ++j)
+      ASSERT(!is_same_file(&out_stats[i], &out_stats[j]), "Two output file paths refer to the same file.\n",
+             process_file_fields);
+  }
+
+  sort_records_by_fields(in_file, out_files, field_ids, field_count, sorting_threshold, options);
+
+  for (i = 0; i < field_count; ++i)
+    ASSERT(!fclose(out_files[i]), "Unable to close an output file", process_file_fields);
+
+  ASSERT(!fclose(in_file), "Unable to close the input file", process_file_fields);
+}
+
+/*---------------------------------------------------------------------------------------------------------------*/
+
+// PURPOSE: Performs the processing of the input file, reading and sorting the specified field, and saving the result
+//          in range-partitioned shard files (whose paths are built from the output file path).
+static void process_file_shards(const char *in_path, const char *out_path, size_t sorting_threshold,
+                                FieldId field_id, const SortOptions *options) {
+  FILE *in_file;
+
+  in_file = strcmp(in_path, STD_STREAM_PATH) ? fopen(in_path, "r") : stdin;
+  ASSERT(in_file, "Unable to open the input file", process_file_shards);
+
+  sort_records_sharded(in_file, out_path, sorting_threshold, field_id, options);
+
+  ASSERT(!fclose(in_file), "Unable to close the input file", process_file_shards);
+}
+
+/*---------------------------------------------------------------------------------------------------------------*/
+
+// PURPOSE: Splits a comma-separated list in place, and returns the number of its items.
+static size_t split_list(char *list, char **items) {
+  size_t count;
+  char *item;
+
+  count = 0;
+
+  for (item = strtok(list, ","); item; item = strtok(NULL, ",")) {
+    ASSERT(count < MAX_FIELD_COUNT, "Too many fields to be sorted.", split_list);
+    items[count++] = item;
+  }
+
+  return count;
+}
+
+/*---------------------------------------------------------------------------------------------------------------*/
+
 // PURPOSE: Tests the string representation of the field type.
 #define TEST_STR_FIELD_ID(value, str) (!strcmp("FIELD_" value, str) || !strcmp(value, str))
 
+// PURPOSE: Parses a field id, from either its number or its name.
+static FieldId parse_field_id(const char *str) {
+  int field_id;
+
+  if (sscanf(str, "%d", &field_id) == 1) return (FieldId) field_id; // NOLINT(*-err34-c)
+  if (TEST_STR_FIELD_ID("STRING", str)) return FIELD_STRING;
+  if (TEST_STR_FIELD_ID("INTEGER", str)) return FIELD_INTEGER;
+  if (TEST_STR_FIELD_ID("FLOAT", str)) return FIELD_FLOAT;
+
+  fprintf(stderr, "RUNTIME_ERROR(main): The field id to sort has not been specified correctly.\n");
+  abort();
+}
+
+/*---------------------------------------------------------------------------------------------------------------*/
+
+// PURPOSE: Builds the default path of the records cache, placed next to the input file.
+static char *make_cache_path(const char *in_path) {
+  char *cache_path;
+
+  cache_path = (char *) malloc(strlen(in_path) + sizeof(CACHE_PATH_SUFFIX));
+  ASSERT(cache_path, "Unable to allocate memory for the cache path", make_cache_path);
+
+  strcpy(cache_path, in_path);
+  strcat(cache_path, CACHE_PATH_SUFFIX);
+  return cache_path;
+}
+
+/*---------------------------------------------------------------------------------------------------------------*/
+
+// PURPOSE: Parses the optional flags which follow the mandatory arguments.
+// NOTE: The returned pointer and the filter (if not NULL) must be freed once the options are no longer used.
+static char *parse_options(int argc, char *argv[], int first_option, const char *in_path, SortOptions *options,
+                           RecordFilter **filter) {
+  char *owned_path;
+  int i;
+
+  owned_path = NULL;
+  *filter = NULL;
+  init_sort_options(options);
+
+  for (i = first_option; i < argc; ++i) {
+    if (!strcmp(argv[i], "--cache")) {
+      free(owned_path);
+      owned_path = make_cache_path(in_path);
+      options->cache_path = owned_path;
+    } else if (!strncmp(argv[i], "--cache=", strlen("--cache="))) {
+      options->cache_path = argv[i] + strlen("--cache=");
+    } else if (!strcmp(argv[i], "--soa")) {
+      options->layout = LAYOUT_STRUCT_OF_ARRAYS;
+    } else if (!strcmp(argv[i], "--arena")) {
+      options->layout = LAYOUT_STRING_ARENA;
+    } else if (!strcmp(argv[i], "--pipelined")) {
+      options->pipelined = 1;
+    } else if (!strncmp(argv[i], "--shards=", strlen("--shards="))) {
+      ASSERT(sscanf(argv[i] + strlen("--shards="), "%zu", &options->shard_count) == 1, // NOLINT(*-err34-c)
+             "The number of shards has not been specified correctly.", main);
+      ASSERT(options->shard_count > 0, "The number of shards must be > 0.", main);
+    } else if (!strcmp(argv[i], "--engine=merge")) {
+      options->engine = SORT_ENGINE_MERGE_BINARY_INSERTION;
+    } else if (!strcmp(argv[i], "--engine=sample")) {
+      options->engine = SORT_ENGINE_PARALLEL_SAMPLE;
+    } else if (!strcmp(argv[i], "--engine=multiway")) {
+      options->engine = SORT_ENGINE_MULTIWAY_MERGE;
+    } else if (!strcmp(argv[i], "--engine=pdq")) {
+      options->engine = SORT_ENGINE_PDQ;
+    } else if (!strcmp(argv[i], "--aggregate")) {
+      options->aggregate = 1;
+    } else if (!strncmp(argv[i], "--append=", strlen("--append="))) {
+      options->append_path = argv[i] + strlen("--append=");
+    } else if (!strcmp(argv[i], "--two-pass")) {
+      options->two_pass = 1;
+    } else if (!strncmp(argv[i], "--threads=", strlen("--threads="))) {
+      ASSERT(sscanf(argv[i] + strlen("--threads="), "%zu", &options->thread_count) == 1, // NOLINT(*-err34-c)
+             "The number of threads has not been specified correctly.", main);
+    } else if (!strncmp(argv[i], "--memory=", strlen("--memory="))) {
+      ASSERT(sscanf(argv[i] + strlen("--memory="), "%zu", &options->memory_budget) == 1, // NOLINT(*-err34-c)
+             "The memory budget (in MiB) has not been specified correctly.", main);
+      ASSERT(options->memory_budget > 0, "The memory budget (in MiB) must be > 0.", main);
+      options->memory_budget <<= 20;
+    } else if (!strcmp(argv[i], "--writer=fwrite")) {
+      options->writer_backend = RECORD_WRITER_STDIO;
+      options->report_bandwidth = 1;
+    } else if (!strcmp(argv[i], "--writer=pwrite")) {
+      options->writer_backend = RECORD_WRITER_PWRITE;
+      options->report_bandwidth = 1;
+    } else if (!strcmp(argv[i], "--writer=io_uring")) {
+      options->writer_backend = RECORD_WRITER_IO_URING;
+      options->report_bandwidth = 1;
+    } else if (!strcmp(argv[i], "--index=ids")) {
+      options->index_kind = RECORD_INDEX_IDS;
+    } else if (!strcmp(argv[i], "--index=offsets")) {
+      options->index_kind = RECORD_INDEX_OFFSETS;
+    } else if (!strncmp(argv[i], "--filter=", strlen("--filter="))) {
+      if (!*filter)
+        new_record_filter(filter);
+
+      // The predicates of several filters must all be satisfied.
+      if (!add_record_filter(*filter, argv[i] + strlen("--filter="))) {
+        fprintf(stderr, "RUNTIME_ERROR(main): Invalid filter '%s'.\n", argv[i] + strlen("--filter="));
+        abort();
+      }
+
+      options->filter = *filter;
+    } else {
+      fprintf(stderr, "RUNTIME_ERROR(main): Unknown option '%s'.\n", argv[i]);
+      abort();
+    }
+  }
+
+  return owned_path;
+}
+
+/*---------------------------------------------------------------------------------------------------------------*/
+
+// PURPOSE: Verifies that a sorted file holds the records of an input file, sorted by the specified field.
+// NOTE: Only the filters and the number of threads are used among the options.
+static int verify_main(int argc, char *argv[]) {
+  FILE *in_file, *sorted_file;
+  SortOptions options;
+  RecordFilter *filter;
+  char *owned_path;
+  int valid;
+
+  ASSERT(argc >= VERIFY_ARG_NUM_ARGS, "Wrong number of arguments passed (verify <in_file> <sorted_file> <field>)",
+         verify_main);
+
+  owned_path = parse_options(argc, argv, VERIFY_ARG_NUM_ARGS, argv[VERIFY_ARG_IN_FILE_PATH], &options, &filter);
+
+  in_file = fopen(argv[VERIFY_ARG_IN_FILE_PATH], "r");
+  ASSERT(in_file, "Unable to open the input file", verify_main);
+
+  sorted_file = fopen(argv[VERIFY_ARG_SORTED_FILE_PATH], "r");
+  ASSERT(sorted_file, "Unable to open the sorted file", verify_main);
+
+  valid = verify_sorted_records(in_file, sorted_file, parse_field_id(argv[VERIFY_ARG_SORTING_FIELD]), &options);
+
+  fclose(sorted_file);
+  fclose(in_file);
+  free(owned_path);
+
+  if (filter)
+    clear_record_filter(&filter);
+
+  return valid ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+/*---------------------------------------------------------------------------------------------------------------*/
+
+// PURPOSE: Parses the kind of a join, from its name.
+static JoinKind parse_join_kind(const char *str) {
+  if (!strcmp(str, "inner")) return JOIN_INNER;
+  if (!strcmp(str, "left")) return JOIN_LEFT;
+  if (!strcmp(str, "anti")) return JOIN_ANTI;
+
+  fprintf(stderr, "RUNTIME_ERROR(main): The kind of join (inner, left or anti) has not been specified correctly.\n");
+  abort();
+}
+
+/*---------------------------------------------------------------------------------------------------------------*/
+
+// PURPOSE: Joins two record files on the specified field, sorting them first if they are not sorted.
+// NOTE: The options are the ones of the sorter, which is used for the inputs which are not sorted.
+static int join_main(int argc, char *argv[]) {
+  FILE *left_file, *right_file, *out_file;
+  size_t sorting_threshold;
+  SortOptions options;
+  RecordFilter *filter;
+  char *owned_path;
+  JoinKind kind;
+
+  ASSERT(argc >= JOIN_ARG_NUM_ARGS,
+         "Wrong number of arguments passed (join <kind> <left_file> <right_file> <out_file> <threshold> <field>)",
+         join_main);
+
+  kind = parse_join_kind(argv[JOIN_ARG_KIND]);
+  ASSERT(sscanf(argv[JOIN_ARG_SORTING_THRESHOLD], "%zu", &sorting_threshold) == 1, // NOLINT(*-err34-c)
+         "The sorting threshold has not been specified correctly.", join_main);
+
+  owned_path = parse_options(argc, argv, JOIN_ARG_NUM_ARGS, argv[JOIN_ARG_LEFT_FILE_PATH], &options, &filter);
+
+  ASSERT(!options.aggregate && !options.two_pass && !options.index_kind && !options.shard_count &&
+         options.layout != LAYOUT_STRING_ARENA,
+         "The joined records cannot be aggregated, sorted in two passes, indexed, sharded or stored in a string "
+         "arena.\n", join_main);
+
+  left_file = fopen(argv[JOIN_ARG_LEFT_FILE_PATH], "r");
+  ASSERT(left_file, "Unable to open the left file", join_main);
+
+  right_file = fopen(argv[JOIN_ARG_RIGHT_FILE_PATH], "r");
+  ASSERT(right_file, "Unable to open the right file", join_main);
+
+  out_file = strcmp(argv[JOIN_ARG_OUT_FILE_PATH], STD_STREAM_PATH) ? fopen(argv[JOIN_ARG_OUT_FILE_PATH], "w") : stdout;
+  ASSERT(out_file, "Unable to open the output file", join_main);
+
+  join_records(left_file, right_file, out_file, sorting_threshold, parse_field_id(argv[JOIN_ARG_SORTING_FIELD]), kind,
+               &options);
+
+  ASSERT(!fclose(out_file), "Unable to close the output file", join_main);
+  fclose(right_file);
+  fclose(left_file);
+  free(owned_path);
+
+  if (filter)
+    clear_record_filter(&filter);
+
+  return EXIT_SUCCESS;
+}
+
+/*---------------------------------------------------------------------------------------------------------------*/
+
+// PURPOSE: Sorts a record file whose columns are described by a schema, given as a list of columns or read from the
+//          header row of the file.
+// NOTE: Only the engine, the number of threads and the writer backend are used among the options.
+static int schema_main(int argc, char *argv[]) {
+  const char *in_path, *out_path;
+  FILE *in_file, *out_file;
+  size_t sorting_threshold;
+  SortOptions options;
+  RecordFilter *filter;
+  char *owned_path;
+
+  ASSERT(argc >= SCHEMA_ARG_NUM_ARGS,
+         "Wrong number of arguments passed (schema <schema|header> <in_file> <out_file> <threshold> <key_column>)",
+         schema_main);
+
+  in_path = argv[SCHEMA_ARG_IN_FILE_PATH];
+  out_path = argv[SCHEMA_ARG_OUT_FILE_PATH];
+
+  ASSERT(strcmp(in_path, out_path) || !strcmp(in_path, STD_STREAM_PATH),
+         "The two specified file paths refers to the same file.\n", schema_main);
+  ASSERT(sscanf(argv[SCHEMA_ARG_SORTING_THRESHOLD], "%zu", &sorting_threshold) == 1, // NOLINT(*-err34-c)
+         "The sorting threshold has not been specified correctly.", schema_main);
+
+  owned_path = parse_options(argc, argv, SCHEMA_ARG_NUM_ARGS, in_path, &options, &filter);
+
+  ASSERT(!options.cache_path && !filter && !options.aggregate && !options.append_path && !options.two_pass &&
+         !options.index_kind && !options.shard_count && !options.memory_budget &&
+         options.layout == LAYOUT_ARRAY_OF_STRUCTS,
+         "The records of a schema cannot be cached, filtered, aggregated, appended, sorted in two passes, within a "
+         "memory budget or with another layout, indexed or sharded.\n", schema_main);
+
+  in_file = strcmp(in_path, STD_STREAM_PATH) ? fopen(in_path, "r") : stdin;
+  ASSERT(in_file, "Unable to open the input file", schema_main);
+
+  out_file = strcmp(out_path, STD_STREAM_PATH) ? fopen(out_path, "w") : stdout;
+  ASSERT(out_file, "Unable to open the output file", schema_main);
+
+  sort_records_with_schema(in_file, out_file, sorting_threshold, argv[SCHEMA_ARG_SCHEMA],
+                           argv[SCHEMA_ARG_KEY_COLUMN], &options);
+
+  ASSERT(!fclose(out_file), "Unable to close the output file", schema_main);
+  fclose(in_file);
+  free(owned_path);
+
+  return EXIT_SUCCESS;
+}
+
+/*---------------------------------------------------------------------------------------------------------------*/
+
 // PURPOSE: Entry point.
+// NOTE: Several fields can be sorted by a single invocation, passing comma-separated lists of output file paths and
+//       field ids (e.g. "out_string.csv,out_int.csv STRING,INTEGER"): the input file is parsed only once.
+//       A single field can be sorted from the standard input to the standard output, passing "-" as file paths
+//       (e.g. "zcat records.csv.gz | main_ex1 - - 50 INTEGER | upload"), with a bounded memory budget (--memory=MiB).
+//       The sorted records are written in background by the selected backend (--writer=fwrite|pwrite|io_uring),
+//       which also reports the achieved write bandwidth.
+//       With --engine=sample, the records are sorted by the parallel sample sort (on --threads=N threads, or one
+//       thread per processor) instead of the merge binary insertion sort, and with --engine=multiway by the
+//       cache-aware multiway merge sort. With --engine=pdq, they are sorted in place by the pattern-defeating
+//       quicksort, which is faster when the order of the records with equal keys does not matter (it is not stable).
+//       With --arena, the string fields are stored in a string arena, so they are not truncated to 31 bytes and the
+//       sorted records are smaller.
+//       With --two-pass, only the keys and the spans of the lines are kept in memory, and the lines of the input
+//       file are copied as they are into the output file.
+//       With --shards=N, the records are written into N shard files (out_file.0, ..., out_file.N-1) with
+//       non-overlapping key ranges, described by a manifest (out_file.manifest).
+//       With --aggregate, the records with equal keys are collapsed into one row per distinct key while they are written
+//       ("key,count,sum of int_field,mean of float_field").
+//       With --append=sorted_file, only the input records are sorted, then merged with the records of sorted_file
+//       (already sorted by the same field) into the output file, in a single sequential pass.
+//       With --index=ids or --index=offsets, a binary index of the sorted ids or line offsets is written instead.
+//       Only the records matching the filters (e.g. --filter=int_field>=100 --filter=string_field^=abc) are sorted.
+//       A sorted file can be verified against its input file with "main_ex1 verify <in_file> <sorted_file> <field>",
+//       which exits with a failure status if it is not sorted or it does not hold the same records.
+//       Two record files can be joined on a field with
+//       "main_ex1 join <inner|left|anti> <left_file> <right_file> <out_file> <threshold> <field>": the files which
+//       are not sorted by the field are sorted first (within the --memory budget), then both are merge-joined.
+//       A record file with other columns can be sorted with
+//       "main_ex1 schema <schema|header> <in_file> <out_file> <threshold> <key_column>", where the schema lists the
+//       columns (e.g. "id:int,name:string:24,score:float") or is read from the header row of the file, and the key
+//       column is given by name or index.
 int main(int argc, char *argv[]) {
   const char *in_file_path;
-  const char *out_file_path;
-  size_t sorting_threshold;
-  FieldId sorting_field_id;
-  char sorting_field_id_str[16];
+  char *out_file_paths[MAX_FIELD_COUNT];
+  char *field_id_strs[MAX_FIELD_COUNT];
+  FieldId field_ids[MAX_FIELD_COUNT];
+  size_t sorting_threshold, out_count, field_count, i, j;
+  SortOptions options;
+  RecordFilter *filter;
+  char *owned_path;
+
+  if (argc > VERIFY_ARG_MODE && !strcmp(argv[VERIFY_ARG_MODE], VERIFY_MODE))
+    return verify_main(argc, argv);
+
+  if (argc > JOIN_ARG_MODE && !strcmp(argv[JOIN_ARG_MODE], JOIN_MODE))
+    return join_main(argc, argv);
+
+  if (argc > SCHEMA_ARG_MODE && !strcmp(argv[SCHEMA_ARG_MODE], SCHEMA_MODE))
+    return schema_main(argc, argv);
 
   ASSERT(argc >= ARG_OUT_FILE_PATH, "Wrong number of arguments passed (input file path not found)", main);
   ASSERT(argc >= ARG_SORTING_THRESHOLD, "Wrong number of arguments passed (output file path not found)", main);
@@ -52,25 +512,81 @@ int main(int argc, char *argv[]) {
   ASSERT(argc >= ARG_NUM_ARGS, "Wrong number of arguments passed (field id not found)", main);
 
   in_file_path = argv[ARG_IN_FILE_PATH];
-  out_file_path = argv[ARG_OUT_FILE_PATH];
+  out_count = split_list(argv[ARG_OUT_FILE_PATH], out_file_paths);
+  field_count = split_list(argv[ARG_SORTING_FIELD], field_id_strs);
 
-  ASSERT(strcmp(in_file_path, out_file_path), "The two specified file paths refers to the same file.\n", main);
-  ASSERT(sscanf(argv[ARG_SORTING_THRESHOLD], "%zu", &sorting_threshold) == 1, "The sorting threshold has not been specified correctly.", main); // NOLINT(*-err34-c)
+  ASSERT(out_count > 0 && out_count == field_count, "The number of output file paths and field ids must match.\n",
+         main);
+  ASSERT(field_count == 1 || (strcmp(in_file_path, STD_STREAM_PATH) && strcmp(out_file_paths[0], STD_STREAM_PATH)),
+         "The standard streams can only be used when sorting a single field.\n", main);
 
-  if (sscanf(argv[ARG_SORTING_FIELD], "%d", (int *) &sorting_field_id) != 1) { // NOLINT(*-err34-c)
-    if (sscanf(argv[ARG_SORTING_FIELD], "%s", sorting_field_id_str) == 1) {
-      if (TEST_STR_FIELD_ID("STRING", sorting_field_id_str)) sorting_field_id = FIELD_STRING;
-      else if (TEST_STR_FIELD_ID("INTEGER", sorting_field_id_str)) sorting_field_id = FIELD_INTEGER;
-      else if (TEST_STR_FIELD_ID("FLOAT", sorting_field_id_str)) sorting_field_id = FIELD_FLOAT;
-      else goto ERROR;
-    } else {
-      ERROR:
-      fprintf(stderr, "RUNTIME_ERROR(main): The field id to sort has not been specified correctly.\n");
-      abort();
-    }
+  for (i = 0; i < field_count; ++i) {
+    ASSERT(strcmp(in_file_path, out_file_paths[i]) || !strcmp(in_file_path, STD_STREAM_PATH),
+           "The two specified file paths refers to the same file.\n", main);
+    ASSERT(i == 0 || strcmp(out_file_paths[i], STD_STREAM_PATH),
+           "The standard streams can only be used when sorting a single field.\n", main);
+
+    for (j = 0; j < i; ++j)
+      ASSERT(strcmp(out_file_paths[i], out_file_paths[j]), "The same output file path is specified twice.\n", main);
+
+    field_ids[i] = parse_field_id(field_id_strs[i]);
   }
 
-  process_file(in_file_path, out_file_path, sorting_threshold, sorting_field_id);
+  ASSERT(sscanf(argv[ARG_SORTING_THRESHOLD], "%zu", &sorting_threshold) == 1, "The sorting threshold has not been specified correctly.", main); // NOLINT(*-err34-c)
+
+  owned_path = parse_options(argc, argv, ARG_NUM_ARGS, in_file_path, &options, &filter);
+
+  ASSERT(!options.index_kind || (field_count == 1 && strcmp(out_file_paths[0], STD_STREAM_PATH) &&
+                                 strcmp(in_file_path, STD_STREAM_PATH)),
+         "An index can only be written for a single field, from and to regular files.\n", main);
+
+  // The shards are loaded whole as an array of structures, so the modes which bound or lay out the records differently
+  // (including the memory budget forced for the standard streams) would be silently ignored.
+  ASSERT(!options.shard_count || (field_count == 1 && strcmp(in_file_path, STD_STREAM_PATH) &&
+                                  strcmp(out_file_paths[0], STD_STREAM_PATH) &&
+                                  options.layout == LAYOUT_ARRAY_OF_STRUCTS && !options.memory_budget &&
+                                  !options.pipelined && !options.two_pass && !options.index_kind),
+         "Shards can only be written for a single field, from and to regular files, in memory as an array of "
+         "structures (without --memory, --pipelined, --soa, --arena, --two-pass or --index).\n", main);
+
+  ASSERT(!options.two_pass || (field_count == 1 && strcmp(in_file_path, STD_STREAM_PATH)),
+         "The two-pass mode can only sort a single field, from a regular file.\n", main);
+
+  ASSERT(!options.aggregate || (!options.two_pass && !options.index_kind && options.layout != LAYOUT_STRING_ARENA),
+         "The records cannot be aggregated in the two-pass mode, into an index, or from a string arena.\n", main);
+
+  // The new records are loaded whole as an array of structures, so the modes which bound or lay out the records
+  // differently (including the memory budget forced for the standard streams) would be silently ignored.
+  ASSERT(!options.append_path || (field_count == 1 && strcmp(in_file_path, STD_STREAM_PATH) &&
+                                  strcmp(out_file_paths[0], STD_STREAM_PATH) && !options.two_pass &&
+                                  !options.index_kind && !options.shard_count && !options.memory_budget &&
+                                  !options.pipelined && options.layout == LAYOUT_ARRAY_OF_STRUCTS),
+         "The records can only be appended for a single field, from and to regular files, in memory as an array of "
+         "structures (without --memory, --pipelined, --soa, --arena, --two-pass, --index or --shards).\n", main);
+
+  // The other modes parse the records into a Record, which would silently truncate the strings of the arena.
+  ASSERT(options.layout != LAYOUT_STRING_ARENA ||
+         (field_count == 1 && strcmp(in_file_path, STD_STREAM_PATH) && strcmp(out_file_paths[0], STD_STREAM_PATH) &&
+          !options.memory_budget && !options.pipelined && !options.append_path && !options.two_pass &&
+          !options.index_kind && !options.shard_count),
+         "The string arena can only sort a single field in memory, from and to regular files (without --memory, "
+         "--pipelined, --append, --two-pass, --index or --shards).\n", main);
+
+  // The standard streams are sorted in streaming mode: the output must not be mixed with the progress messages.
+  if (!options.memory_budget && (!strcmp(in_file_path, STD_STREAM_PATH) || !strcmp(out_file_paths[0], STD_STREAM_PATH)))
+    options.memory_budget = DEFAULT_MEMORY_BUDGET;
+
+  if (options.shard_count)
+    process_file_shards(in_file_path, out_file_paths[0], sorting_threshold, field_ids[0], &options);
+  else if (field_count == 1)
+    process_file(in_file_path, out_file_paths[0], sorting_threshold, field_ids[0], &options);
+  else
+    process_file_fields(in_file_path, out_file_paths, field_ids, field_count, sorting_threshold, &options);
+
+  free(owned_path);
+
+  if (filter)
+    clear_record_filter(&filter);
 
   return EXIT_SUCCESS;
 }
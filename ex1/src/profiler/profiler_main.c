@@ -1,8 +1,36 @@
+#include <string.h>
 #include "assert_util.h"
 #include "records-sorter.h"
+#include "record-reader.h"
+#include "field-parsers.h"
+#include "branchless-merge-sort.h"
 
 #define PROFILER_PRINT(msg) printf("[PROFILER]: " msg "\n")
 
+// PURPOSE: The flag which enables the binary cache of the parsed records, placed next to the input file.
+#define CACHE_FLAG "--cache"
+
+// PURPOSE: The flag which enables the profiling of the structure-of-arrays layout.
+#define SOA_FLAG "--soa"
+
+// PURPOSE: The flag which selects the parallel sample sort as the sorting engine.
+#define SAMPLE_SORT_FLAG "--engine=sample"
+
+// PURPOSE: The flag which selects the cache-aware multiway merge sort as the sorting engine.
+#define MULTIWAY_SORT_FLAG "--engine=multiway"
+
+// PURPOSE: The flag which selects the pattern-defeating quicksort as the sorting engine.
+#define PDQ_SORT_FLAG "--engine=pdq"
+
+// PURPOSE: The flag which enables the profiling of the lazy sort iterator.
+#define ITERATOR_FLAG "--iterator"
+
+// PURPOSE: The flag which enables the benchmark of the record parsers and of the field conversions.
+#define BENCH_LOADER_FLAG "--bench-loader"
+
+// PURPOSE: The flag which enables the benchmark of the branch misses of the branchless merge sort.
+#define BENCH_MERGE_FLAG "--bench-merge"
+
 enum Args {
   ARG_INPUT_FILE_PATH = 1,
   ARG_FIRST_THRESHOLD,
@@ -11,28 +39,64 @@ enum Args {
 
 /*---------------------------------------------------------------------------------------------------------------*/
 
-static void profile_execution(const char *input_file_path, size_t *thresholds, size_t threshold_count) {
-  FILE *input_file;
+// PURPOSE: Profiles the sorting of the specified field for each threshold, using the selected layouts.
+static void profile_field(FieldId field_id, size_t *thresholds, size_t threshold_count, int use_soa,
+                          int use_iterator, SortEngine engine) {
   size_t i;
 
+  for (i = 0; i < threshold_count; ++i)
+    profile_engine__records_sorter(thresholds[i], field_id, engine);
+
+  if (use_iterator) {
+    for (i = 0; i < threshold_count; ++i)
+      profile_iterator__records_sorter(thresholds[i], field_id);
+  }
+
+  if (!use_soa)
+    return;
+
+  for (i = 0; i < threshold_count; ++i)
+    profile_columns__records_sorter(thresholds[i], field_id, engine);
+}
+
+/*---------------------------------------------------------------------------------------------------------------*/
+
+static void profile_execution(const char *input_file_path, size_t *thresholds, size_t threshold_count, int use_cache,
+                              int use_soa, int use_iterator, int bench_loader, SortEngine engine) {
+  FILE *input_file;
+  char *cache_path;
+
   input_file = fopen(input_file_path, "r");
   ASSERT(input_file, "Unable to open the input file", profile_execution);
 
-  init_profiler__records_sorter(input_file);
+  if (bench_loader) {
+    PROFILER_PRINT("Benchmarking record parsers...");
+    profile__record_reader(input_file);
+    profile__field_parsers();
+  }
+
+  cache_path = NULL;
+
+  if (use_cache) {
+    cache_path = (char *) malloc(strlen(input_file_path) + sizeof(".cache"));
+    ASSERT(cache_path, "Unable to allocate memory for the cache path", profile_execution);
+    strcpy(cache_path, input_file_path);
+    strcat(cache_path, ".cache");
+  }
+
+  init_profiler__records_sorter(input_file, cache_path);
+  free(cache_path);
 
   ASSERT(!fclose(input_file), "Unable to close the input file", profile_execution);
 
   PROFILER_PRINT("Processing STRING fields...");
-  for (i = 0; i < threshold_count; ++i)
-    profile__records_sorter(thresholds[i], FIELD_STRING);
+  profile_field(FIELD_STRING, thresholds, threshold_count, use_soa, use_iterator, engine);
 
   PROFILER_PRINT("Processing INTEGER fields...");
-  for (i = 0; i < threshold_count; ++i)
-    profile__records_sorter(thresholds[i], FIELD_INTEGER);
+  profile_field(FIELD_INTEGER, thresholds, threshold_count, use_soa, use_iterator, engine);
 
   PROFILER_PRINT("Processing FLOAT fields...");
-  for (i = 0; i < threshold_count; ++i)
-    profile__records_sorter(thresholds[i], FIELD_FLOAT);
+  profile_field(FIELD_FLOAT, thresholds, threshold_count, use_soa, use_iterator, engine);
 
   shutdown_profiler__records_sorter();
 }
@@ -42,23 +106,76 @@ static void profile_execution(const char *input_file_path, size_t *thresholds, s
 int main(int argc, char *argv[]) {
   const char *input_file_path;
   size_t *thresholds, thresholds_count;
-  size_t i;
+  int use_cache, use_soa, use_iterator, bench_loader, bench_merge;
+  SortEngine engine;
+  int i;
 
   ASSERT(argc >= ARG_FIRST_THRESHOLD, "Wrong number of arguments passed (input file path not found)", main);
   ASSERT(argc >= ARG_MIN_NUM_ARGS, "Wrong number of arguments passed (sorting threshold list not found)", main);
 
   input_file_path = argv[ARG_INPUT_FILE_PATH];
 
-  thresholds_count = (argc - ARG_FIRST_THRESHOLD);
-  thresholds = (size_t *) malloc(sizeof(size_t) * thresholds_count);
+  thresholds_count = 0;
+  thresholds = (size_t *) malloc(sizeof(size_t) * (argc - ARG_FIRST_THRESHOLD));
   ASSERT(thresholds, "Unable to allocate memory for thresholds list", main);
 
-  for (i = ARG_FIRST_THRESHOLD; i < ARG_FIRST_THRESHOLD + thresholds_count; i++) {
-    ASSERT(sscanf(argv[i], "%zu", &thresholds[i - ARG_FIRST_THRESHOLD]), "Unable to parse a sorting threshold", main); // NOLINT(*-err34-c)
-    ASSERT(thresholds[i] >= 0, "A sorting threshold must be greater than or equal to 0", main);
+  use_cache = use_soa = use_iterator = bench_loader = bench_merge = 0;
+  engine = SORT_ENGINE_MERGE_BINARY_INSERTION;
+
+  for (i = ARG_FIRST_THRESHOLD; i < argc; i++) {
+    if (!strcmp(argv[i], CACHE_FLAG)) {
+      use_cache = 1;
+      continue;
+    }
+
+    if (!strcmp(argv[i], SOA_FLAG)) {
+      use_soa = 1;
+      continue;
+    }
+
+    if (!strcmp(argv[i], PDQ_SORT_FLAG)) {
+      engine = SORT_ENGINE_PDQ;
+      continue;
+    }
+
+    if (!strcmp(argv[i], ITERATOR_FLAG)) {
+      use_iterator = 1;
+      continue;
+    }
+
+    if (!strcmp(argv[i], SAMPLE_SORT_FLAG)) {
+      engine = SORT_ENGINE_PARALLEL_SAMPLE;
+      continue;
+    }
+
+    if (!strcmp(argv[i], MULTIWAY_SORT_FLAG)) {
+      engine = SORT_ENGINE_MULTIWAY_MERGE;
+      continue;
+    }
+
+    if (!strcmp(argv[i], BENCH_LOADER_FLAG)) {
+      bench_loader = 1;
+      continue;
+    }
+
+    if (!strcmp(argv[i], BENCH_MERGE_FLAG)) {
+      bench_merge = 1;
+      continue;
+    }
+
+    ASSERT(sscanf(argv[i], "%zu", &thresholds[thresholds_count]) == 1, "Unable to parse a sorting threshold", main); // NOLINT(*-err34-c)
+    thresholds_count++;
+  }
+
+  ASSERT(thresholds_count > 0, "Wrong number of arguments passed (sorting threshold list not found)", main);
+
+  if (bench_merge) {
+    PROFILER_PRINT("Benchmarking merge kernels...");
+    profile__branchless_merge_sort();
   }
 
-  profile_execution(input_file_path, thresholds, thresholds_count);
+  profile_execution(input_file_path, thresholds, thresholds_count, use_cache, use_soa, use_iterator, bench_loader,
+                    engine);
 
   free((void*)thresholds);
 
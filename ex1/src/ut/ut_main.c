@@ -1,5 +1,25 @@
 #include "unity.h"
 #include "merge-binary-insertion-sort.h"
+#include "run-merger.h"
+#include "field-parsers.h"
+#include "csv-scanner.h"
+#include "record-filter.h"
+#include "records-verifier.h"
+#include "record-index.h"
+#include "records-join.h"
+#include "records-sorter.h"
+#include "record-comparator.h"
+#include "counting-sort.h"
+#include "sample-sort.h"
+#include "multiway-merge-sort.h"
+#include "pdq-sort.h"
+#include "branchless-merge-sort.h"
+#include "bitonic-merge.h"
+#include "record-output.h"
+#include "sort-iterator.h"
+#include "record-schema.h"
+#include "string-arena.h"
+#include <string.h>
 #include <time.h>
 #include <stdlib.h>
 
@@ -201,6 +221,906 @@ static void test_string_array_1000000(void) {
 
 /*---------------------------------------------------------------------------------------------------------------*/
 
+// PURPOSE: An integer key paired with its original position, used to check the stability of the sorting.
+typedef struct KeyedItem {
+  int key;
+  size_t position;
+} KeyedItem;
+
+static void stability_test(int size) {
+  KeyedItem *array;
+  size_t i;
+
+  array = malloc(sizeof(KeyedItem) * size);
+
+  for (i = 0; i < size; i++) {
+    array[i].key = rand_int() % 10;
+    array[i].position = i;
+  }
+
+  merge_binary_insertion_sort(array, size, sizeof(KeyedItem), BEST_INT_SORTING_THRESHOLD, int_comparator);
+
+  for (i = 1; i < size; i++) {
+    TEST_ASSERT_TRUE(array[i - 1].key <= array[i].key);
+    if (array[i - 1].key == array[i].key)
+      TEST_ASSERT_TRUE(array[i - 1].position < array[i].position);
+  }
+
+  free(array);
+}
+
+static void test_stability_100(void) {
+  stability_test(100);
+}
+
+static void test_stability_100000(void) {
+  stability_test(100000);
+}
+
+/*---------------------------------------------------------------------------------------------------------------*/
+
+#define RUN_MERGER_RUNS 7
+
+static void run_merger_test(int run_size) {
+  int *array, *merged;
+  void *runs[RUN_MERGER_RUNS];
+  size_t counts[RUN_MERGER_RUNS];
+  RunMerger *merger;
+  const int *item;
+  size_t i, total, count;
+
+  array = malloc(sizeof(int) * run_size * RUN_MERGER_RUNS);
+  merged = malloc(sizeof(int) * run_size * RUN_MERGER_RUNS);
+
+  total = 0;
+
+  // Runs of different lengths (some of them empty).
+  for (i = 0; i < RUN_MERGER_RUNS; i++) {
+    runs[i] = array + i * run_size;
+    counts[i] = run_size - (i % 3) * run_size / 2;
+    total += counts[i];
+  }
+
+  for (i = 0; i < (size_t) run_size * RUN_MERGER_RUNS; i++)
+    array[i] = rand_int();
+
+  for (i = 0; i < RUN_MERGER_RUNS; i++) {
+    if (counts[i] > 0)
+      merge_binary_insertion_sort(runs[i], counts[i], sizeof(int), BEST_INT_SORTING_THRESHOLD, int_comparator);
+  }
+
+  new_run_merger(&merger, runs, counts, RUN_MERGER_RUNS, sizeof(int), int_comparator);
+
+  count = 0;
+  while ((item = next_run_merger(merger)))
+    merged[count++] = *item;
+
+  clear_run_merger(&merger);
+
+  TEST_ASSERT_EQUAL_size_t(total, count);
+  TEST_ASSERT_TRUE(is_array_sorted(merged, count, sizeof(int), int_comparator));
+
+  free(merged);
+  free(array);
+}
+
+static void test_run_merger_1(void) {
+  run_merger_test(1);
+}
+
+static void test_run_merger_1000(void) {
+  run_merger_test(1000);
+}
+
+static void test_run_merger_100000(void) {
+  run_merger_test(100000);
+}
+
+/*---------------------------------------------------------------------------------------------------------------*/
+
+#define PARSE_FIELD(parser, str, value) parser((str), (str) + strlen(str), (value))
+
+static void test_parse_integers(void) {
+  uint64_t u64;
+  int32_t i32;
+
+  TEST_ASSERT_TRUE(PARSE_FIELD(parse_uint64, "0", &u64));
+  TEST_ASSERT_EQUAL_UINT64(0, u64);
+  TEST_ASSERT_TRUE(PARSE_FIELD(parse_uint64, "12345678901234567", &u64));
+  TEST_ASSERT_EQUAL_UINT64(12345678901234567ULL, u64);
+  TEST_ASSERT_TRUE(PARSE_FIELD(parse_uint64, "18446744073709551615", &u64));
+  TEST_ASSERT_EQUAL_UINT64(UINT64_MAX, u64);
+  TEST_ASSERT_FALSE(PARSE_FIELD(parse_uint64, "18446744073709551616", &u64));
+  TEST_ASSERT_FALSE(PARSE_FIELD(parse_uint64, "", &u64));
+  TEST_ASSERT_FALSE(PARSE_FIELD(parse_uint64, "12a", &u64));
+
+  TEST_ASSERT_TRUE(PARSE_FIELD(parse_int32, "-2147483648", &i32));
+  TEST_ASSERT_EQUAL_INT32(INT32_MIN, i32);
+  TEST_ASSERT_TRUE(PARSE_FIELD(parse_int32, "+2147483647", &i32));
+  TEST_ASSERT_EQUAL_INT32(INT32_MAX, i32);
+  TEST_ASSERT_FALSE(PARSE_FIELD(parse_int32, "2147483648", &i32));
+  TEST_ASSERT_FALSE(PARSE_FIELD(parse_int32, "-", &i32));
+}
+
+static void test_parse_floats(void) {
+  const char *fields[] = {"0.000000", "-0.5", "1234.567871", "3.4028235e38", "1e39", "1e-46", "1.17549435e-38",
+                          "1.4e-45", "0.1", "16777217", "123456789012345678901234567890", "inf", "-nan"};
+  char field[32];
+  float expected, parsed;
+  size_t i;
+
+  for (i = 0; i < sizeof(fields) / sizeof(fields[0]); i++) {
+    expected = strtof(fields[i], NULL);
+    TEST_ASSERT_TRUE(PARSE_FIELD(parse_float32, fields[i], &parsed));
+    TEST_ASSERT_EQUAL_MEMORY(&expected, &parsed, sizeof(float));
+  }
+
+  // Random fields, formatted as the ones of the record files.
+  for (i = 0; i < 100000; i++) {
+    sprintf(field, "%f", (float) rand() / (float) (rand() % 1000 + 1));
+    expected = strtof(field, NULL);
+    TEST_ASSERT_TRUE(PARSE_FIELD(parse_float32, field, &parsed));
+    TEST_ASSERT_EQUAL_MEMORY(&expected, &parsed, sizeof(float));
+  }
+
+  TEST_ASSERT_FALSE(PARSE_FIELD(parse_float32, "", &parsed));
+  TEST_ASSERT_FALSE(PARSE_FIELD(parse_float32, "1.2.3", &parsed));
+  TEST_ASSERT_FALSE(PARSE_FIELD(parse_float32, "1e", &parsed));
+}
+
+/*---------------------------------------------------------------------------------------------------------------*/
+
+// PURPOSE: The size of the buffer scanned by the CSV scanner test (several blocks plus a partial one).
+#define CSV_SCANNER_TEST_SIZE (5 * CSV_SCANNER_BLOCK_SIZE + 23)
+
+static void test_csv_scanner(void) {
+  static const size_t edges[] = {0, 15, 16, 31, 32, 47, 48, 63, 64, 127, 128, 191, 255, 256, 319, 320, 342};
+  static const CsvScannerImpl impls[] = {CSV_SCANNER_SCALAR, CSV_SCANNER_SSE2, CSV_SCANNER_AVX2};
+  uint32_t expected[CSV_SCANNER_TEST_SIZE], offsets[CSV_SCANNER_TEST_SIZE];
+  char buffer[CSV_SCANNER_TEST_SIZE];
+  CsvBlockMasks scalar_masks, masks;
+  size_t expected_count, count, length, i, j, k;
+
+  // Records with CRLF line ends, an empty line and a string field longer than 32 bytes, then structurals placed at
+  // the edges of the SIMD lanes and of the blocks, over bytes which are not ASCII.
+  memset(buffer, 0xE9, sizeof(buffer));
+  memcpy(buffer + 64, "1,abc,2,3.5\r\n\n2,abcdefghijklmnopqrstuvwxyz0123456789ABC,4,0.25\r\n,,\n\n",
+         strlen("1,abc,2,3.5\r\n\n2,abcdefghijklmnopqrstuvwxyz0123456789ABC,4,0.25\r\n,,\n\n"));
+
+  for (i = 0; i < sizeof(edges) / sizeof(edges[0]); i++)
+    buffer[edges[i]] = i % 2 ? ',' : '\n';
+
+  for (i = 0; i < sizeof(impls) / sizeof(impls[0]); i++) {
+    if (!is_csv_scanner_supported(impls[i]))
+      continue;
+
+    for (j = 0; j + CSV_SCANNER_BLOCK_SIZE <= sizeof(buffer); j += CSV_SCANNER_BLOCK_SIZE) {
+      scan_csv_block_impl(CSV_SCANNER_SCALAR, buffer + j, &scalar_masks);
+      scan_csv_block_impl(impls[i], buffer + j, &masks);
+      TEST_ASSERT_EQUAL_HEX64(scalar_masks.commas, masks.commas);
+      TEST_ASSERT_EQUAL_HEX64(scalar_masks.newlines, masks.newlines);
+    }
+
+    // Every length covers a different partial last block.
+    for (length = 0; length <= sizeof(buffer); length++) {
+      expected_count = 0;
+
+      for (k = 0; k < length; k++) {
+        if (buffer[k] == ',' || buffer[k] == '\n')
+          expected[expected_count++] = (uint32_t) k;
+      }
+
+      count = scan_csv_structurals_impl(impls[i], buffer, length, offsets);
+      TEST_ASSERT_EQUAL_UINT(expected_count, count);
+
+      if (count)
+        TEST_ASSERT_EQUAL_UINT32_ARRAY(expected, offsets, count);
+    }
+  }
+
+  TEST_ASSERT_TRUE(is_csv_scanner_supported(CSV_SCANNER_SCALAR));
+}
+
+/*---------------------------------------------------------------------------------------------------------------*/
+
+static void test_record_filter(void) {
+  RecordFilter *filter;
+  Record record = {42, "abcdef", -7, 2.5f};
+
+  new_record_filter(&filter);
+  TEST_ASSERT_TRUE(match_record_filter(filter, &record));
+
+  TEST_ASSERT_TRUE(add_record_filter(filter, "int_field>=-10"));
+  TEST_ASSERT_TRUE(add_record_filter(filter, "int_field<0"));
+  TEST_ASSERT_TRUE(add_record_filter(filter, "string_field^=abc"));
+  TEST_ASSERT_TRUE(add_record_filter(filter, "float_field!=1.5"));
+  TEST_ASSERT_TRUE(add_record_filter(filter, "id=42"));
+  TEST_ASSERT_TRUE(match_record_filter(filter, &record));
+
+  record.int_field = 0;
+  TEST_ASSERT_FALSE(match_record_filter(filter, &record));
+
+  record.int_field = -7;
+  strcpy(record.string_field, "abd");
+  TEST_ASSERT_FALSE(match_record_filter(filter, &record));
+
+  TEST_ASSERT_FALSE(add_record_filter(filter, "int_field^=1"));
+  TEST_ASSERT_FALSE(add_record_filter(filter, "unknown=1"));
+  TEST_ASSERT_FALSE(add_record_filter(filter, "int_field~1"));
+  TEST_ASSERT_FALSE(add_record_filter(filter, "float_field<abc"));
+  TEST_ASSERT_EQUAL_size_t(5, filter->count);
+
+  clear_record_filter(&filter);
+}
+
+/*---------------------------------------------------------------------------------------------------------------*/
+
+// PURPOSE: Creates a temporary file holding the specified text.
+static FILE *make_text_file(const char *text) {
+  FILE *file;
+
+  file = tmpfile();
+  TEST_ASSERT_NOT_NULL(file);
+  TEST_ASSERT_EQUAL_size_t(strlen(text), fwrite(text, 1, strlen(text), file));
+  TEST_ASSERT_EQUAL_INT(0, fflush(file));
+  return file;
+}
+
+static void test_summarize_records(void) {
+  FILE *in_file, *sorted_file, *unsorted_file;
+  RecordsSummary in_summary, summary;
+  size_t thread_count;
+
+  in_file = make_text_file("0,c,3,1.5\n1,a,1,0.1234567\n\n2,b,2,-2.25");
+  sorted_file = make_text_file("1,a,1,0.123457\n2,b,2,-2.250000\n0,c,3,1.500000\n");
+  unsorted_file = make_text_file("1,a,1,0.123457\n0,c,3,1.500000\n2,b,2,-2.250000\n");
+
+  // The chunks of many threads split the lines, and some of them are empty.
+  for (thread_count = 1; thread_count <= 64; thread_count *= 4) {
+    summarize_records(in_file, NULL, NULL, thread_count, &in_summary);
+    TEST_ASSERT_EQUAL_size_t(3, in_summary.count);
+    TEST_ASSERT_EQUAL_size_t(0, in_summary.malformed_count);
+
+    summarize_records(sorted_file, get_record_comparator(FIELD_STRING), NULL, thread_count, &summary);
+    TEST_ASSERT_EQUAL_size_t(3, summary.count);
+    TEST_ASSERT_EQUAL_size_t(0, summary.unsorted_count);
+    TEST_ASSERT_TRUE(summary.checksum == in_summary.checksum);
+
+    summarize_records(unsorted_file, get_record_comparator(FIELD_STRING), NULL, thread_count, &summary);
+    TEST_ASSERT_EQUAL_size_t(1, summary.unsorted_count);
+    TEST_ASSERT_TRUE(summary.first_unsorted_offset == strlen("1,a,1,0.123457\n0,c,3,1.500000\n"));
+    TEST_ASSERT_TRUE(summary.checksum == in_summary.checksum);
+
+    summarize_records(unsorted_file, get_record_comparator(FIELD_INTEGER), NULL, thread_count, &summary);
+    TEST_ASSERT_EQUAL_size_t(1, summary.unsorted_count);
+    TEST_ASSERT_TRUE(summary.first_unsorted_offset == strlen("1,a,1,0.123457\n0,c,3,1.500000\n"));
+  }
+
+  fclose(unsorted_file);
+  fclose(sorted_file);
+  fclose(in_file);
+}
+
+/*---------------------------------------------------------------------------------------------------------------*/
+
+// PURPOSE: The path of the index written by the record index test (in the working directory).
+#define UT_INDEX_PATH "ut_record_index.tmp"
+
+static void test_read_indexed_record(void) {
+  static const uint32_t permutation[] = {1, 2, 0};
+  char long_line[LINE_BUFFER_SIZE * 3], expected_string[STRING_FIELD_LEN];
+  uint64_t offsets[3];
+  RecordIndex *index;
+  FILE *record_file, *index_file;
+  Record record;
+
+  // The first line is much longer than LINE_BUFFER_SIZE, and its string field is truncated by the parser.
+  memset(expected_string, 'z', STRING_FIELD_LEN - 1);
+  expected_string[STRING_FIELD_LEN - 1] = '\0';
+  strcpy(long_line, "5,");
+  memset(long_line + 2, 'z', LINE_BUFFER_SIZE * 2);
+  strcpy(long_line + 2 + LINE_BUFFER_SIZE * 2, ",7,1.5\n3,abc,2,0.25\n4,b,9,2");
+
+  record_file = make_text_file(long_line);
+  offsets[0] = 0;
+  offsets[1] = (uint64_t) (strchr(long_line, '\n') - long_line) + 1;
+  offsets[2] = offsets[1] + strlen("3,abc,2,0.25\n");
+
+  index_file = fopen(UT_INDEX_PATH, "wb");
+  TEST_ASSERT_NOT_NULL(index_file);
+  write_record_index(index_file, RECORD_INDEX_OFFSETS, FIELD_INTEGER, offsets, permutation, 3);
+  fclose(index_file);
+
+  TEST_ASSERT_TRUE(open_record_index(&index, UT_INDEX_PATH));
+  TEST_ASSERT_EQUAL_size_t(3, index->count);
+
+  TEST_ASSERT_TRUE(read_indexed_record(index, 0, record_file, &record));
+  TEST_ASSERT_EQUAL_size_t(3, record.id);
+  TEST_ASSERT_EQUAL_STRING("abc", record.string_field);
+
+  // The last line has no line terminator.
+  TEST_ASSERT_TRUE(read_indexed_record(index, 1, record_file, &record));
+  TEST_ASSERT_EQUAL_size_t(4, record.id);
+  TEST_ASSERT_EQUAL_INT(9, record.int_field);
+
+  TEST_ASSERT_TRUE(read_indexed_record(index, 2, record_file, &record));
+  TEST_ASSERT_EQUAL_size_t(5, record.id);
+  TEST_ASSERT_EQUAL_STRING(expected_string, record.string_field);
+  TEST_ASSERT_EQUAL_INT(7, record.int_field);
+  TEST_ASSERT_EQUAL_FLOAT(1.5f, record.float_field);
+
+  close_record_index(&index);
+  remove(UT_INDEX_PATH);
+  fclose(record_file);
+}
+
+/*---------------------------------------------------------------------------------------------------------------*/
+
+// PURPOSE: Joins two in-memory record files on their integer field, and checks the rows which have been written.
+static void join_records_test(FILE *left_file, FILE *right_file, JoinKind kind, const char *expected) {
+  SortOptions options;
+  char contents[1024];
+  size_t length, row_count;
+  const char *c;
+  FILE *out_file;
+
+  out_file = tmpfile();
+  TEST_ASSERT_NOT_NULL(out_file);
+
+  // Only the memory budget, the threads, the filter and the writer backend are read by the join.
+  memset(&options, 0, sizeof(options));
+  options.writer_backend = RECORD_WRITER_STDIO;
+  options.memory_budget = (size_t) 1 << 20;
+
+  row_count = join_records(left_file, right_file, out_file, BEST_INT_SORTING_THRESHOLD, FIELD_INTEGER, kind, &options);
+
+  rewind(out_file);
+  length = fread(contents, 1, sizeof(contents) - 1, out_file);
+  contents[length] = '\0';
+  TEST_ASSERT_EQUAL_STRING(expected, contents);
+
+  for (c = expected, length = 0; *c; ++c)
+    length += *c == '\n';
+
+  TEST_ASSERT_EQUAL_size_t(length, row_count);
+  fclose(out_file);
+}
+
+static void test_join_records(void) {
+  FILE *left_file, *right_file, *unsorted_right_file;
+
+  // The left keys are not sorted, and two left records share the key of a group of two right records. The right keys
+  // 0 and 3 match no left record, and the left keys 1 and 9 match no right record.
+  left_file = make_text_file("1,a,5,1\n2,b,2,2\n3,c,5,3\n4,d,9,4\n5,e,1,5\n");
+  right_file = make_text_file("10,r,0,0\n11,s,2,0.5\n12,t,3,0\n13,u,5,1\n14,v,5,2\n15,w,7,0\n");
+  unsorted_right_file = make_text_file("15,w,7,0\n13,u,5,1\n10,r,0,0\n14,v,5,2\n12,t,3,0\n11,s,2,0.5\n");
+
+  join_records_test(left_file, right_file, JOIN_INNER,
+                    "2,b,2,2.000000,11,s,2,0.500000\n"
+                    "1,a,5,1.000000,13,u,5,1.000000\n"
+                    "1,a,5,1.000000,14,v,5,2.000000\n"
+                    "3,c,5,3.000000,13,u,5,1.000000\n"
+                    "3,c,5,3.000000,14,v,5,2.000000\n");
+
+  join_records_test(left_file, unsorted_right_file, JOIN_LEFT,
+                    "5,e,1,5.000000,,,,\n"
+                    "2,b,2,2.000000,11,s,2,0.500000\n"
+                    "1,a,5,1.000000,13,u,5,1.000000\n"
+                    "1,a,5,1.000000,14,v,5,2.000000\n"
+                    "3,c,5,3.000000,13,u,5,1.000000\n"
+                    "3,c,5,3.000000,14,v,5,2.000000\n"
+                    "4,d,9,4.000000,,,,\n");
+
+  join_records_test(left_file, right_file, JOIN_ANTI, "5,e,1,5.000000\n4,d,9,4.000000\n");
+
+  // Joining with itself matches every record with itself.
+  join_records_test(right_file, unsorted_right_file, JOIN_ANTI, "");
+
+  fclose(unsorted_right_file);
+  fclose(right_file);
+  fclose(left_file);
+}
+
+/*---------------------------------------------------------------------------------------------------------------*/
+
+// PURPOSE: Sorts an in-memory record file with the string arena layout, and checks the sorted records.
+static void sort_records_arena_test(FILE *in_file, FieldId field_id, SortEngine engine, const char *expected) {
+  SortOptions options;
+  char contents[1024];
+  size_t length;
+  FILE *out_file;
+
+  out_file = tmpfile();
+  TEST_ASSERT_NOT_NULL(out_file);
+
+  init_sort_options(&options);
+  options.layout = LAYOUT_STRING_ARENA;
+  options.engine = engine;
+
+  rewind(in_file);
+  sort_records_with_options(in_file, out_file, BEST_STRING_SORTING_THRESHOLD, field_id, &options);
+
+  rewind(out_file);
+  length = fread(contents, 1, sizeof(contents) - 1, out_file);
+  contents[length] = '\0';
+  TEST_ASSERT_EQUAL_STRING(expected, contents);
+  fclose(out_file);
+}
+
+static void test_sort_records_arena(void) {
+  FILE *in_file;
+
+  // The strings share their inline prefix, are longer than the string field of a Record, or are empty.
+  in_file = make_text_file("0,abcdZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZ,3,0.5\n"
+                           "1,abcd,1,-1\n"
+                           "2,abcdAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAA,2,2.25\n"
+                           "3,,0,1\n"
+                           "4,abc,1,0\n");
+
+  sort_records_arena_test(in_file, FIELD_STRING, SORT_ENGINE_MERGE_BINARY_INSERTION,
+                          "3,,0,1.000000\n"
+                          "4,abc,1,0.000000\n"
+                          "1,abcd,1,-1.000000\n"
+                          "2,abcdAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAA,2,2.250000\n"
+                          "0,abcdZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZ,3,0.500000\n");
+
+  sort_records_arena_test(in_file, FIELD_STRING, SORT_ENGINE_PDQ,
+                          "3,,0,1.000000\n"
+                          "4,abc,1,0.000000\n"
+                          "1,abcd,1,-1.000000\n"
+                          "2,abcdAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAA,2,2.250000\n"
+                          "0,abcdZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZ,3,0.500000\n");
+
+  // The records with equal integer fields keep their order.
+  sort_records_arena_test(in_file, FIELD_INTEGER, SORT_ENGINE_MERGE_BINARY_INSERTION,
+                          "3,,0,1.000000\n"
+                          "1,abcd,1,-1.000000\n"
+                          "4,abc,1,0.000000\n"
+                          "2,abcdAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAA,2,2.250000\n"
+                          "0,abcdZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZ,3,0.500000\n");
+
+  sort_records_arena_test(in_file, FIELD_FLOAT, SORT_ENGINE_MULTIWAY_MERGE,
+                          "1,abcd,1,-1.000000\n"
+                          "4,abc,1,0.000000\n"
+                          "0,abcdZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZ,3,0.500000\n"
+                          "3,,0,1.000000\n"
+                          "2,abcdAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAA,2,2.250000\n");
+
+  fclose(in_file);
+}
+
+/*---------------------------------------------------------------------------------------------------------------*/
+
+static void test_counting_sort(void) {
+  Record *records;
+  int32_t keys[COUNTING_SORT_MIN_COUNT * 4];
+  uint32_t permutation[COUNTING_SORT_MIN_COUNT * 4];
+  size_t count, i;
+
+  count = COUNTING_SORT_MIN_COUNT * 4;
+  records = (Record *) malloc(sizeof(Record) * count);
+  TEST_ASSERT_NOT_NULL(records);
+
+  for (i = 0; i < count; ++i) {
+    records[i].id = i;
+    records[i].int_field = keys[i] = rand() % 100 - 50;
+  }
+
+  TEST_ASSERT_TRUE(counting_sort_records(&records, count));
+  TEST_ASSERT_TRUE(counting_sort_permutation(keys, count, permutation));
+
+  // The records with equal keys keep their input order (their ids are increasing).
+  for (i = 1; i < count; ++i) {
+    TEST_ASSERT_TRUE(records[i - 1].int_field < records[i].int_field ||
+                     (records[i - 1].int_field == records[i].int_field && records[i - 1].id < records[i].id));
+    TEST_ASSERT_EQUAL_UINT32(records[i].id, permutation[i]);
+  }
+
+  // A range larger than the number of records is left to the comparison sort.
+  keys[0] = INT32_MIN;
+  keys[1] = INT32_MAX;
+  TEST_ASSERT_FALSE(counting_sort_permutation(keys, count, permutation));
+  TEST_ASSERT_FALSE(counting_sort_permutation(keys + 2, COUNTING_SORT_MIN_COUNT - 1, permutation));
+
+  free(records);
+}
+
+/*---------------------------------------------------------------------------------------------------------------*/
+
+static void test_parallel_sample_sort(void) {
+  KeyedItem *array;
+  size_t count, i;
+
+  count = SAMPLE_SORT_MIN_COUNT * 4;
+  array = malloc(sizeof(KeyedItem) * count);
+  TEST_ASSERT_NOT_NULL(array);
+
+  // Few distinct keys, so that many equal items are split across the slices of the threads.
+  for (i = 0; i < count; i++) {
+    array[i].key = rand_int() % 10;
+    array[i].position = i;
+  }
+
+  parallel_sample_sort_threads(array, count, sizeof(KeyedItem), BEST_INT_SORTING_THRESHOLD, int_comparator, 4);
+
+  for (i = 1; i < count; i++) {
+    TEST_ASSERT_TRUE(array[i - 1].key <= array[i].key);
+    if (array[i - 1].key == array[i].key)
+      TEST_ASSERT_TRUE(array[i - 1].position < array[i].position);
+  }
+
+  free(array);
+}
+
+/*---------------------------------------------------------------------------------------------------------------*/
+
+static void multiway_merge_sort_test(size_t count, size_t pass_count) {
+  MultiwaySortPlan plan;
+  KeyedItem *array;
+  size_t i;
+
+  plan_multiway_merge_sort(count, sizeof(KeyedItem), &plan);
+  TEST_ASSERT_EQUAL_size_t(pass_count, plan.pass_count);
+
+  array = malloc(sizeof(KeyedItem) * count);
+  TEST_ASSERT_NOT_NULL(array);
+
+  for (i = 0; i < count; i++) {
+    array[i].key = rand_int() % 10;
+    array[i].position = i;
+  }
+
+  multiway_merge_sort(array, count, sizeof(KeyedItem), BEST_INT_SORTING_THRESHOLD, int_comparator);
+
+  for (i = 1; i < count; i++) {
+    TEST_ASSERT_TRUE(array[i - 1].key <= array[i].key);
+    if (array[i - 1].key == array[i].key)
+      TEST_ASSERT_TRUE(array[i - 1].position < array[i].position);
+  }
+
+  free(array);
+}
+
+// PURPOSE: Sorts with an odd and an even number of merge passes, since the blocks are sorted into different arrays.
+static void test_multiway_merge_sort(void) {
+  size_t block_items;
+
+  block_items = MULTIWAY_SORT_BLOCK_BYTES / sizeof(KeyedItem);
+
+  multiway_merge_sort_test(block_items, 1);
+  multiway_merge_sort_test(block_items * 3 + 1, 2);
+  multiway_merge_sort_test(block_items * (MULTIWAY_SORT_BLOCK_BYTES / MULTIWAY_SORT_RUN_HEAD_BYTES) + 1, 3);
+}
+
+/*---------------------------------------------------------------------------------------------------------------*/
+
+// PURPOSE: Sorts an array of keys with the pdqsort, and checks that it holds the same keys as the array sorted by the
+//          merge binary insertion sort (the order of the equal keys does not matter, since they are the same).
+static void pdq_sort_test(int *array, size_t count, size_t threshold) {
+  int *expected;
+
+  expected = malloc(sizeof(int) * count);
+  TEST_ASSERT_NOT_NULL(expected);
+  memcpy(expected, array, sizeof(int) * count);
+
+  pdq_sort(array, count, sizeof(int), threshold, int_comparator);
+  merge_binary_insertion_sort(expected, count, sizeof(int), BEST_INT_SORTING_THRESHOLD, int_comparator);
+  TEST_ASSERT_EQUAL_INT_ARRAY(expected, array, count);
+
+  free(expected);
+}
+
+// PURPOSE: Sorts the patterns which defeat a plain quicksort (sorted, reversed, organ-pipe, few distinct keys), and
+//          random keys, also with the smallest threshold.
+static void test_pdq_sort(void) {
+  int *array;
+  size_t count, i;
+
+  count = 100003;
+  array = malloc(sizeof(int) * count);
+  TEST_ASSERT_NOT_NULL(array);
+
+  for (i = 0; i < count; i++) array[i] = rand_int();
+  pdq_sort_test(array, count, BEST_INT_SORTING_THRESHOLD);
+
+  for (i = 0; i < count; i++) array[i] = rand_int();
+  pdq_sort_test(array, count, 0);
+
+  for (i = 0; i < count; i++) array[i] = (int) i;
+  pdq_sort_test(array, count, BEST_INT_SORTING_THRESHOLD);
+
+  for (i = 0; i < count; i++) array[i] = (int) (count - i);
+  pdq_sort_test(array, count, BEST_INT_SORTING_THRESHOLD);
+
+  for (i = 0; i < count; i++) array[i] = (int) (i < count / 2 ? i : count - i);
+  pdq_sort_test(array, count, BEST_INT_SORTING_THRESHOLD);
+
+  for (i = 0; i < count; i++) array[i] = rand_int() % 4;
+  pdq_sort_test(array, count, BEST_INT_SORTING_THRESHOLD);
+
+  pdq_sort_test(array, 1, BEST_INT_SORTING_THRESHOLD);
+  free(array);
+}
+
+/*---------------------------------------------------------------------------------------------------------------*/
+
+// PURPOSE: Checks that the branchless merge sorts give the same order as the (stable) merge binary insertion sort.
+// NOTE: The pairs are sorted both with the scalar merge and with the default merge (the bitonic one, on AVX2 hosts).
+static void test_branchless_merge_sort(void) {
+  int32_t (*pairs)[2], (*scalar_pairs)[2], (*expected_pairs)[2];
+  struct { float key; uint32_t payload; } *float_pairs, *expected_float_pairs;
+  Record *records, *expected_records;
+  size_t count, i;
+
+  count = 100003;
+  pairs = malloc(sizeof(*pairs) * count);
+  scalar_pairs = malloc(sizeof(*scalar_pairs) * count);
+  expected_pairs = malloc(sizeof(*expected_pairs) * count);
+  float_pairs = malloc(sizeof(*float_pairs) * count);
+  expected_float_pairs = malloc(sizeof(*expected_float_pairs) * count);
+  records = malloc(sizeof(Record) * count);
+  expected_records = malloc(sizeof(Record) * count);
+  TEST_ASSERT_TRUE(pairs && scalar_pairs && expected_pairs && float_pairs && expected_float_pairs && records &&
+                   expected_records);
+
+  for (i = 0; i < count; i++) {
+    pairs[i][0] = rand_int() - RANDOM_INT_MAX / 2;
+    pairs[i][1] = (int32_t) i;
+    records[i].id = i;
+    records[i].int_field = rand_int();
+    records[i].float_field = (float) (rand_int() % 100) / 4;
+  }
+
+  memcpy(scalar_pairs, pairs, sizeof(*pairs) * count);
+  memcpy(expected_pairs, pairs, sizeof(*pairs) * count);
+  memcpy(expected_records, records, sizeof(Record) * count);
+
+  branchless_merge_sort_int_pairs(pairs, count, BEST_INT_SORTING_THRESHOLD);
+  branchless_merge_sort_int_pairs_scalar(scalar_pairs, count, BEST_INT_SORTING_THRESHOLD);
+  merge_binary_insertion_sort(expected_pairs, count, sizeof(*pairs), BEST_INT_SORTING_THRESHOLD, int_comparator);
+  TEST_ASSERT_EQUAL_MEMORY(expected_pairs, pairs, sizeof(*pairs) * count);
+  TEST_ASSERT_EQUAL_MEMORY(expected_pairs, scalar_pairs, sizeof(*pairs) * count);
+
+  // The float pairs have many equal keys, whose payloads must keep their order.
+  for (i = 0; i < count; i++) {
+    float_pairs[i].key = (float) (rand_int() % 100) / 4;
+    float_pairs[i].payload = (uint32_t) i;
+  }
+
+  memcpy(expected_float_pairs, float_pairs, sizeof(*float_pairs) * count);
+
+  branchless_merge_sort_float_pairs_scalar(float_pairs, count, BEST_FLOAT_SORTING_THRESHOLD);
+  merge_binary_insertion_sort(expected_float_pairs, count, sizeof(*float_pairs), BEST_FLOAT_SORTING_THRESHOLD,
+                              float_comparator);
+  TEST_ASSERT_EQUAL_MEMORY(expected_float_pairs, float_pairs, sizeof(*float_pairs) * count);
+
+  branchless_merge_sort_records_by_float(records, count, 1);
+  merge_binary_insertion_sort(expected_records, count, sizeof(Record), 1, get_record_comparator(FIELD_FLOAT));
+
+  for (i = 0; i < count; i++)
+    TEST_ASSERT_EQUAL_size_t(expected_records[i].id, records[i].id);
+
+  free(pairs);
+  free(scalar_pairs);
+  free(expected_pairs);
+  free(float_pairs);
+  free(expected_float_pairs);
+  free(records);
+  free(expected_records);
+}
+
+/*---------------------------------------------------------------------------------------------------------------*/
+
+// PURPOSE: Merges two sorted runs of float pairs (whose payloads are their positions) with the bitonic merge, and checks
+//          that the result is the stable merge of the runs.
+static void bitonic_merge_test(size_t left_count, size_t right_count) {
+  struct {
+    float key;
+    uint32_t payload;
+  } *pairs, *merged;
+  size_t count, i;
+
+  count = left_count + right_count;
+  pairs = malloc(sizeof(*pairs) * (count + 1));
+  merged = malloc(sizeof(*merged) * (count + 1));
+  TEST_ASSERT_TRUE(pairs && merged);
+
+  for (i = 0; i < count; i++)
+    pairs[i].key = (float) (rand_int() % 64 - 32) / 2;
+
+  merge_binary_insertion_sort(pairs, left_count, sizeof(*pairs), 1, float_comparator);
+  merge_binary_insertion_sort(pairs + left_count, right_count, sizeof(*pairs), 1, float_comparator);
+
+  for (i = 0; i < count; i++)
+    pairs[i].payload = (uint32_t) i;
+
+  bitonic_merge_float_pairs(pairs, left_count, pairs + left_count, right_count, merged);
+  merge_binary_insertion_sort(pairs, count, sizeof(*pairs), 1, float_comparator);
+  TEST_ASSERT_EQUAL_MEMORY(pairs, merged, sizeof(*pairs) * count);
+
+  free(pairs);
+  free(merged);
+}
+
+static void test_bitonic_merge(void) {
+  bitonic_merge_test(1, 5);
+  bitonic_merge_test(3, 9);
+  bitonic_merge_test(4, 4);
+  bitonic_merge_test(1000, 37);
+  bitonic_merge_test(4097, 4099);
+}
+
+/*---------------------------------------------------------------------------------------------------------------*/
+
+// PURPOSE: Checks that the iterator returns the items in stable order, including the last (shorter) leaf run, and
+//          that it can be cleared before the end.
+static void test_sort_iterator(void) {
+  const KeyedItem *item, *previous;
+  KeyedItem *array;
+  SortIter *iter;
+  size_t count, returned, i;
+
+  count = 10007;
+  array = malloc(sizeof(KeyedItem) * count);
+  TEST_ASSERT_NOT_NULL(array);
+
+  for (i = 0; i < count; i++) {
+    array[i].key = rand_int() % 100;
+    array[i].position = i;
+  }
+
+  new_sort_iter(&iter, array, count, sizeof(KeyedItem), BEST_INT_SORTING_THRESHOLD, int_comparator);
+  previous = NULL;
+  returned = 0;
+
+  while ((item = (const KeyedItem *) sort_iter_next(iter))) {
+    if (previous) {
+      TEST_ASSERT_TRUE(previous->key <= item->key);
+      if (previous->key == item->key)
+        TEST_ASSERT_TRUE(previous->position < item->position);
+    }
+
+    previous = item;
+    returned++;
+  }
+
+  TEST_ASSERT_EQUAL(count, returned);
+  TEST_ASSERT_NULL(sort_iter_next(iter));
+  clear_sort_iter(&iter);
+  TEST_ASSERT_NULL(iter);
+
+  new_sort_iter(&iter, array, count, sizeof(KeyedItem), 0, int_comparator);
+  item = (const KeyedItem *) sort_iter_next(iter);
+  TEST_ASSERT_EQUAL(0, item->key);
+  clear_sort_iter(&iter);
+
+  new_sort_iter(&iter, NULL, 0, sizeof(KeyedItem), BEST_INT_SORTING_THRESHOLD, int_comparator);
+  TEST_ASSERT_NULL(sort_iter_next(iter));
+  clear_sort_iter(&iter);
+
+  free(array);
+}
+
+/*---------------------------------------------------------------------------------------------------------------*/
+
+static void test_record_output_aggregate(void) {
+  static const char *keys[] = {"abc", "abc", "abc", "abd", "b"};
+  RecordOutput *output;
+  SortOptions options;
+  Record record;
+  char contents[256];
+  size_t length, i;
+  FILE *file;
+
+  file = tmpfile();
+  TEST_ASSERT_NOT_NULL(file);
+
+  // Only the writer backend and the aggregation are read by the output.
+  memset(&options, 0, sizeof(options));
+  options.writer_backend = RECORD_WRITER_STDIO;
+  options.aggregate = 1;
+  new_record_output(&output, file, FIELD_STRING, &options);
+
+  for (i = 0; i < sizeof(keys) / sizeof(keys[0]); i++) {
+    record.id = i;
+    strcpy(record.string_field, keys[i]);
+    record.int_field = (int) i - 1;
+    record.float_field = (float) i;
+    write_record_output(output, &record);
+  }
+
+  clear_record_output(&output);
+
+  rewind(file);
+  length = fread(contents, 1, sizeof(contents) - 1, file);
+  contents[length] = '\0';
+  TEST_ASSERT_EQUAL_STRING("abc,3,0,1.000000\nabd,1,2,3.000000\nb,1,3,4.000000\n", contents);
+
+  fclose(file);
+}
+
+/*---------------------------------------------------------------------------------------------------------------*/
+
+static void test_record_schema(void) {
+  static const char *lines[] = {"3,bcd,0.5\n", "1,abcdefgh,-2\r\n", "2,abc,1.25"};
+  RecordSchema *schema;
+  unsigned char rows[3][20];
+  char buffer[128];
+  size_t i;
+
+  new_record_schema(&schema);
+  TEST_ASSERT_EQUAL_INT(1, add_schema_columns(schema, "id:int,name:string:8,score:float\n"));
+  TEST_ASSERT_EQUAL_INT(0, set_schema_key(schema, "missing"));
+  TEST_ASSERT_EQUAL_INT(1, set_schema_key(schema, "name"));
+
+  // The key comes first, then the numeric columns (aligned), then the other strings.
+  TEST_ASSERT_EQUAL_UINT(3, schema->column_count);
+  TEST_ASSERT_EQUAL_UINT(0, schema->columns[1].offset);
+  TEST_ASSERT_EQUAL_UINT(12, schema->columns[0].offset);
+  TEST_ASSERT_EQUAL_UINT(16, schema->columns[2].offset);
+  TEST_ASSERT_EQUAL_UINT(sizeof(rows[0]), schema->row_size);
+
+  for (i = 0; i < 3; i++)
+    TEST_ASSERT_EQUAL_INT(1, parse_schema_row(schema, lines[i], strlen(lines[i]), rows[i]));
+
+  TEST_ASSERT_EQUAL_INT(0, parse_schema_row(schema, "4,abcdefghi,1", strlen("4,abcdefghi,1"), rows[0]));
+  TEST_ASSERT_EQUAL_INT(0, parse_schema_row(schema, "4,abc", strlen("4,abc"), rows[0]));
+  TEST_ASSERT_EQUAL_INT(0, parse_schema_row(schema, "4,abc,1,2", strlen("4,abc,1,2"), rows[0]));
+  TEST_ASSERT_EQUAL_INT(0, parse_schema_row(schema, "x,abc,1", strlen("x,abc,1"), rows[0]));
+
+  // The rows which failed to parse have been overwritten: parse the first one again.
+  TEST_ASSERT_EQUAL_INT(1, parse_schema_row(schema, lines[0], strlen(lines[0]), rows[0]));
+  merge_binary_insertion_sort(rows, 3, schema->row_size, 0, schema->compare);
+
+  format_schema_row(schema, rows[0], buffer, sizeof(buffer));
+  TEST_ASSERT_EQUAL_STRING("2,abc,1.250000\n", buffer);
+  format_schema_row(schema, rows[1], buffer, sizeof(buffer));
+  TEST_ASSERT_EQUAL_STRING("1,abcdefgh,-2.000000\n", buffer);
+  format_schema_row(schema, rows[2], buffer, sizeof(buffer));
+  TEST_ASSERT_EQUAL_STRING("3,bcd,0.500000\n", buffer);
+
+  clear_record_schema(&schema);
+
+  new_record_schema(&schema);
+  TEST_ASSERT_EQUAL_INT(0, add_schema_columns(schema, "id:int,name:string"));
+  clear_record_schema(&schema);
+}
+
+/*---------------------------------------------------------------------------------------------------------------*/
+
+static void test_string_arena(void) {
+  static const char *strings[] = {"", "a", "abc", "abcd", "abcde", "abcdefghijklmnopqrstuvwxyz0123456789", "abd", "b",
+                                  "abcdefghijklmnopqrstuvwxyz0123456789!", "\xc3\xa9t\xc3\xa9"};
+  StringHandle handles[sizeof(strings) / sizeof(strings[0])];
+  StringArena *arena;
+  size_t count, i, j;
+  int expected;
+
+  count = sizeof(strings) / sizeof(strings[0]);
+
+  // The arena starts tiny, so that it grows while the strings are stored.
+  new_string_arena(&arena, 1);
+
+  for (i = 0; i < count; i++)
+    store_arena_string(arena, strings[i], strlen(strings[i]), &handles[i]);
+
+  for (i = 0; i < count; i++) {
+    TEST_ASSERT_EQUAL_UINT(strlen(strings[i]), handles[i].length);
+    TEST_ASSERT_TRUE(!memcmp(strings[i], get_arena_string(arena, &handles[i]), handles[i].length));
+
+    for (j = 0; j < count; j++) {
+      expected = strcmp(strings[i], strings[j]);
+      expected = (expected > 0) - (expected < 0);
+      TEST_ASSERT_EQUAL_INT(expected, (compare_arena_strings(arena, &handles[i], &handles[j]) > 0) -
+                                      (compare_arena_strings(arena, &handles[i], &handles[j]) < 0));
+    }
+  }
+
+  clear_string_arena(&arena);
+}
+
+/*---------------------------------------------------------------------------------------------------------------*/
+
 void setUp(void) {}
 
 void tearDown(void) {}
@@ -233,5 +1153,64 @@ int main(void) {
   RUN_TEST(test_string_array_100000);
   RUN_TEST(test_string_array_1000000);
 
+  printf("TESTING STABILITY.....\n");
+  RUN_TEST(test_stability_100);
+  RUN_TEST(test_stability_100000);
+
+  printf("TESTING RUN MERGER.....\n");
+  RUN_TEST(test_run_merger_1);
+  RUN_TEST(test_run_merger_1000);
+  RUN_TEST(test_run_merger_100000);
+
+  printf("TESTING FIELD PARSERS.....\n");
+  RUN_TEST(test_parse_integers);
+  RUN_TEST(test_parse_floats);
+
+  printf("TESTING CSV SCANNER.....\n");
+  RUN_TEST(test_csv_scanner);
+
+  printf("TESTING RECORD FILTER.....\n");
+  RUN_TEST(test_record_filter);
+
+  printf("TESTING COUNTING SORT.....\n");
+  RUN_TEST(test_counting_sort);
+
+  printf("TESTING PARALLEL SAMPLE SORT.....\n");
+  RUN_TEST(test_parallel_sample_sort);
+
+  printf("TESTING MULTIWAY MERGE SORT.....\n");
+  RUN_TEST(test_multiway_merge_sort);
+
+  printf("TESTING PDQ SORT.....\n");
+  RUN_TEST(test_pdq_sort);
+
+  printf("TESTING BRANCHLESS MERGE SORT.....\n");
+  RUN_TEST(test_branchless_merge_sort);
+
+  printf("TESTING BITONIC MERGE.....\n");
+  RUN_TEST(test_bitonic_merge);
+
+  printf("TESTING SORT ITERATOR.....\n");
+  RUN_TEST(test_sort_iterator);
+
+  printf("TESTING RECORD OUTPUT.....\n");
+  RUN_TEST(test_record_output_aggregate);
+
+  printf("TESTING RECORD SCHEMA.....\n");
+  RUN_TEST(test_record_schema);
+
+  printf("TESTING STRING ARENA.....\n");
+  RUN_TEST(test_string_arena);
+  RUN_TEST(test_sort_records_arena);
+
+  printf("TESTING RECORDS VERIFIER.....\n");
+  RUN_TEST(test_summarize_records);
+
+  printf("TESTING RECORD INDEX.....\n");
+  RUN_TEST(test_read_indexed_record);
+
+  printf("TESTING RECORDS JOIN.....\n");
+  RUN_TEST(test_join_records);
+
   return UNITY_END();
 }